@@ -0,0 +1,107 @@
+// In-situ analysis of a simulation, as an alternative to writing full snapshots.
+// Observers are registered with the number of steps between their observations, and the pipeline
+// is called after every step of the integrator:
+//
+//     AnalysisPipeline<body_type> pipeline("analysis.h5");
+//     pipeline.addObserver(std::make_unique<EnergyObserver<body_type>>(), 10);
+//     pipeline.addObserver(std::make_unique<LagrangianRadiiObserver<body_type>>(), 100);
+//     for(std::uint64_t step{1}; step <= num_steps; ++step){
+//         integrator.timeStep(star_system, force_computer, time_step);
+//         pipeline.observe(step, step * time_step, star_system, force_computer);
+//     }
+//
+// Every observer writes a time series with a row of a few numbers per observation, see
+// TimeSeriesWriter, instead of the positions, velocities and masses of every body. The observers
+// that are due run one after the other, and each spreads its reductions over the threads of the
+// pipeline.
+#ifndef AnalysisPipeline_H
+#define AnalysisPipeline_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "observer_base.h"
+#include "../../body/include/star_system.h"
+#include "../../force/include/force_computer_base.h"
+#include "../../io/include/time_series_writer.h"
+
+template<typename BodyType> class AnalysisPipeline{
+
+    public:
+        AnalysisPipeline(
+            const std::string& output_path,
+            const std::size_t num_threads = std::thread::hardware_concurrency(),
+            const std::size_t rows_per_write = 64
+        ):
+            _writer(output_path, rows_per_write),
+            _num_threads(num_threads == 0 ? 1 : num_threads)
+        {}
+
+        AnalysisPipeline(const AnalysisPipeline&) = delete;
+        AnalysisPipeline(AnalysisPipeline&&) = delete;
+        AnalysisPipeline& operator=(const AnalysisPipeline&) = delete;
+        AnalysisPipeline& operator=(AnalysisPipeline&&) = delete;
+
+        std::size_t numThreads() const{ return _num_threads; }
+        std::size_t numObservers() const{ return _observers.size(); }
+
+        // Run the observer at every step that is a multiple of every, including step 0.
+        void addObserver(std::unique_ptr<ObserverBase<BodyType>> observer, const std::size_t every = 1){
+            if(every == 0){
+                throw std::invalid_argument("The number of steps between observations must be positive.");
+            }
+            const std::vector<std::string> columns = observer->columns();
+            const std::size_t series = _writer.add_series(observer->name(), columns);
+            _observers.push_back(RegisteredObserver{std::move(observer), every, series, std::vector<double>(columns.size())});
+        }
+
+        // Run the observers that are due at this step and append their rows to the time series.
+        void observe(
+            const std::uint64_t step,
+            const double time,
+            const StarSystem<BodyType>& star_system,
+            const ForceComputerBase<BodyType>& force_computer)
+        {
+            for(RegisteredObserver& registered: _observers){
+                if(step % registered.every == 0){
+                    registered.observer->observe(star_system, force_computer, _num_threads, registered.row.data());
+                    _writer.append(registered.series, step, time, registered.row.data());
+                }
+            }
+        }
+
+        // Whether observe writes to the file at this step, or only buffers the rows of the
+        // observers that are due.
+        bool writesAt(const std::uint64_t step) const{
+            for(const RegisteredObserver& registered: _observers){
+                if(step % registered.every == 0 && _writer.append_writes(registered.series)){
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Write all buffered rows to the file.
+        herr_t flush(){
+            return _writer.flush();
+        }
+
+    private:
+        struct RegisteredObserver{
+            std::unique_ptr<ObserverBase<BodyType>> observer;
+            std::size_t every;
+            std::size_t series;
+            std::vector<double> row;
+        };
+
+        TimeSeriesWriter _writer;
+        std::size_t _num_threads;
+        std::vector<RegisteredObserver> _observers;
+};
+
+#endif
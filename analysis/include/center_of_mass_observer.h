@@ -0,0 +1,86 @@
+// Position and velocity of the center of mass of the star system.
+#ifndef CenterOfMassObserver_H
+#define CenterOfMassObserver_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "observer_base.h"
+#include "../../parallel/include/block_parallel.h"
+#include "../../vector/include/vector_traits.h"
+
+// Name of component d of a vector in the columns of the observers.
+inline std::string componentName(const std::size_t d){
+    return std::string(1, static_cast<char>('x' + d));
+}
+
+
+// The center of mass of a star system, followed by the velocity of the center of mass.
+// The center of a star system without mass is the origin.
+template<typename BodyType> std::array<double, 2*vector_traits<typename BodyType::vector_type>::dimension> centerOfMass(
+    const StarSystem<BodyType>& star_system,
+    const std::size_t num_threads)
+{
+    using numeric_type = typename BodyType::numeric_type;
+    constexpr std::size_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+
+    // The total mass, the mass weighted positions and the mass weighted velocities.
+    std::array<double, 2*dimension + 1> moments;
+    blockSum(star_system.size(), moments.size(), [&star_system](const std::size_t begin, const std::size_t end, double* sums){
+        const numeric_type* masses = star_system.masses().data();
+        for(std::size_t b{begin}; b < end; ++b){
+            sums[0] += masses[b];
+        }
+        for(std::size_t d{0}; d < dimension; ++d){
+            const numeric_type* positions = star_system.positions().data(d);
+            const numeric_type* velocities = star_system.velocities().data(d);
+            for(std::size_t b{begin}; b < end; ++b){
+                sums[1 + d] += static_cast<double>(masses[b]) * positions[b];
+                sums[1 + dimension + d] += static_cast<double>(masses[b]) * velocities[b];
+            }
+        }
+    }, moments.data(), num_threads);
+
+    std::array<double, 2*dimension> center{};
+    if(moments[0] != 0.){
+        for(std::size_t c{0}; c < center.size(); ++c){
+            center[c] = moments[1 + c] / moments[0];
+        }
+    }
+    return center;
+}
+
+
+template<typename BodyType> class CenterOfMassObserver: public ObserverBase<BodyType>{
+
+    public:
+        static constexpr std::size_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+
+        virtual std::string name() const override{ return "center_of_mass"; }
+
+        virtual std::vector<std::string> columns() const override{
+            std::vector<std::string> names;
+            for(std::size_t d{0}; d < dimension; ++d){
+                names.push_back("position_" + componentName(d));
+            }
+            for(std::size_t d{0}; d < dimension; ++d){
+                names.push_back("velocity_" + componentName(d));
+            }
+            return names;
+        }
+
+        virtual void observe(
+            const StarSystem<BodyType>& star_system,
+            const ForceComputerBase<BodyType>&,
+            const std::size_t num_threads,
+            double* row) override
+        {
+            const auto center = centerOfMass(star_system, num_threads);
+            std::copy(center.begin(), center.end(), row);
+        }
+};
+
+#endif
@@ -0,0 +1,51 @@
+// Kinetic, potential and total energy of the star system.
+// The potential energy is that of the last force computation which included it, so it is only
+// up to date with integrators that compute the potential at the end of every step, like Leapfrog
+// and DormandPrince.
+#ifndef EnergyObserver_H
+#define EnergyObserver_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "observer_base.h"
+#include "../../parallel/include/block_parallel.h"
+#include "../../vector/include/vector_traits.h"
+
+template<typename BodyType> class EnergyObserver: public ObserverBase<BodyType>{
+
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+        static constexpr std::size_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+
+        virtual std::string name() const override{ return "energy"; }
+
+        virtual std::vector<std::string> columns() const override{
+            return {"kinetic_energy", "potential_energy", "total_energy"};
+        }
+
+        virtual void observe(
+            const StarSystem<BodyType>& star_system,
+            const ForceComputerBase<BodyType>& force_computer,
+            const std::size_t num_threads,
+            double* row) override
+        {
+            double kinetic_energy;
+            blockSum(star_system.size(), 1, [&star_system](const std::size_t begin, const std::size_t end, double* sum){
+                const numeric_type* masses = star_system.masses().data();
+                for(std::size_t d{0}; d < dimension; ++d){
+                    const numeric_type* velocities = star_system.velocities().data(d);
+                    for(std::size_t b{begin}; b < end; ++b){
+                        *sum += static_cast<double>(masses[b]) * velocities[b] * velocities[b];
+                    }
+                }
+            }, &kinetic_energy, num_threads);
+
+            row[0] = 0.5 * kinetic_energy;
+            row[1] = force_computer.potentialEnergy();
+            row[2] = row[0] + row[1];
+        }
+};
+
+#endif
@@ -0,0 +1,100 @@
+// Lagrangian radii: the radii around the center of mass of the star system that enclose given
+// fractions of its mass. The distances of the bodies are computed in parallel and then sorted,
+// so an observation costs O(N log N).
+#ifndef LagrangianRadiiObserver_H
+#define LagrangianRadiiObserver_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "center_of_mass_observer.h"
+#include "observer_base.h"
+#include "../../parallel/include/block_parallel.h"
+#include "../../vector/include/vector_traits.h"
+
+template<typename BodyType> class LagrangianRadiiObserver: public ObserverBase<BodyType>{
+
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+        static constexpr std::size_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+
+        explicit LagrangianRadiiObserver(const std::vector<double>& mass_fractions = {0.1, 0.25, 0.5, 0.75, 0.9}):
+            _mass_fractions(mass_fractions)
+        {
+            for(const double fraction: mass_fractions){
+                if(!(fraction > 0) || fraction > 1){
+                    throw std::invalid_argument("The mass fractions of Lagrangian radii must be in (0, 1].");
+                }
+            }
+            if(mass_fractions.empty()){
+                throw std::invalid_argument("Lagrangian radii need at least one mass fraction.");
+            }
+        }
+
+        const std::vector<double>& massFractions() const{ return _mass_fractions; }
+
+        virtual std::string name() const override{ return "lagrangian_radii"; }
+
+        virtual std::vector<std::string> columns() const override{
+            std::vector<std::string> names;
+            for(const double fraction: _mass_fractions){
+                std::ostringstream name;
+                name << "r(" << fraction << ")";
+                names.push_back(name.str());
+            }
+            return names;
+        }
+
+        // The radius of a fraction is the distance of the closest body at which the enclosed mass
+        // reaches the fraction of the total mass.
+        virtual void observe(
+            const StarSystem<BodyType>& star_system,
+            const ForceComputerBase<BodyType>&,
+            const std::size_t num_threads,
+            double* row) override
+        {
+            const auto center = centerOfMass(star_system, num_threads);
+            _bodies.resize(star_system.size());
+            blockFor(star_system.size(), [&](const std::size_t begin, const std::size_t end){
+                const numeric_type* masses = star_system.masses().data();
+                for(std::size_t b{begin}; b < end; ++b){
+                    double squared_radius = 0.;
+                    for(std::size_t d{0}; d < dimension; ++d){
+                        const double offset = star_system.positions().data(d)[b] - center[d];
+                        squared_radius += offset * offset;
+                    }
+                    _bodies[b] = {squared_radius, masses[b]};
+                }
+            }, num_threads);
+            std::sort(_bodies.begin(), _bodies.end());
+
+            // The masses are replaced by the mass enclosed by each body.
+            double enclosed_mass = 0.;
+            for(auto& body: _bodies){
+                enclosed_mass += body.second;
+                body.second = enclosed_mass;
+            }
+
+            for(std::size_t f{0}; f < _mass_fractions.size(); ++f){
+                const double enclosed_target = _mass_fractions[f] * enclosed_mass;
+                const auto enclosing = std::lower_bound(_bodies.begin(), _bodies.end(), enclosed_target, [](const std::pair<double, double>& body, const double target){
+                    return body.second < target;
+                });
+                row[f] = (enclosing == _bodies.end() ? (_bodies.empty() ? 0. : std::sqrt(_bodies.back().first)) : std::sqrt(enclosing->first));
+            }
+        }
+
+    private:
+        std::vector<double> _mass_fractions;
+
+        // Squared distance from the center and mass of every body, reused between observations.
+        std::vector<std::pair<double, double>> _bodies;
+};
+
+#endif
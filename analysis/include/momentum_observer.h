@@ -0,0 +1,69 @@
+// Total linear and angular momentum of the star system, the angular momentum about the origin.
+// In 2D the angular momentum is the single component perpendicular to the plane.
+#ifndef MomentumObserver_H
+#define MomentumObserver_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "center_of_mass_observer.h"
+#include "observer_base.h"
+#include "../../parallel/include/block_parallel.h"
+#include "../../vector/include/vector_traits.h"
+
+template<typename BodyType> class MomentumObserver: public ObserverBase<BodyType>{
+
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+        static constexpr std::size_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+        static constexpr std::size_t angular_dimension = (dimension == 3 ? 3 : 1);
+
+        virtual std::string name() const override{ return "momentum"; }
+
+        virtual std::vector<std::string> columns() const override{
+            std::vector<std::string> names;
+            for(std::size_t d{0}; d < dimension; ++d){
+                names.push_back("momentum_" + componentName(d));
+            }
+            for(std::size_t d{3 - angular_dimension}; d < 3; ++d){
+                names.push_back("angular_momentum_" + componentName(d));
+            }
+            return names;
+        }
+
+        virtual void observe(
+            const StarSystem<BodyType>& star_system,
+            const ForceComputerBase<BodyType>&,
+            const std::size_t num_threads,
+            double* row) override
+        {
+            blockSum(star_system.size(), dimension + angular_dimension, [&star_system](const std::size_t begin, const std::size_t end, double* sums){
+                const numeric_type* masses = star_system.masses().data();
+                for(std::size_t d{0}; d < dimension; ++d){
+                    const numeric_type* velocities = star_system.velocities().data(d);
+                    for(std::size_t b{begin}; b < end; ++b){
+                        sums[d] += static_cast<double>(masses[b]) * velocities[b];
+                    }
+                }
+
+                // Component k of the angular momentum is the cross product of the components i
+                // and j that follow it cyclically. In 2D only the z component, with i = x and
+                // j = y, is computed.
+                for(std::size_t k{3 - angular_dimension}; k < 3; ++k){
+                    const std::size_t i = (k + 1) % 3;
+                    const std::size_t j = (k + 2) % 3;
+                    const numeric_type* x_i = star_system.positions().data(i);
+                    const numeric_type* x_j = star_system.positions().data(j);
+                    const numeric_type* v_i = star_system.velocities().data(i);
+                    const numeric_type* v_j = star_system.velocities().data(j);
+                    double& sum = sums[dimension + k - (3 - angular_dimension)];
+                    for(std::size_t b{begin}; b < end; ++b){
+                        sum += static_cast<double>(masses[b]) * (static_cast<double>(x_i[b]) * v_j[b] - static_cast<double>(x_j[b]) * v_i[b]);
+                    }
+                }
+            }, row, num_threads);
+        }
+};
+
+#endif
@@ -0,0 +1,36 @@
+// Interface for in-situ analysis of a simulation.
+// An observer reduces the state of the star system to a few numbers, such as the energy or the
+// radii enclosing fractions of the mass, which the AnalysisPipeline writes as a time series. The
+// numbers are the columns of a row that is filled by observe, and are always stored as doubles.
+#ifndef ObserverBase_H
+#define ObserverBase_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "../../body/include/star_system.h"
+#include "../../force/include/force_computer_base.h"
+
+template<typename BodyType> class ObserverBase{
+
+    public:
+        virtual ~ObserverBase() = default;
+
+        // Name of the time series of the observer, which should be unique within a pipeline.
+        virtual std::string name() const = 0;
+
+        // Names of the numbers in every row.
+        virtual std::vector<std::string> columns() const = 0;
+
+        // Reduce the star system to a row of columns().size() numbers, using up to num_threads
+        // threads. The force computer holds the forces and potential of the last force
+        // computation of the integrator.
+        virtual void observe(
+            const StarSystem<BodyType>& star_system,
+            const ForceComputerBase<BodyType>& force_computer,
+            const std::size_t num_threads,
+            double* row) = 0;
+};
+
+#endif
@@ -0,0 +1,77 @@
+// Mass in spherical shells around the center of mass of the star system.
+// The shells are bounded by the given increasing radii: the first shell holds the bodies within
+// the first radius, shell i the bodies between radius i-1 and radius i. Bodies beyond the last
+// radius are not counted. The density profile follows by dividing by the volumes of the shells.
+#ifndef RadialProfileObserver_H
+#define RadialProfileObserver_H
+
+#include <algorithm>
+#include <cstddef>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "center_of_mass_observer.h"
+#include "observer_base.h"
+#include "../../parallel/include/block_parallel.h"
+#include "../../vector/include/vector_traits.h"
+
+template<typename BodyType> class RadialProfileObserver: public ObserverBase<BodyType>{
+
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+        static constexpr std::size_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+
+        explicit RadialProfileObserver(const std::vector<double>& radii): _radii(radii){
+            if(radii.empty() || !(radii.front() > 0) || !std::is_sorted(radii.begin(), radii.end()) || std::adjacent_find(radii.begin(), radii.end()) != radii.end()){
+                throw std::invalid_argument("The radii of the shells of a radial profile must be positive and strictly increasing.");
+            }
+            for(const double radius: radii){
+                _squared_radii.push_back(radius * radius);
+            }
+        }
+
+        const std::vector<double>& radii() const{ return _radii; }
+
+        virtual std::string name() const override{ return "radial_profile"; }
+
+        virtual std::vector<std::string> columns() const override{
+            std::vector<std::string> names;
+            for(std::size_t s{0}; s < _radii.size(); ++s){
+                std::ostringstream name;
+                name << "mass(" << (s == 0 ? 0. : _radii[s - 1]) << "<=r<" << _radii[s] << ")";
+                names.push_back(name.str());
+            }
+            return names;
+        }
+
+        virtual void observe(
+            const StarSystem<BodyType>& star_system,
+            const ForceComputerBase<BodyType>&,
+            const std::size_t num_threads,
+            double* row) override
+        {
+            const auto center = centerOfMass(star_system, num_threads);
+            blockSum(star_system.size(), _radii.size(), [&](const std::size_t begin, const std::size_t end, double* shell_masses){
+                const numeric_type* masses = star_system.masses().data();
+                for(std::size_t b{begin}; b < end; ++b){
+                    double squared_radius = 0.;
+                    for(std::size_t d{0}; d < dimension; ++d){
+                        const double offset = star_system.positions().data(d)[b] - center[d];
+                        squared_radius += offset * offset;
+                    }
+                    const std::size_t shell = std::upper_bound(_squared_radii.begin(), _squared_radii.end(), squared_radius) - _squared_radii.begin();
+                    if(shell < _radii.size()){
+                        shell_masses[shell] += masses[b];
+                    }
+                }
+            }, row, num_threads);
+        }
+
+    private:
+        std::vector<double> _radii;
+        std::vector<double> _squared_radii;
+};
+
+#endif
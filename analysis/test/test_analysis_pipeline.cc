@@ -0,0 +1,245 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "hdf5.h"
+
+#include "../include/analysis_pipeline.h"
+#include "../include/center_of_mass_observer.h"
+#include "../include/energy_observer.h"
+#include "../include/lagrangian_radii_observer.h"
+#include "../include/momentum_observer.h"
+#include "../include/radial_profile_observer.h"
+#include "../../integration/include/leapfrog.h"
+#include "../../force/include/direct_sum_force_computer.h"
+#include "../../force/include/softening_kernel.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector2D.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+const std::string output_path = "test_analysis_pipeline.h5";
+
+
+// Bodies of equal mass distributed uniformly in a ball of radius 1 around the given center, with
+// random velocities.
+StarSystem<body_type> make_uniform_ball(const std::size_t num_bodies, const vector_type& center){
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(-1., 1.);
+    std::vector<body_type> bodies;
+    while(bodies.size() < num_bodies){
+        const vector_type pos(uniform(random_device), uniform(random_device), uniform(random_device));
+        const vector_type vel = 0.3 * vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        if(square(pos) <= 1.){
+            bodies.push_back(body_type(center + pos, vel, 1. / num_bodies));
+        }
+    }
+    return StarSystem<body_type>(bodies);
+}
+
+
+std::vector<double> observe(ObserverBase<body_type>& observer, const StarSystem<body_type>& star_system, const ForceComputerBase<body_type>& force_computer, const std::size_t num_threads){
+    std::vector<double> row(observer.columns().size());
+    observer.observe(star_system, force_computer, num_threads, row.data());
+    return row;
+}
+
+
+void check_close(const std::string& description, const double value, const double expected, const double tolerance){
+    if(!(std::abs(value - expected) <= tolerance)){
+        throw std::runtime_error(description + " is " + std::to_string(value) + " instead of " + std::to_string(expected) + ".\n");
+    }
+}
+
+
+// The reductions of a uniform ball are known, and must not depend on the number of threads.
+void check_observers(){
+    const vector_type center(2., -1., 0.5);
+    StarSystem<body_type> star_system = make_uniform_ball(20000, center);
+    DirectSumForceComputer<body_type> force_computer(1.);
+
+    std::vector<std::unique_ptr<ObserverBase<body_type>>> observers;
+    observers.push_back(std::make_unique<EnergyObserver<body_type>>());
+    observers.push_back(std::make_unique<MomentumObserver<body_type>>());
+    observers.push_back(std::make_unique<CenterOfMassObserver<body_type>>());
+    observers.push_back(std::make_unique<RadialProfileObserver<body_type>>(std::vector<double>{0.5, 1., 2.}));
+    observers.push_back(std::make_unique<LagrangianRadiiObserver<body_type>>());
+    for(const auto& observer: observers){
+        const std::vector<double> serial = observe(*observer, star_system, force_computer, 1);
+        const std::vector<double> parallel = observe(*observer, star_system, force_computer, 8);
+        if(std::memcmp(serial.data(), parallel.data(), serial.size() * sizeof(double)) != 0){
+            throw std::runtime_error("The " + observer->name() + " observer depends on the number of threads.\n");
+        }
+    }
+
+    const std::vector<double> energy = observe(*observers[0], star_system, force_computer, 8);
+    check_close("The kinetic energy", energy[0], star_system.kineticEnergy(), 1e-12 * star_system.kineticEnergy());
+
+    const std::vector<double> center_of_mass = observe(*observers[2], star_system, force_computer, 8);
+    check_close("The x coordinate of the center of mass", center_of_mass[0], center.x(), 0.02);
+    check_close("The y coordinate of the center of mass", center_of_mass[1], center.y(), 0.02);
+    check_close("The z coordinate of the center of mass", center_of_mass[2], center.z(), 0.02);
+
+    // A ball holds an eighth of its mass within half its radius. Only the offset of the center of
+    // mass from the center of the ball moves a little mass beyond its radius.
+    const std::vector<double> profile = observe(*observers[3], star_system, force_computer, 8);
+    check_close("The mass within half the radius", profile[0], 0.125, 0.01);
+    check_close("The mass in the outer half of the ball", profile[1], 0.875, 0.01);
+    check_close("The mass beyond the ball", profile[2], 0., 0.01);
+
+    // The mass within radius r is r^3.
+    const std::vector<double> radii = observe(*observers[4], star_system, force_computer, 8);
+    const auto& lagrangian_radii = static_cast<LagrangianRadiiObserver<body_type>&>(*observers[4]);
+    for(std::size_t f{0}; f < radii.size(); ++f){
+        check_close("The Lagrangian radius of mass fraction " + std::to_string(lagrangian_radii.massFractions()[f]), radii[f], std::cbrt(lagrangian_radii.massFractions()[f]), 0.02);
+    }
+}
+
+
+// In 2D the angular momentum only has a z component.
+void check_2d_momentum(){
+    using body_2d_type = Body<Vector2D<numeric_type>>;
+    std::vector<body_2d_type> bodies{
+        body_2d_type(Vector2D<numeric_type>(1., 0.), Vector2D<numeric_type>(0., 2.), 3.),
+        body_2d_type(Vector2D<numeric_type>(0., -1.), Vector2D<numeric_type>(1., 0.), 1.)
+    };
+    StarSystem<body_2d_type> star_system(bodies);
+    DirectSumForceComputer<body_2d_type> force_computer(1.);
+    MomentumObserver<body_2d_type> observer;
+    if(observer.columns().size() != 3 || observer.columns()[2] != "angular_momentum_z"){
+        throw std::runtime_error("The 2D momentum observer has the wrong columns.\n");
+    }
+    double row[3];
+    observer.observe(star_system, force_computer, 2, row);
+    check_close("The 2D momentum along x", row[0], 1., 0.);
+    check_close("The 2D momentum along y", row[1], 6., 0.);
+    check_close("The 2D angular momentum", row[2], 3. * 1. * 2. + 1. * 1. * 1., 0.);
+}
+
+
+std::vector<hsize_t> dataset_dims(const hid_t file_id, const std::string& name){
+    hid_t dset_id = H5Dopen(file_id, name.c_str(), H5P_DEFAULT);
+    hid_t space_id = H5Dget_space(dset_id);
+    std::vector<hsize_t> dims(H5Sget_simple_extent_ndims(space_id));
+    H5Sget_simple_extent_dims(space_id, dims.data(), NULL);
+    H5Sclose(space_id);
+    H5Dclose(dset_id);
+    return dims;
+}
+
+
+// Run a simulation with the pipeline attached, check the time series in the file, and compare
+// its size with snapshots at every observation of the energy.
+void check_pipeline(){
+    constexpr std::size_t num_bodies = 512;
+    constexpr std::size_t num_steps = 100;
+    constexpr numeric_type time_step = 1e-3;
+    StarSystem<body_type> star_system = make_uniform_ball(num_bodies, vector_type(0., 0., 0.));
+    DirectSumForceComputer<body_type> force_computer(1.);
+    force_computer.setSoftening(SofteningKernel<numeric_type>::plummer(0.05));
+    Leapfrog<body_type> integrator;
+
+    std::vector<double> first_momentum;
+    std::vector<double> first_energy;
+    {
+        AnalysisPipeline<body_type> pipeline(output_path, 4, 16);
+        pipeline.addObserver(std::make_unique<EnergyObserver<body_type>>());
+        pipeline.addObserver(std::make_unique<MomentumObserver<body_type>>());
+        pipeline.addObserver(std::make_unique<LagrangianRadiiObserver<body_type>>(), 10);
+        pipeline.addObserver(std::make_unique<RadialProfileObserver<body_type>>(std::vector<double>{0.25, 0.5, 0.75, 1., 2.}), 25);
+
+        star_system.computeForcesAndPotential(force_computer);
+        pipeline.observe(0, 0., star_system, force_computer);
+        EnergyObserver<body_type> energy_observer;
+        MomentumObserver<body_type> momentum_observer;
+        first_energy = observe(energy_observer, star_system, force_computer, 1);
+        first_momentum = observe(momentum_observer, star_system, force_computer, 1);
+        for(std::size_t step{1}; step <= num_steps; ++step){
+            integrator.timeStep(star_system, force_computer, time_step);
+
+            // The energy and the momenta fill their 16 rows at the same steps, the other observers
+            // run too rarely to fill theirs.
+            if(pipeline.writesAt(step) != ((step + 1) % 16 == 0)){
+                throw std::runtime_error("The pipeline does not know at which steps it writes, step " + std::to_string(step) + ".\n");
+            }
+            pipeline.observe(step, step * time_step, star_system, force_computer);
+        }
+
+        // Leapfrog conserves the momenta up to rounding, and the energy to second order.
+        const std::vector<double> energy = observe(energy_observer, star_system, force_computer, 1);
+        const std::vector<double> momentum = observe(momentum_observer, star_system, force_computer, 1);
+        check_close("The total energy at the end", energy[2], first_energy[2], 1e-4 * std::abs(first_energy[2]));
+        for(std::size_t c{0}; c < momentum.size(); ++c){
+            check_close("Component " + std::to_string(c) + " of the momenta at the end", momentum[c], first_momentum[c], 1e-12);
+        }
+    }
+
+    hid_t file_id = H5Fopen(output_path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    const std::vector<std::pair<std::string, std::vector<hsize_t>>> expected{
+        {"energy/values", {num_steps + 1, 3}},
+        {"energy/steps", {num_steps + 1}},
+        {"momentum/values", {num_steps + 1, 6}},
+        {"lagrangian_radii/values", {num_steps / 10 + 1, 5}},
+        {"lagrangian_radii/times", {num_steps / 10 + 1}},
+        {"radial_profile/values", {num_steps / 25 + 1, 5}}
+    };
+    for(const auto& dataset: expected){
+        if(dataset_dims(file_id, dataset.first) != dataset.second){
+            throw std::runtime_error("The dataset " + dataset.first + " has the wrong size.\n");
+        }
+    }
+
+    // The steps and the first row of the energy.
+    std::vector<std::uint64_t> steps(num_steps / 10 + 1);
+    hid_t dset_id = H5Dopen(file_id, "lagrangian_radii/steps", H5P_DEFAULT);
+    H5Dread(dset_id, H5T_NATIVE_UINT64, H5S_ALL, H5S_ALL, H5P_DEFAULT, steps.data());
+    H5Dclose(dset_id);
+    for(std::size_t i{0}; i < steps.size(); ++i){
+        if(steps[i] != 10 * i){
+            throw std::runtime_error("The Lagrangian radii were observed at the wrong steps.\n");
+        }
+    }
+    std::vector<double> energies(3 * (num_steps + 1));
+    dset_id = H5Dopen(file_id, "energy/values", H5P_DEFAULT);
+    H5Dread(dset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, energies.data());
+
+    // The names of the columns.
+    hid_t attribute_id = H5Aopen(dset_id, TIME_SERIES_COLUMNS_ATTRIBUTE_NAME, H5P_DEFAULT);
+    hid_t string_type = H5Aget_type(attribute_id);
+    const std::size_t name_size = H5Tget_size(string_type);
+    std::vector<char> names(3 * name_size);
+    H5Aread(attribute_id, string_type, names.data());
+    H5Tclose(string_type);
+    H5Aclose(attribute_id);
+    H5Dclose(dset_id);
+    if(std::string(names.data() + 2 * name_size, std::strlen("total_energy")) != "total_energy"){
+        throw std::runtime_error("The names of the columns of the energy were not written.\n");
+    }
+    if(std::memcmp(energies.data(), first_energy.data(), 3 * sizeof(double)) != 0){
+        throw std::runtime_error("The energy in the file differs from the observed energy.\n");
+    }
+
+    hsize_t file_size;
+    H5Fget_filesize(file_id, &file_size);
+    H5Fclose(file_id);
+    const std::size_t snapshot_size = (num_steps + 1) * num_bodies * 7 * sizeof(numeric_type);
+    std::cout << "Time series of " << num_steps + 1 << " steps: " << file_size << " bytes, snapshots of every step: " << snapshot_size << " bytes" << std::endl;
+    std::remove(output_path.c_str());
+}
+
+
+int main(){
+    check_observers();
+    check_2d_momentum();
+    check_pipeline();
+}
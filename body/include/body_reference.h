@@ -0,0 +1,100 @@
+// Proxies giving Body-like access to a single body in a StarSystem.
+// A StarSystem stores its bodies as a structure of arrays, so there is no Body object to refer to.
+// These proxies provide the Body interface on top of the arrays instead, so that code written for
+// Body objects keeps working when iterating over or indexing a StarSystem.
+#ifndef BodyReference_H
+#define BodyReference_H
+
+#include <cstddef>
+#include <iterator>
+#include <ostream>
+#include <type_traits>
+
+#include "body.h"
+
+// StarSystemType is either StarSystem<BodyType> or const StarSystem<BodyType>. Only the former
+// allows updating the body.
+template<typename StarSystemType> class BodyReference{
+
+    public:
+        using body_type = typename std::remove_const<StarSystemType>::type::body_type;
+        using numeric_type = typename body_type::numeric_type;
+        using vector_type = typename body_type::vector_type;
+
+        BodyReference(StarSystemType& star_system, const std::size_t index):
+            _star_system(&star_system),
+            _index(index)
+        {}
+
+        // A proxy to a mutable body can be used wherever a proxy to a const body is expected.
+        template<typename OtherType, typename = typename std::enable_if<std::is_same<const OtherType, StarSystemType>::value>::type>
+        BodyReference(const BodyReference<OtherType>& other):
+            _star_system(&other.starSystem()),
+            _index(other.index())
+        {}
+
+        vector_type position() const{ return _star_system->position(_index); }
+        vector_type velocity() const{ return _star_system->velocity(_index); }
+        numeric_type mass() const{ return _star_system->mass(_index); }
+
+        void updatePosition(const vector_type& update) const{ _star_system->updatePosition(_index, update); }
+        void updateVelocity(const vector_type& update) const{ _star_system->updateVelocity(_index, update); }
+
+        // Copy the body out of the star system.
+        operator body_type() const{ return body_type(position(), velocity(), mass()); }
+
+        StarSystemType& starSystem() const{ return *_star_system; }
+        std::size_t index() const{ return _index; }
+
+    private:
+        StarSystemType* _star_system;
+        std::size_t _index;
+};
+
+
+template<typename StarSystemType> std::ostream& operator<<(std::ostream& os, const BodyReference<StarSystemType>& body){
+    os << static_cast<typename BodyReference<StarSystemType>::body_type>(body);
+    return os;
+}
+
+
+// Iterator over the bodies of a StarSystem.
+// Dereferencing yields a BodyReference by value, so the iterator only models an input iterator,
+// but it supports the usual random access arithmetic.
+template<typename StarSystemType> class BodyIterator{
+
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = typename BodyReference<StarSystemType>::body_type;
+        using difference_type = std::ptrdiff_t;
+        using reference = BodyReference<StarSystemType>;
+        using pointer = void;
+
+        BodyIterator(StarSystemType& star_system, const std::size_t index):
+            _star_system(&star_system),
+            _index(index)
+        {}
+
+        reference operator*() const{ return reference(*_star_system, _index); }
+        reference operator[](const difference_type offset) const{ return reference(*_star_system, _index + offset); }
+
+        BodyIterator& operator++(){ ++_index; return *this; }
+        BodyIterator operator++(int){ BodyIterator ret{*this}; ++_index; return ret; }
+        BodyIterator& operator--(){ --_index; return *this; }
+        BodyIterator operator--(int){ BodyIterator ret{*this}; --_index; return ret; }
+        BodyIterator& operator+=(const difference_type offset){ _index += offset; return *this; }
+        BodyIterator& operator-=(const difference_type offset){ _index -= offset; return *this; }
+        BodyIterator operator+(const difference_type offset) const{ BodyIterator ret{*this}; ret += offset; return ret; }
+        BodyIterator operator-(const difference_type offset) const{ BodyIterator ret{*this}; ret -= offset; return ret; }
+        difference_type operator-(const BodyIterator& rhs) const{ return static_cast<difference_type>(_index) - static_cast<difference_type>(rhs._index); }
+
+        bool operator==(const BodyIterator& rhs) const{ return _index == rhs._index; }
+        bool operator!=(const BodyIterator& rhs) const{ return _index != rhs._index; }
+        bool operator<(const BodyIterator& rhs) const{ return _index < rhs._index; }
+
+    private:
+        StarSystemType* _star_system;
+        std::size_t _index;
+};
+
+#endif
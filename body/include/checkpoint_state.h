@@ -0,0 +1,102 @@
+// Named arrays of plain values making up the state of a simulation, for checkpoints.
+// The star system, the integrator and the force computer each save the state they need to resume
+// a simulation bit for bit under their own names, and load it back from a state that was read from
+// a checkpoint file. The values are stored as raw bytes, so a checkpoint can only be loaded by a
+// build with the same numeric types and vector layout. The file format is in io/include/checkpoint.h.
+//
+// Saving under a name that already exists overwrites the values and reuses their memory, so
+// saving the same simulation again does not allocate.
+#ifndef CheckpointState_H
+#define CheckpointState_H
+
+#include <cstddef>
+#include <cstring>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+
+class CheckpointState{
+    public:
+        struct Record{
+            std::size_t element_size = 0;
+            std::vector<char> bytes;
+
+            std::size_t size() const{ return bytes.size() / element_size; }
+        };
+
+        bool contains(const std::string& name) const{ return _records.count(name) != 0; }
+
+        // Number of values saved under a name.
+        std::size_t size(const std::string& name) const{ return record(name).size(); }
+
+        const std::map<std::string, Record>& records() const{ return _records; }
+
+        void clear(){ _records.clear(); }
+
+        // Save the raw bytes of a record, as read from a file.
+        void save_bytes(const std::string& name, const std::size_t element_size, const char* bytes, const std::size_t num_bytes){
+            if(element_size == 0 || num_bytes % element_size != 0){
+                throw std::invalid_argument("The checkpoint record " + name + " does not consist of whole elements.");
+            }
+            Record& saved = _records[name];
+            saved.element_size = element_size;
+            saved.bytes.assign(bytes, bytes + num_bytes);
+        }
+
+        template<typename T> void save(const std::string& name, const T* values, const std::size_t count){
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be saved in a checkpoint.");
+            save_bytes(name, sizeof(T), reinterpret_cast<const char*>(values), count * sizeof(T));
+        }
+
+        template<typename T> void save(const std::string& name, const std::vector<T>& values){
+            save(name, values.data(), values.size());
+        }
+
+        template<typename T> void save(const std::string& name, const T& value){
+            save(name, &value, 1);
+        }
+
+        // Load exactly count values into an existing array.
+        template<typename T> void load(const std::string& name, T* values, const std::size_t count) const{
+            const Record& saved = typed_record<T>(name);
+            if(saved.size() != count){
+                throw std::length_error("The checkpoint record " + name + " holds " + std::to_string(saved.size()) + " values, but " + std::to_string(count) + " were expected.");
+            }
+            std::memcpy(static_cast<void*>(values), saved.bytes.data(), saved.bytes.size());
+        }
+
+        // Load all values of a record, resizing the vector to their number.
+        template<typename T> void load(const std::string& name, std::vector<T>& values) const{
+            values.resize(typed_record<T>(name).size());
+            load(name, values.data(), values.size());
+        }
+
+        template<typename T> void load(const std::string& name, T& value) const{
+            load(name, &value, 1);
+        }
+
+    private:
+        std::map<std::string, Record> _records;
+
+        const Record& record(const std::string& name) const{
+            const auto saved = _records.find(name);
+            if(saved == _records.end()){
+                throw std::out_of_range("The checkpoint does not contain " + name + ".");
+            }
+            return saved->second;
+        }
+
+        template<typename T> const Record& typed_record(const std::string& name) const{
+            static_assert(std::is_trivially_copyable<T>::value, "Only trivially copyable values can be loaded from a checkpoint.");
+            const Record& saved = record(name);
+            if(saved.element_size != sizeof(T)){
+                throw std::invalid_argument("The checkpoint record " + name + " holds values of " + std::to_string(saved.element_size) + " bytes, but values of " + std::to_string(sizeof(T)) + " bytes were expected.");
+            }
+            return saved;
+        }
+};
+
+#endif
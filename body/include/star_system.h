@@ -2,26 +2,73 @@
 #ifndef StarSystem_H
 #define StarSystem_H
 
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
 #include "../../force/include/force_computer_base.h"
+#include "../../vector/include/aligned_allocator.h"
+#include "../../vector/include/vector_array.h"
+#include "body_reference.h"
+
+// The bodies are stored as a structure of arrays: each component of the positions and velocities,
+// and the masses, are kept in separate contiguous arrays aligned to a cache line. Loops that only
+// need positions and masses, like the force computations, then don't pull the velocities into the
+// cache. Individual bodies can still be accessed through proxy objects with the Body interface.
 template<typename BodyType> class ForceComputerBase;
 template<typename BodyType> class StarSystem{
 
     public:
+        using body_type = BodyType;
         using numeric_type = typename BodyType::numeric_type;
         using vector_type = typename BodyType::vector_type;
-        using const_iterator = typename std::vector<BodyType>::const_iterator;
-        using iterator = typename std::vector<BodyType>::iterator;
+        using reference = BodyReference<StarSystem>;
+        using const_reference = BodyReference<const StarSystem>;
+        using iterator = BodyIterator<StarSystem>;
+        using const_iterator = BodyIterator<const StarSystem>;
 
         StarSystem(const std::vector<BodyType>& bodies):
-            _bodies(bodies)
-        {};
+            _positions(bodies.size()),
+            _velocities(bodies.size()),
+            _masses(bodies.size())
+        {
+            for(std::size_t b{0}; b < bodies.size(); ++b){
+                _positions.set(b, bodies[b].position());
+                _velocities.set(b, bodies[b].velocity());
+                _masses[b] = bodies[b].mass();
+            }
+        };
+        // Bodies at rest at the origin and without mass, to be filled in through the arrays,
+        // for example by reading a snapshot into it.
+        explicit StarSystem(const std::size_t size):
+            _positions(size),
+            _velocities(size),
+            _masses(size)
+        {}
         ~StarSystem() = default;
 
         // Star systems can not be copy constructed or copy assigned.
         StarSystem(const StarSystem&) = default;
         StarSystem(StarSystem&&) = default;
-        StarSystem& operator=(const StarSystem&) = default;
-        StarSystem& operator=(StarSystem&&) = default;
+
+        // Assignment replaces the bodies, which counts as a change of this star system, so the
+        // version is not taken over from the other one.
+        StarSystem& operator=(const StarSystem& other){
+            _positions = other._positions;
+            _velocities = other._velocities;
+            _masses = other._masses;
+            ++_version;
+            return *this;
+        }
+        StarSystem& operator=(StarSystem&& other){
+            _positions = std::move(other._positions);
+            _velocities = std::move(other._velocities);
+            _masses = std::move(other._masses);
+            ++_version;
+            return *this;
+        }
 
         // Properties of the while star system.
         
@@ -33,8 +80,8 @@ template<typename BodyType> class StarSystem{
         // Kinetic energy.
         numeric_type kineticEnergy() const{
             numeric_type kinetic_energy = 0.;
-            for(const auto& body: _bodies){
-                kinetic_energy += square(body.velocity())*body.mass();
+            for(std::size_t b{0}; b < size(); ++b){
+                kinetic_energy += square(_velocities[b])*_masses[b];
             }
             kinetic_energy *= 0.5;
             return kinetic_energy;
@@ -49,33 +96,94 @@ template<typename BodyType> class StarSystem{
         }
 
         // Access individual bodies.
-        std::size_t size() const{ return _bodies.size();}
-
-        const BodyType& operator[](const std::size_t index) const{
-            return _bodies.at(index);
+        // As for std::vector::at, an out of range index throws an exception.
+        std::size_t size() const{ return _masses.size();}
+
+        // Bodies that are added are at rest at the origin and without mass. The memory of the
+        // arrays is kept if the star system shrinks.
+        void resize(const std::size_t size){
+            ++_version;
+            _positions.resize(size);
+            _velocities.resize(size);
+            _masses.resize(size);
         }
 
-        BodyType& operator[](const std::size_t index){
-            return _bodies.at(index);
+        const_reference operator[](const std::size_t index) const{
+            checkIndex(index);
+            return const_reference(*this, index);
         }
 
-        const_iterator begin() const{ return _bodies.cbegin(); }
-        const_iterator cbegin() const{ return _bodies.cbegin(); }
-        const_iterator end() const{ return _bodies.cend(); }
-        const_iterator cend() const{ return _bodies.cend(); }
+        reference operator[](const std::size_t index){
+            checkIndex(index);
+            return reference(*this, index);
+        }
 
-        iterator begin(){return _bodies.begin();}
-        iterator end(){return _bodies.end();}
+        const_iterator begin() const{ return const_iterator(*this, 0); }
+        const_iterator cbegin() const{ return const_iterator(*this, 0); }
+        const_iterator end() const{ return const_iterator(*this, size()); }
+        const_iterator cend() const{ return const_iterator(*this, size()); }
+
+        iterator begin(){return iterator(*this, 0);}
+        iterator end(){return iterator(*this, size());}
+
+        // Unchecked access to the properties of a single body, for use in hot loops.
+        vector_type position(const std::size_t index) const{ return _positions[index]; }
+        vector_type velocity(const std::size_t index) const{ return _velocities[index]; }
+        numeric_type mass(const std::size_t index) const{ return _masses[index]; }
+
+        void updatePosition(const std::size_t index, const vector_type& update){ ++_version; _positions.add(index, update); }
+        void updateVelocity(const std::size_t index, const vector_type& update){ _velocities.add(index, update); }
+        void setPosition(const std::size_t index, const vector_type& position){ ++_version; _positions.set(index, position); }
+        void setVelocity(const std::size_t index, const vector_type& velocity){ _velocities.set(index, velocity); }
+
+        // Counter of the changes to the positions and masses, which determine the forces. It is
+        // increased by every method that can change them, including the mutable access to their
+        // arrays, so integrators can tell whether forces they computed earlier are still valid.
+        // A reference to an array that is kept and written to later is not counted.
+        std::uint64_t version() const{ return _version; }
+
+        // Access to the underlying arrays.
+        const VectorArray<vector_type>& positions() const{ return _positions; }
+        const VectorArray<vector_type>& velocities() const{ return _velocities; }
+        const aligned_vector<numeric_type>& masses() const{ return _masses; }
+
+        // Mutable access to fill the arrays in place. All arrays must keep the same size, so they
+        // should only be resized through resize.
+        VectorArray<vector_type>& positions(){ ++_version; return _positions; }
+        VectorArray<vector_type>& velocities(){ return _velocities; }
+        aligned_vector<numeric_type>& masses(){ ++_version; return _masses; }
 
         // Interface to compute forces and accelerations, as well as the potential energy.
         void computeForces(ForceComputerBase<BodyType>& force_computer) const{ force_computer.computeForces(*this); }
         void computeForcesAndPotential(ForceComputerBase<BodyType>& force_computer) const{ force_computer.computeForcesAndPotential(*this); }
+        void computeAccelerations(ForceComputerBase<BodyType>& force_computer, std::vector<vector_type>& accelerations) const{
+            force_computer.computeAccelerations(*this, accelerations);
+        }
+        void computeAccelerationsAndPotential(ForceComputerBase<BodyType>& force_computer, std::vector<vector_type>& accelerations) const{
+            force_computer.computeAccelerationsAndPotential(*this, accelerations);
+        }
+        void computeAccelerations(
+            ForceComputerBase<BodyType>& force_computer,
+            const std::vector<std::size_t>& active_bodies,
+            std::vector<vector_type>& accelerations) const
+        {
+            force_computer.computeAccelerations(*this, active_bodies, accelerations);
+        }
         vector_type acceleration(ForceComputerBase<BodyType>& force_computer, const std::size_t index){
-            return (force_computer.totalForce(index)/_bodies.at(index).mass());
+            return (force_computer.totalForce(index)/_masses.at(index));
         }
 
     private:
-        std::vector<BodyType> _bodies;
+        VectorArray<vector_type> _positions;
+        VectorArray<vector_type> _velocities;
+        aligned_vector<numeric_type> _masses;
+        std::uint64_t _version = 0;
+
+        void checkIndex(const std::size_t index) const{
+            if(index >= size()){
+                throw std::out_of_range("Body index " + std::to_string(index) + " is out of range for a star system of " + std::to_string(size()) + " bodies.");
+            }
+        }
 };
 
 template <typename BodyType> bool all_close(const StarSystem<BodyType>& lhs, const StarSystem<BodyType>& rhs){
@@ -83,7 +191,7 @@ template <typename BodyType> bool all_close(const StarSystem<BodyType>& lhs, con
         return false;
     }
     for(std::size_t b{0}; b < lhs.size(); ++b){
-        if(!is_close(lhs[b], rhs[b])){
+        if(!is_close(BodyType(lhs[b]), BodyType(rhs[b]))){
             return false;
         }
     }
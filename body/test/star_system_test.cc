@@ -0,0 +1,81 @@
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "../include/body.h"
+#include "../include/star_system.h"
+#include "../../vector/include/vector2D.h"
+#include "../../vector/include/vector3D.h"
+
+template<typename VectorType> void test_star_system(const VectorType& position_update, const VectorType& velocity_update){
+    using body_type = Body<VectorType>;
+    using numeric_type = typename body_type::numeric_type;
+
+    std::vector<body_type> bodies;
+    for(std::size_t b = 0; b < 10; ++b){
+        numeric_type value = static_cast<numeric_type>(b);
+        bodies.emplace_back(value * position_update, value * velocity_update, value + 1);
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    // The underlying arrays must be aligned to a cache line.
+    for(std::size_t d{0}; d < VectorArray<VectorType>::dimension; ++d){
+        if(reinterpret_cast<std::uintptr_t>(star_system.positions().data(d)) % CACHE_LINE_SIZE != 0){
+            throw std::runtime_error("Position array is not aligned to a cache line.");
+        }
+    }
+    if(reinterpret_cast<std::uintptr_t>(star_system.masses().data()) % CACHE_LINE_SIZE != 0){
+        throw std::runtime_error("Mass array is not aligned to a cache line.");
+    }
+
+    // Iterating and indexing give the same bodies that were used to construct the star system.
+    std::size_t index = 0;
+    for(const auto& body: star_system){
+        if(!is_close(body_type(body), bodies[index]) || !is_close(body_type(star_system[index]), bodies[index])){
+            throw std::runtime_error("Body read from the star system differs from the original body.");
+        }
+        ++index;
+    }
+
+    // Updates through the proxies end up in the star system.
+    for(auto body: star_system){
+        body.updatePosition(position_update);
+        body.updateVelocity(velocity_update);
+    }
+    star_system[0].updatePosition(position_update);
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        numeric_type steps = static_cast<numeric_type>(b + 1 + (b == 0));
+        if(!is_close(star_system[b].position(), steps * position_update) || !is_close(star_system.velocity(b), (steps - (b == 0)) * velocity_update)){
+            throw std::runtime_error("Body update through a proxy was not stored in the star system.");
+        }
+    }
+
+    // Out of range access throws like std::vector::at does.
+    bool thrown = false;
+    try{
+        star_system[star_system.size()];
+    } catch(const std::out_of_range&){
+        thrown = true;
+    }
+    if(!thrown){
+        throw std::runtime_error("Out of range access to a star system did not throw.");
+    }
+
+    // Star systems made by size are filled in through the arrays.
+    StarSystem<body_type> filled(3);
+    filled.masses()[2] = 5;
+    filled.positions().set(2, position_update);
+    filled.resize(4);
+    if(filled.size() != 4 || filled.mass(2) != 5 || !is_close(filled.position(2), position_update) || filled.mass(3) != 0 || !is_close(filled.velocity(3), VectorType{})){
+        throw std::runtime_error("A star system filled through its arrays does not hold the bodies.");
+    }
+}
+
+int main(){
+    test_star_system(Vector2D<float>{1.0f, 2.0f}, Vector2D<float>{3.0f, 4.0f});
+    test_star_system(Vector2D<double>{1.0, 2.0}, Vector2D<double>{3.0, 4.0});
+    test_star_system(Vector3D<float>{1.0f, 2.0f, 3.0f}, Vector3D<float>{4.0f, 5.0f, 6.0f});
+    test_star_system(Vector3D<double>{1.0, 2.0, 3.0}, Vector3D<double>{4.0, 5.0, 6.0});
+    std::cout << "Test run successfully." << std::endl;
+}
@@ -0,0 +1,43 @@
+// Driver that runs a simulation described by a configuration file:
+//
+//     galaxysim [config file] [key=value ...]
+//
+// The settings are described in include/simulation_config.h, and settings on the command line
+// override those in the file. At the end the time spent in every phase of the simulation is
+// printed.
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+
+#include "include/simulation.h"
+#include "include/simulation_config.h"
+#include "../body/include/body.h"
+#include "../vector/include/vector3D.h"
+
+using body_type = Body<Vector3D<double>>;
+
+int main(int argc, char** argv){
+    try{
+        SimulationConfig config;
+        for(int a{1}; a < argc; ++a){
+            if(std::strcmp(argv[a], "-h") == 0 || std::strcmp(argv[a], "--help") == 0){
+                std::cout << "Usage: " << argv[0] << " [config file] [key=value ...]" << std::endl;
+                return 0;
+            }
+            if(std::strchr(argv[a], '=') != nullptr){
+                setConfigAssignment(config, argv[a]);
+            } else if(a == 1){
+                config = readConfig(argv[a]);
+            } else {
+                throw std::invalid_argument(std::string("The configuration file must be the first argument, \"") + argv[a] + "\" is not a setting.");
+            }
+        }
+
+        const SimulationTimes times = runSimulation<body_type>(config, std::cout);
+        printSimulationTimes(times, std::cout);
+    } catch(const std::exception& error){
+        std::cerr << "galaxysim: " << error.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,89 @@
+// Generators of initial conditions for simulations, in units where G = 1 and the total mass is 1.
+#ifndef InitialConditions_H
+#define InitialConditions_H
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector_math.h"
+
+
+// Unit vector in a uniformly random direction.
+template<typename VectorType> VectorType randomDirection(std::mt19937& random_device){
+    using numeric_type = typename VectorType::value_type;
+    std::uniform_real_distribution<numeric_type> uniform(-1., 1.);
+    while(true){
+        const VectorType direction(uniform(random_device), uniform(random_device), uniform(random_device));
+        const numeric_type length = abs(direction);
+        if(length > 0 && length <= 1){
+            return (numeric_type(1) / length) * direction;
+        }
+    }
+}
+
+
+// Plummer sphere in equilibrium, sampled as in Aarseth, Henon & Wielen (1974). The scale radius
+// is 3 pi / 16, so that the virial radius is 1 (Heggie units). The distribution is truncated at
+// 99.9% of the mass, and the center of mass is moved to the origin and put at rest.
+template<typename BodyType> StarSystem<BodyType> makePlummerSphere(const std::size_t num_bodies, const unsigned seed = 0){
+    using numeric_type = typename BodyType::numeric_type;
+    using vector_type = typename BodyType::vector_type;
+    constexpr double scale_radius = 3. * 3.14159265358979323846 / 16.;
+
+    std::mt19937 random_device{seed};
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    std::vector<BodyType> bodies;
+    bodies.reserve(num_bodies);
+    vector_type center_of_mass;
+    vector_type center_of_mass_velocity;
+    const numeric_type mass = numeric_type(1) / num_bodies;
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        // Invert the enclosed mass M(r) = r^3 / (r^2 + a^2)^(3/2).
+        double enclosed_mass;
+        do{
+            enclosed_mass = uniform(random_device);
+        } while(enclosed_mass == 0. || enclosed_mass > 0.999);
+        const double radius = scale_radius / std::sqrt(std::pow(enclosed_mass, -2. / 3.) - 1.);
+
+        // The speed in units of the escape speed, q, has the distribution q^2 (1 - q^2)^(7/2),
+        // which is sampled by rejection under its maximum of about 0.092.
+        double q;
+        do{
+            q = uniform(random_device);
+        } while(0.1 * uniform(random_device) > q * q * std::pow(1. - q * q, 3.5));
+        const double escape_speed = std::sqrt(2.) * std::pow(radius * radius + scale_radius * scale_radius, -0.25);
+
+        const vector_type position = static_cast<numeric_type>(radius) * randomDirection<vector_type>(random_device);
+        const vector_type velocity = static_cast<numeric_type>(q * escape_speed) * randomDirection<vector_type>(random_device);
+        bodies.push_back(BodyType(position, velocity, mass));
+        center_of_mass += mass * position;
+        center_of_mass_velocity += mass * velocity;
+    }
+    for(BodyType& body: bodies){
+        body.updatePosition(-center_of_mass);
+        body.updateVelocity(-center_of_mass_velocity);
+    }
+    return StarSystem<BodyType>(bodies);
+}
+
+
+// Bodies at rest, uniformly distributed in the cube [-1, 1]^3, which collapses under its own
+// gravity.
+template<typename BodyType> StarSystem<BodyType> makeUniformCube(const std::size_t num_bodies, const unsigned seed = 0){
+    using numeric_type = typename BodyType::numeric_type;
+    using vector_type = typename BodyType::vector_type;
+    std::mt19937 random_device{seed};
+    std::uniform_real_distribution<numeric_type> uniform(-1., 1.);
+    std::vector<BodyType> bodies;
+    bodies.reserve(num_bodies);
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        const vector_type position(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies.push_back(BodyType(position, vector_type(), numeric_type(1) / num_bodies));
+    }
+    return StarSystem<BodyType>(bodies);
+}
+
+#endif
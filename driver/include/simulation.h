@@ -0,0 +1,300 @@
+// Run loop of the galaxysim driver.
+// A simulation is set up from a SimulationConfig, either from generated initial conditions or
+// resumed from a checkpoint, and advanced to the last step. Snapshots and checkpoints are written
+// on background threads, and the in-situ analysis runs after the steps it is due. The wall clock
+// time of every phase is measured, the force computation separately from the rest of the time
+// step.
+#ifndef Simulation_H
+#define Simulation_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "initial_conditions.h"
+#include "simulation_config.h"
+#include "../../analysis/include/analysis_pipeline.h"
+#include "../../analysis/include/center_of_mass_observer.h"
+#include "../../analysis/include/energy_observer.h"
+#include "../../analysis/include/lagrangian_radii_observer.h"
+#include "../../analysis/include/momentum_observer.h"
+#include "../../body/include/star_system.h"
+#include "../../force/include/barnes_hut_force_computer.h"
+#include "../../force/include/direct_sum_force_computer.h"
+#include "../../force/include/fast_multipole_force_computer.h"
+#include "../../force/include/force_computer_base.h"
+#include "../../force/include/parallel_direct_sum_force_computer.h"
+#include "../../force/include/particle_mesh_force_computer.h"
+#include "../../force/include/simd_direct_sum_force_computer.h"
+#include "../../force/include/softening_kernel.h"
+#include "../../integration/include/block_time_step.h"
+#include "../../integration/include/dormand_prince.h"
+#include "../../integration/include/forward_euler.h"
+#include "../../integration/include/integrator_base.h"
+#include "../../integration/include/leapfrog.h"
+#include "../../integration/include/runge_kutta_four.h"
+#include "../../integration/include/runge_kutta_two.h"
+#include "../../io/include/async_checkpoint_writer.h"
+#include "../../io/include/async_star_system_writer.h"
+#include "../../io/include/checkpoint.h"
+#include "../../io/include/star_system_writer.h"
+
+
+// Rows of the time series of the analysis that are buffered before they are written.
+constexpr std::size_t analysis_rows_per_write = 64;
+
+
+// Wall clock time of the phases of a simulation, in seconds.
+struct SimulationTimes{
+    double setup = 0.;
+    double forces = 0.;
+    double integration = 0.;
+    double output = 0.;
+    double analysis = 0.;
+    double checkpoints = 0.;
+    double total = 0.;
+
+    std::size_t num_bodies = 0;
+    std::uint64_t first_step = 0;
+    std::uint64_t last_step = 0;
+};
+
+
+template<typename BodyType> std::unique_ptr<ForceComputerBase<BodyType>> makeForceComputer(const SimulationConfig& config){
+    using numeric_type = typename BodyType::numeric_type;
+    const numeric_type G = static_cast<numeric_type>(config.G);
+    const std::size_t num_threads = std::max<std::size_t>(config.num_threads, 1);
+    std::unique_ptr<ForceComputerBase<BodyType>> force_computer;
+    if(config.force_computer == "direct"){
+        force_computer = std::make_unique<DirectSumForceComputer<BodyType>>(G);
+    } else if(config.force_computer == "parallel_direct"){
+        force_computer = std::make_unique<ParallelDirectSumForceComputer<BodyType>>(G, num_threads);
+    } else if(config.force_computer == "simd"){
+        force_computer = std::make_unique<SimdDirectSumForceComputer<BodyType>>(G);
+    } else if(config.force_computer == "barnes_hut"){
+        force_computer = std::make_unique<BarnesHutForceComputer<BodyType>>(G, static_cast<numeric_type>(config.opening_angle));
+    } else if(config.force_computer == "fast_multipole"){
+        force_computer = std::make_unique<FastMultipoleForceComputer<BodyType>>(G, config.multipole_order, static_cast<numeric_type>(config.opening_angle));
+    } else if(config.force_computer == "particle_mesh"){
+        force_computer = std::make_unique<ParticleMeshForceComputer<BodyType>>(G, config.grid_size);
+    } else {
+        throw std::invalid_argument("Unknown force computer " + config.force_computer + ".");
+    }
+    if(config.softening > 0){
+        force_computer->setSoftening(SofteningKernel<numeric_type>::plummer(static_cast<numeric_type>(config.softening)));
+    }
+    return force_computer;
+}
+
+
+template<typename BodyType> std::unique_ptr<IntegratorBase<BodyType>> makeIntegrator(const SimulationConfig& config){
+    using numeric_type = typename BodyType::numeric_type;
+    if(config.integrator == "euler"){
+        return std::make_unique<ForwardEuler<BodyType>>();
+    } else if(config.integrator == "rk2"){
+        return std::make_unique<RungeKuttaTwo<BodyType>>();
+    } else if(config.integrator == "rk4"){
+        return std::make_unique<RungeKuttaFour<BodyType>>();
+    } else if(config.integrator == "leapfrog"){
+        return std::make_unique<Leapfrog<BodyType>>();
+    } else if(config.integrator == "dormand_prince"){
+        const numeric_type tolerance = static_cast<numeric_type>(config.tolerance);
+        return std::make_unique<DormandPrince<BodyType>>(tolerance, tolerance);
+    } else if(config.integrator == "block_time_step"){
+        return std::make_unique<BlockTimeStep<BodyType>>();
+    }
+    throw std::invalid_argument("Unknown integrator " + config.integrator + ".");
+}
+
+
+template<typename BodyType> StarSystem<BodyType> makeInitialConditions(const SimulationConfig& config){
+    if(config.initial_conditions == "plummer"){
+        return makePlummerSphere<BodyType>(config.num_bodies, config.seed);
+    } else if(config.initial_conditions == "uniform_cube"){
+        return makeUniformCube<BodyType>(config.num_bodies, config.seed);
+    }
+    throw std::invalid_argument("Unknown initial conditions " + config.initial_conditions + ".");
+}
+
+
+// Print the time of every phase, and its share of the total.
+inline void printSimulationTimes(const SimulationTimes& times, std::ostream& log){
+    const std::uint64_t num_steps = times.last_step - times.first_step;
+    auto print_phase = [&](const char* name, const double seconds){
+        log << std::left << std::setw(14) << name << std::right << std::fixed << std::setprecision(3)
+            << std::setw(10) << seconds << " s" << std::setw(8) << std::setprecision(1)
+            << (times.total > 0 ? 100. * seconds / times.total : 0.) << " %" << std::endl;
+    };
+    log << "Phase              time   share" << std::endl;
+    print_phase("setup", times.setup);
+    print_phase("forces", times.forces);
+    print_phase("integration", times.integration);
+    print_phase("output", times.output);
+    print_phase("analysis", times.analysis);
+    print_phase("checkpoints", times.checkpoints);
+    print_phase("total", times.total);
+    if(num_steps > 0){
+        const double step_seconds = (times.forces + times.integration) / num_steps;
+        log << std::defaultfloat << std::setprecision(4) << num_steps << " steps of " << times.num_bodies << " bodies, "
+            << 1e3 * step_seconds << " ms per step, " << times.num_bodies / step_seconds << " body updates per second" << std::endl;
+    }
+}
+
+
+// Run the simulation described by the configuration, and return the time of every phase.
+// Progress is reported to the log.
+template<typename BodyType> SimulationTimes runSimulation(const SimulationConfig& config, std::ostream& log){
+    using clock = std::chrono::steady_clock;
+    auto seconds_since = [](const clock::time_point start){
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+    checkConfig(config);
+    const auto run_start = clock::now();
+    SimulationTimes times;
+
+    std::unique_ptr<ForceComputerBase<BodyType>> force_computer = makeForceComputer<BodyType>(config);
+    std::unique_ptr<IntegratorBase<BodyType>> integrator = makeIntegrator<BodyType>(config);
+    StarSystem<BodyType> star_system(0);
+    std::uint64_t first_step = 0;
+    double start_time = 0.;
+    if(config.restart_from.empty()){
+        star_system = makeInitialConditions<BodyType>(config);
+
+        // The potential of the initial conditions, for the first observation of the energy.
+        star_system.computeForcesAndPotential(*force_computer);
+    } else {
+        // The output of the run that wrote the checkpoint is kept.
+        auto check_new_file = [](const std::string& path, const char* setting){
+            if(std::ifstream(path)){
+                throw std::invalid_argument("The " + std::string(setting) + " " + path + " exists, and a resumed simulation does not overwrite the output written before the checkpoint. Choose another " + setting + ".");
+            }
+        };
+        if(config.output_every != 0){
+            check_new_file(config.output_path, "output_path");
+        }
+        if(config.analysis_every != 0){
+            check_new_file(config.analysis_path, "analysis_path");
+        }
+        CheckpointState state;
+        read_checkpoint(config.restart_from, state);
+        load_checkpoint(state, star_system, *integrator, *force_computer, first_step, start_time);
+        log << "Resuming " << config.restart_from << " at step " << first_step << ", time " << start_time << std::endl;
+    }
+    times.num_bodies = star_system.size();
+    times.first_step = first_step;
+    times.last_step = std::max<std::uint64_t>(first_step, config.num_steps);
+
+    // HDF5 is not thread safe, so the analysis may only write to its file while the snapshot
+    // writer is idle. The pipeline is therefore created before the writer and destroyed after it,
+    // and the writer is flushed before every observation at which the pipeline writes its rows.
+    std::unique_ptr<AnalysisPipeline<BodyType>> pipeline;
+    if(config.analysis_every != 0){
+        pipeline = std::make_unique<AnalysisPipeline<BodyType>>(config.analysis_path, std::max<std::size_t>(config.num_threads, 1), analysis_rows_per_write);
+        pipeline->addObserver(std::make_unique<EnergyObserver<BodyType>>(), config.analysis_every);
+        pipeline->addObserver(std::make_unique<MomentumObserver<BodyType>>(), config.analysis_every);
+        pipeline->addObserver(std::make_unique<CenterOfMassObserver<BodyType>>(), config.analysis_every);
+        pipeline->addObserver(std::make_unique<LagrangianRadiiObserver<BodyType>>(), config.analysis_every);
+    }
+
+    // The energy needs the potential at the end of the step, which not every integrator leaves in
+    // the force computer. It is then computed by a force computer of its own, so that the state of
+    // the one of the integrator, like the forces or the placement of a grid, is the same as
+    // without the analysis.
+    std::unique_ptr<ForceComputerBase<BodyType>> analysis_force_computer;
+    if(pipeline && !integrator->potentialAtEndOfStep()){
+        analysis_force_computer = makeForceComputer<BodyType>(config);
+    }
+    std::unique_ptr<AsyncStarSystemWriter<BodyType>> writer;
+    if(config.output_every != 0){
+        StarSystemWriterOptions options;
+        options.layout = (config.output_layout == "columns" ? SnapshotLayout::columns : SnapshotLayout::rows);
+        options.compression = (config.output_compression == "deflate" ? SnapshotCompression::deflate : SnapshotCompression::none);
+        writer = std::make_unique<AsyncStarSystemWriter<BodyType>>(star_system.size(), config.output_path, options);
+    }
+    std::unique_ptr<AsyncCheckpointWriter<BodyType>> checkpoint_writer;
+    if(config.checkpoint_every != 0){
+        checkpoint_writer = std::make_unique<AsyncCheckpointWriter<BodyType>>();
+    }
+    times.setup = seconds_since(run_start);
+    force_computer->resetComputeSeconds();
+
+    // Snapshots, reductions and checkpoints at the given step. A resumed simulation does not
+    // repeat the output of its first step, which the checkpointed run already made.
+    auto output = [&](const std::uint64_t step, const double time){
+        if(writer && step % config.output_every == 0){
+            const auto start = clock::now();
+            writer->write_star_system(star_system, static_cast<typename BodyType::numeric_type>(time));
+            times.output += seconds_since(start);
+        }
+        if(pipeline){
+            if(writer && pipeline->writesAt(step)){
+                const auto start = clock::now();
+                writer->flush();
+                times.output += seconds_since(start);
+            }
+            const auto start = clock::now();
+
+            // The potential of the initial conditions was computed during the setup.
+            if(analysis_force_computer && step % config.analysis_every == 0 && step != first_step){
+                star_system.computeForcesAndPotential(*analysis_force_computer);
+                pipeline->observe(step, time, star_system, *analysis_force_computer);
+            } else {
+                pipeline->observe(step, time, star_system, *force_computer);
+            }
+            times.analysis += seconds_since(start);
+        }
+        if(checkpoint_writer && step % config.checkpoint_every == 0 && step != first_step){
+            const auto start = clock::now();
+            checkpoint_writer->write_checkpoint(config.checkpoint_path, star_system, *integrator, *force_computer, step, time);
+            times.checkpoints += seconds_since(start);
+        }
+    };
+    if(config.restart_from.empty()){
+        output(first_step, start_time);
+    }
+
+    double step_seconds = 0.;
+    for(std::uint64_t step{first_step + 1}; step <= times.last_step; ++step){
+        const auto step_start = clock::now();
+        integrator->timeStep(star_system, *force_computer, static_cast<typename BodyType::numeric_type>(config.time_step));
+        step_seconds += seconds_since(step_start);
+
+        const double time = start_time + (step - first_step) * config.time_step;
+        output(step, time);
+        if(config.progress_every != 0 && step % config.progress_every == 0){
+            log << "Step " << step << " of " << times.last_step << ", time " << time << std::endl;
+        }
+    }
+
+    // The output is only complete once the background threads are done.
+    const auto flush_start = clock::now();
+    if(writer){
+        writer->flush();
+    }
+    times.output += seconds_since(flush_start);
+    if(pipeline){
+        const auto start = clock::now();
+        pipeline->flush();
+        times.analysis += seconds_since(start);
+    }
+    if(checkpoint_writer){
+        const auto start = clock::now();
+        checkpoint_writer->flush();
+        times.checkpoints += seconds_since(start);
+    }
+
+    // The time of the force computer was reset after the setup, so it only covers the steps.
+    times.forces = force_computer->computeSeconds();
+    times.integration = std::max(step_seconds - times.forces, 0.);
+    times.total = seconds_since(run_start);
+    return times;
+}
+
+#endif
@@ -0,0 +1,209 @@
+// Configuration of a simulation run by the galaxysim driver.
+// A configuration file has one setting per line, as "key = value", and everything after a # is a
+// comment. Settings can also be given on the command line as key=value, which override those in
+// the file. Every setting has a default, so an empty configuration is a valid, small simulation.
+//
+// Bodies:
+//     num_bodies          number of bodies                                    1000
+//     initial_conditions  plummer or uniform_cube                             plummer
+//     seed                seed of the random initial conditions               0
+//     restart_from        checkpoint to resume from instead of the initial   (none)
+//                         conditions, see checkpoint.h. The output files of a
+//                         resumed simulation must not exist yet, so that it
+//                         does not replace the output written before the
+//                         checkpoint; give it a new output_path and
+//                         analysis_path
+// Forces:
+//     force_computer      direct, parallel_direct, simd, barnes_hut,          barnes_hut
+//                         fast_multipole or particle_mesh
+//     G                   gravitational constant                              1
+//     softening           Plummer softening length, 0 for none                0.01
+//     opening_angle       of barnes_hut and fast_multipole                    0.5
+//     multipole_order     of fast_multipole                                   4
+//     grid_size           of particle_mesh, a power of two                    64
+// Time integration:
+//     integrator          euler, rk2, rk4, leapfrog, dormand_prince or        leapfrog
+//                         block_time_step
+//     time_step           time between steps, the time between outputs for    0.001
+//                         the adaptive integrators
+//     num_steps           step at which the simulation ends                   1000
+//     tolerance           of dormand_prince                                   1e-6
+// Output, a cadence of 0 disables the output:
+//     output_every        steps between snapshots                             10
+//     output_path         HDF5 file of the snapshots, replaced by a new       galaxysim.h5
+//                         simulation
+//     output_layout       rows or columns                                     rows
+//     output_compression  none or deflate                                     none
+//     analysis_every      steps between in-situ reductions                    0
+//     analysis_path       HDF5 file of the reductions, replaced by a new      galaxysim_analysis.h5
+//                         simulation
+//     checkpoint_every    steps between checkpoints                           0
+//     checkpoint_path     file of the checkpoint, replaced every time         galaxysim.ckp
+//     num_threads         threads of parallel_direct and the analysis         all cores
+//     progress_every      steps between progress reports, 0 for none         100
+#ifndef SimulationConfig_H
+#define SimulationConfig_H
+
+#include <cstddef>
+#include <fstream>
+#include <initializer_list>
+#include <istream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+
+struct SimulationConfig{
+    std::size_t num_bodies = 1000;
+    std::string initial_conditions = "plummer";
+    unsigned seed = 0;
+    std::string restart_from = "";
+
+    std::string force_computer = "barnes_hut";
+    double G = 1.;
+    double softening = 0.01;
+    double opening_angle = 0.5;
+    unsigned multipole_order = 4;
+    std::size_t grid_size = 64;
+
+    std::string integrator = "leapfrog";
+    double time_step = 1e-3;
+    std::size_t num_steps = 1000;
+    double tolerance = 1e-6;
+
+    std::size_t output_every = 10;
+    std::string output_path = "galaxysim.h5";
+    std::string output_layout = "rows";
+    std::string output_compression = "none";
+    std::size_t analysis_every = 0;
+    std::string analysis_path = "galaxysim_analysis.h5";
+    std::size_t checkpoint_every = 0;
+    std::string checkpoint_path = "galaxysim.ckp";
+    std::size_t num_threads = std::thread::hardware_concurrency();
+    std::size_t progress_every = 100;
+};
+
+
+inline std::string trimConfigText(const std::string& text){
+    const std::size_t begin = text.find_first_not_of(" \t\r");
+    if(begin == std::string::npos){
+        return "";
+    }
+    return text.substr(begin, text.find_last_not_of(" \t\r") + 1 - begin);
+}
+
+
+// Parse the whole value as a number, so that e.g. "10x" or "1.5" for a count is rejected.
+template<typename T> T parseConfigNumber(const std::string& key, const std::string& value){
+    std::istringstream stream(value);
+    T number;
+    if(!(stream >> number) || !stream.eof() || (std::is_unsigned<T>::value && value.find('-') != std::string::npos)){
+        throw std::invalid_argument("The value \"" + value + "\" of " + key + " is not a valid number.");
+    }
+    return number;
+}
+
+
+inline std::string parseConfigChoice(const std::string& key, const std::string& value, std::initializer_list<const char*> choices){
+    std::string options;
+    for(const char* choice: choices){
+        if(value == choice){
+            return value;
+        }
+        options += (options.empty() ? "" : ", ") + std::string(choice);
+    }
+    throw std::invalid_argument("The value \"" + value + "\" of " + key + " is not one of " + options + ".");
+}
+
+
+// Set a single setting from its textual value.
+inline void setConfigValue(SimulationConfig& config, const std::string& key, const std::string& value){
+    if(key == "num_bodies"){ config.num_bodies = parseConfigNumber<std::size_t>(key, value); }
+    else if(key == "initial_conditions"){ config.initial_conditions = parseConfigChoice(key, value, {"plummer", "uniform_cube"}); }
+    else if(key == "seed"){ config.seed = parseConfigNumber<unsigned>(key, value); }
+    else if(key == "restart_from"){ config.restart_from = value; }
+    else if(key == "force_computer"){ config.force_computer = parseConfigChoice(key, value, {"direct", "parallel_direct", "simd", "barnes_hut", "fast_multipole", "particle_mesh"}); }
+    else if(key == "G"){ config.G = parseConfigNumber<double>(key, value); }
+    else if(key == "softening"){ config.softening = parseConfigNumber<double>(key, value); }
+    else if(key == "opening_angle"){ config.opening_angle = parseConfigNumber<double>(key, value); }
+    else if(key == "multipole_order"){ config.multipole_order = parseConfigNumber<unsigned>(key, value); }
+    else if(key == "grid_size"){ config.grid_size = parseConfigNumber<std::size_t>(key, value); }
+    else if(key == "integrator"){ config.integrator = parseConfigChoice(key, value, {"euler", "rk2", "rk4", "leapfrog", "dormand_prince", "block_time_step"}); }
+    else if(key == "time_step"){ config.time_step = parseConfigNumber<double>(key, value); }
+    else if(key == "num_steps"){ config.num_steps = parseConfigNumber<std::size_t>(key, value); }
+    else if(key == "tolerance"){ config.tolerance = parseConfigNumber<double>(key, value); }
+    else if(key == "output_every"){ config.output_every = parseConfigNumber<std::size_t>(key, value); }
+    else if(key == "output_path"){ config.output_path = value; }
+    else if(key == "output_layout"){ config.output_layout = parseConfigChoice(key, value, {"rows", "columns"}); }
+    else if(key == "output_compression"){ config.output_compression = parseConfigChoice(key, value, {"none", "deflate"}); }
+    else if(key == "analysis_every"){ config.analysis_every = parseConfigNumber<std::size_t>(key, value); }
+    else if(key == "analysis_path"){ config.analysis_path = value; }
+    else if(key == "checkpoint_every"){ config.checkpoint_every = parseConfigNumber<std::size_t>(key, value); }
+    else if(key == "checkpoint_path"){ config.checkpoint_path = value; }
+    else if(key == "num_threads"){ config.num_threads = parseConfigNumber<std::size_t>(key, value); }
+    else if(key == "progress_every"){ config.progress_every = parseConfigNumber<std::size_t>(key, value); }
+    else {
+        throw std::invalid_argument("Unknown setting " + key + ".");
+    }
+}
+
+
+// Set a setting from a "key = value" or "key=value" assignment.
+inline void setConfigAssignment(SimulationConfig& config, const std::string& assignment){
+    const std::size_t equals = assignment.find('=');
+    if(equals == std::string::npos){
+        throw std::invalid_argument("\"" + assignment + "\" is not of the form key = value.");
+    }
+    setConfigValue(config, trimConfigText(assignment.substr(0, equals)), trimConfigText(assignment.substr(equals + 1)));
+}
+
+
+// Read the settings in a stream into the configuration. Errors name the source and the line.
+inline void parseConfig(std::istream& input, SimulationConfig& config, const std::string& source = "the configuration"){
+    std::string line;
+    for(std::size_t line_number{1}; std::getline(input, line); ++line_number){
+        const std::string setting = trimConfigText(line.substr(0, line.find('#')));
+        if(setting.empty()){
+            continue;
+        }
+        try{
+            setConfigAssignment(config, setting);
+        } catch(const std::invalid_argument& error){
+            throw std::invalid_argument(source + ", line " + std::to_string(line_number) + ": " + error.what());
+        }
+    }
+}
+
+
+inline SimulationConfig readConfig(const std::string& path){
+    std::ifstream file(path);
+    if(!file){
+        throw std::runtime_error("Could not open the configuration file " + path + ".");
+    }
+    SimulationConfig config;
+    parseConfig(file, config, path);
+    return config;
+}
+
+
+// Check the settings that can not be checked one at a time, or only by their value.
+inline void checkConfig(const SimulationConfig& config){
+    if(config.restart_from.empty() && config.num_bodies == 0){
+        throw std::invalid_argument("A simulation needs at least one body.");
+    }
+    if(!(config.time_step > 0)){
+        throw std::invalid_argument("The time step must be positive.");
+    }
+    if(!(config.softening >= 0)){
+        throw std::invalid_argument("The softening length must not be negative.");
+    }
+    if(config.integrator == "block_time_step" && !(config.softening > 0)){
+        throw std::invalid_argument("The block_time_step integrator uses the softening length as its length scale, so it needs softening.");
+    }
+    if(config.checkpoint_every != 0 && config.checkpoint_path.empty()){
+        throw std::invalid_argument("Checkpoints need a checkpoint_path.");
+    }
+}
+
+#endif
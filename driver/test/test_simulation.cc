@@ -0,0 +1,345 @@
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "hdf5.h"
+
+#include "../include/initial_conditions.h"
+#include "../include/simulation.h"
+#include "../include/simulation_config.h"
+#include "../../io/include/star_system_reader.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+const std::string output_path = "test_simulation.h5";
+const std::string restart_output_path = "test_simulation_restart.h5";
+const std::string analysis_path = "test_simulation_analysis.h5";
+const std::string checkpoint_path = "test_simulation.ckp";
+
+
+void check_throws(const std::string& description, const std::string& config_text, const std::string& expected_message){
+    SimulationConfig config;
+    std::istringstream input(config_text);
+    try{
+        parseConfig(input, config, "test.cfg");
+        checkConfig(config);
+    } catch(const std::invalid_argument& error){
+        if(std::string(error.what()).find(expected_message) == std::string::npos){
+            throw std::runtime_error(description + " gave the wrong error: " + error.what() + "\n");
+        }
+        return;
+    }
+    throw std::runtime_error(description + " was accepted.\n");
+}
+
+
+void check_config(){
+    std::istringstream input(
+        "# A small simulation\n"
+        "num_bodies = 256\n"
+        "\n"
+        "force_computer = direct   # exact forces\n"
+        "  integrator=rk4\n"
+        "time_step = 2.5e-3\n"
+        "output_layout = columns\n"
+    );
+    SimulationConfig config;
+    parseConfig(input, config);
+    setConfigAssignment(config, "num_steps=50");
+    if(config.num_bodies != 256 || config.force_computer != "direct" || config.integrator != "rk4"
+        || config.time_step != 2.5e-3 || config.output_layout != "columns" || config.num_steps != 50){
+        throw std::runtime_error("The configuration was not read correctly.\n");
+    }
+    if(config.initial_conditions != "plummer" || config.softening != 0.01){
+        throw std::runtime_error("The settings not in the configuration do not have their defaults.\n");
+    }
+
+    check_throws("An unknown setting", "num_bodies = 10\nnum_stars = 10\n", "test.cfg, line 2: Unknown setting num_stars");
+    check_throws("A line without a value", "\n\nintegrator\n", "test.cfg, line 3");
+    check_throws("A fractional count", "num_bodies = 1.5\n", "not a valid number");
+    check_throws("A negative count", "num_steps = -10\n", "not a valid number");
+    check_throws("An unknown integrator", "integrator = verlet\n", "is not one of euler, rk2");
+    check_throws("A negative time step", "time_step = -1\n", "The time step must be positive");
+    check_throws("Block time steps without softening", "integrator = block_time_step\nsoftening = 0\n", "needs softening");
+}
+
+
+// The Plummer sphere has unit mass, is at rest at the origin, and is in virial equilibrium.
+void check_plummer_sphere(){
+    StarSystem<body_type> star_system = makePlummerSphere<body_type>(4096, 1);
+    double mass = 0.;
+    vector_type center_of_mass;
+    vector_type momentum;
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        mass += star_system.mass(b);
+        center_of_mass += star_system.mass(b) * star_system.position(b);
+        momentum += star_system.mass(b) * star_system.velocity(b);
+    }
+    if(std::abs(mass - 1.) > 1e-12 || abs(center_of_mass) > 1e-12 || abs(momentum) > 1e-12){
+        throw std::runtime_error("The Plummer sphere does not have unit mass at rest at the origin.\n");
+    }
+    DirectSumForceComputer<body_type> force_computer(1.);
+    star_system.computeForcesAndPotential(force_computer);
+    const double virial_ratio = -2. * star_system.kineticEnergy() / force_computer.potentialEnergy();
+    if(std::abs(virial_ratio - 1.) > 0.1){
+        throw std::runtime_error("The virial ratio of the Plummer sphere is " + std::to_string(virial_ratio) + ".\n");
+    }
+}
+
+
+SimulationConfig small_config(){
+    SimulationConfig config;
+    config.num_bodies = 128;
+    config.force_computer = "direct";
+    config.integrator = "leapfrog";
+    config.time_step = 1e-3;
+    config.num_steps = 40;
+    config.output_every = 10;
+    config.output_path = output_path;
+    config.analysis_every = 5;
+    config.analysis_path = analysis_path;
+    config.checkpoint_every = 20;
+    config.checkpoint_path = checkpoint_path;
+    config.num_threads = 2;
+    config.progress_every = 0;
+    return config;
+}
+
+
+hsize_t num_rows(const std::string& path, const std::string& dataset){
+    hid_t file_id = H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    hid_t dset_id = H5Dopen(file_id, dataset.c_str(), H5P_DEFAULT);
+    hid_t space_id = H5Dget_space(dset_id);
+    hsize_t dims[2];
+    H5Sget_simple_extent_dims(space_id, dims, NULL);
+    H5Sclose(space_id);
+    H5Dclose(dset_id);
+    H5Fclose(file_id);
+    return dims[0];
+}
+
+
+// Run a small simulation with all outputs, then resume a shorter run from its checkpoint, which
+// must end in the same state as the uninterrupted run.
+void check_run_and_restart(){
+    std::ostringstream log;
+    SimulationConfig config = small_config();
+    const SimulationTimes times = runSimulation<body_type>(config, log);
+    if(!(times.forces > 0) || times.integration < 0 || times.total < times.forces + times.integration){
+        throw std::runtime_error("The times of the phases are inconsistent.\n");
+    }
+    printSimulationTimes(times, log);
+    if(log.str().find("body updates per second") == std::string::npos){
+        throw std::runtime_error("The times of the phases were not printed.\n");
+    }
+
+    StarSystemReader<body_type> reader(output_path);
+    if(reader.num_timestamps() != config.num_steps / config.output_every + 1 || reader.num_bodies() != config.num_bodies){
+        throw std::runtime_error("The simulation wrote the wrong number of snapshots.\n");
+    }
+    if(num_rows(analysis_path, "energy/values") != config.num_steps / config.analysis_every + 1){
+        throw std::runtime_error("The simulation wrote the wrong number of reductions.\n");
+    }
+    const StarSystem<body_type> uninterrupted = reader.at(reader.num_timestamps() - 1).second;
+
+    // The checkpoint of step 40 replaced that of step 20, so run to step 20 again.
+    config.num_steps = 20;
+    config.output_every = 0;
+    config.analysis_every = 0;
+    runSimulation<body_type>(config, log);
+
+    // Resuming must not replace the snapshots or the reductions made before the checkpoint.
+    config.restart_from = checkpoint_path;
+    config.num_steps = 40;
+    for(const char* setting: {"output_path", "analysis_path"}){
+        SimulationConfig overwriting = config;
+        (std::string(setting) == "output_path" ? overwriting.output_every : overwriting.analysis_every) = 20;
+        try{
+            runSimulation<body_type>(overwriting, log);
+            throw std::runtime_error(std::string("The resumed simulation overwrote the file of its ") + setting + ".\n");
+        } catch(const std::invalid_argument& error){
+            if(std::string(error.what()).find(setting) == std::string::npos){
+                throw std::runtime_error(std::string("Overwriting the file of the ") + setting + " gave the wrong error: " + error.what() + "\n");
+            }
+        }
+    }
+    if(StarSystemReader<body_type>(output_path).num_timestamps() != 5 || num_rows(analysis_path, "energy/values") != 9){
+        throw std::runtime_error("The output before the checkpoint was not kept.\n");
+    }
+
+    config.output_every = 20;
+    config.output_path = restart_output_path;
+    config.checkpoint_every = 0;
+    runSimulation<body_type>(config, log);
+    {
+        StarSystemReader<body_type> restart_reader(restart_output_path);
+        if(restart_reader.num_timestamps() != 1){
+            throw std::runtime_error("The resumed simulation repeated the output of the checkpointed step.\n");
+        }
+        const std::pair<numeric_type, StarSystem<body_type>> resumed = restart_reader.at(0);
+        if(std::abs(resumed.first - 0.04) > 1e-12){
+            throw std::runtime_error("The resumed simulation ended at the wrong time.\n");
+        }
+        for(std::size_t d{0}; d < 3; ++d){
+            if(std::memcmp(resumed.second.positions().data(d), uninterrupted.positions().data(d), config.num_bodies * sizeof(numeric_type)) != 0
+                || std::memcmp(resumed.second.velocities().data(d), uninterrupted.velocities().data(d), config.num_bodies * sizeof(numeric_type)) != 0){
+                throw std::runtime_error("The resumed simulation differs from the uninterrupted one.\n");
+            }
+        }
+    }
+
+    std::remove(output_path.c_str());
+    std::remove(restart_output_path.c_str());
+    std::remove(analysis_path.c_str());
+    std::remove(checkpoint_path.c_str());
+}
+
+
+std::vector<double> last_row(const std::string& path, const std::string& dataset){
+    hid_t file_id = H5Fopen(path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    hid_t dset_id = H5Dopen(file_id, dataset.c_str(), H5P_DEFAULT);
+    hid_t space_id = H5Dget_space(dset_id);
+    hsize_t dims[2];
+    H5Sget_simple_extent_dims(space_id, dims, NULL);
+    std::vector<double> values(dims[0] * dims[1]);
+    H5Dread(dset_id, H5T_NATIVE_DOUBLE, H5S_ALL, H5S_ALL, H5P_DEFAULT, values.data());
+    H5Sclose(space_id);
+    H5Dclose(dset_id);
+    H5Fclose(file_id);
+    return std::vector<double>(values.end() - dims[1], values.end());
+}
+
+
+// The energy in the analysis is that of the positions after the step, also with the integrators
+// whose last force computation is not at the end of the step.
+void check_energy_output(){
+    for(const char* integrator: {"rk4", "block_time_step", "leapfrog"}){
+        SimulationConfig config = small_config();
+        config.integrator = integrator;
+        config.num_steps = 10;
+        config.output_every = 10;
+        config.analysis_every = 10;
+        config.checkpoint_every = 0;
+        std::ostringstream log;
+        runSimulation<body_type>(config, log);
+
+        StarSystem<body_type> star_system = StarSystemReader<body_type>(output_path).at(1).second;
+        std::unique_ptr<ForceComputerBase<body_type>> force_computer = makeForceComputer<body_type>(config);
+        star_system.computeForcesAndPotential(*force_computer);
+        const std::vector<double> energy = last_row(analysis_path, "energy/values");
+        if(std::abs(energy[1] - force_computer->potentialEnergy()) > 1e-12 * std::abs(energy[1])){
+            throw std::runtime_error(std::string("The potential energy in the analysis of the ") + integrator + " integrator is not that of the end of the step.\n");
+        }
+        std::remove(output_path.c_str());
+        std::remove(analysis_path.c_str());
+    }
+}
+
+
+// The analysis must not change the simulation, also when it computes the potential with the
+// integrators that do not leave it in their force computer.
+void check_analysis_is_passive(){
+    for(const std::pair<const char*, const char*>& choice: {std::make_pair("rk4", "particle_mesh"), std::make_pair("block_time_step", "particle_mesh")}){
+        SimulationConfig config = small_config();
+        config.integrator = choice.first;
+        config.force_computer = choice.second;
+        config.grid_size = 16;
+        config.num_steps = 20;
+        config.output_every = 5;
+        config.analysis_every = 2;
+        config.checkpoint_every = 0;
+        std::ostringstream log;
+        runSimulation<body_type>(config, log);
+        config.analysis_every = 0;
+        config.output_path = restart_output_path;
+        runSimulation<body_type>(config, log);
+        {
+            StarSystemReader<body_type> reader(output_path);
+            StarSystemReader<body_type> reader_without_analysis(restart_output_path);
+            if(reader.num_timestamps() != reader_without_analysis.num_timestamps()){
+                throw std::runtime_error("The analysis changed the number of snapshots.\n");
+            }
+            for(std::size_t s{0}; s < reader.num_timestamps(); ++s){
+                const StarSystem<body_type> with_analysis = reader.at(s).second;
+                const StarSystem<body_type> without_analysis = reader_without_analysis.at(s).second;
+                for(std::size_t d{0}; d < 3; ++d){
+                    if(std::memcmp(with_analysis.positions().data(d), without_analysis.positions().data(d), config.num_bodies * sizeof(numeric_type)) != 0
+                        || std::memcmp(with_analysis.velocities().data(d), without_analysis.velocities().data(d), config.num_bodies * sizeof(numeric_type)) != 0){
+                        throw std::runtime_error(std::string("The analysis changed the simulation with the ") + choice.first + " integrator and the " + choice.second + " force computer.\n");
+                    }
+                }
+            }
+        }
+        std::remove(output_path.c_str());
+        std::remove(restart_output_path.c_str());
+        std::remove(analysis_path.c_str());
+    }
+}
+
+
+// Snapshots and reductions at every step, so that the analysis writes its rows several times
+// while the snapshot writer is running.
+void check_interleaved_output(){
+    SimulationConfig config = small_config();
+    config.num_bodies = 64;
+    config.num_steps = 2 * analysis_rows_per_write + 3;
+    config.output_every = 1;
+    config.analysis_every = 1;
+    config.checkpoint_every = 0;
+    std::ostringstream log;
+    runSimulation<body_type>(config, log);
+    if(StarSystemReader<body_type>(output_path).num_timestamps() != config.num_steps + 1){
+        throw std::runtime_error("The simulation with output at every step wrote the wrong number of snapshots.\n");
+    }
+    for(const char* dataset: {"energy/values", "momentum/values", "center_of_mass/values", "lagrangian_radii/values"}){
+        if(num_rows(analysis_path, dataset) != config.num_steps + 1){
+            throw std::runtime_error(std::string("The simulation with output at every step wrote the wrong number of rows of ") + dataset + ".\n");
+        }
+    }
+    std::remove(output_path.c_str());
+    std::remove(analysis_path.c_str());
+}
+
+
+// Every force computer and integrator can be selected.
+void check_choices(){
+    SimulationConfig config = small_config();
+    config.num_bodies = 64;
+    config.num_steps = 2;
+    config.output_every = 0;
+    config.analysis_every = 0;
+    config.checkpoint_every = 0;
+    config.grid_size = 16;
+    std::ostringstream log;
+    for(const char* force_computer: {"direct", "parallel_direct", "simd", "barnes_hut", "fast_multipole", "particle_mesh"}){
+        config.force_computer = force_computer;
+        runSimulation<body_type>(config, log);
+    }
+    config.force_computer = "direct";
+    config.initial_conditions = "uniform_cube";
+    for(const char* integrator: {"euler", "rk2", "rk4", "leapfrog", "dormand_prince", "block_time_step"}){
+        config.integrator = integrator;
+        runSimulation<body_type>(config, log);
+    }
+}
+
+
+int main(){
+    check_config();
+    check_plummer_sphere();
+    check_run_and_restart();
+    check_energy_output();
+    check_analysis_is_passive();
+    check_interleaved_output();
+    check_choices();
+}
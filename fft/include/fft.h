@@ -0,0 +1,236 @@
+// Fast Fourier transforms of complex data whose length is a power of two.
+// FFT transforms a single sequence and FFT3D a three dimensional grid, both in place. The
+// transforms are unnormalized in the forward direction and normalized by 1/n in the inverse
+// direction, so that inverse(forward(x)) = x:
+//     forward: X_k = sum_j x_j exp(-2 pi i j k / n)
+//     inverse: x_j = (1/n) sum_k X_k exp(2 pi i j k / n)
+#ifndef FFT_H
+#define FFT_H
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+template<typename T> class FFT{
+
+    public:
+        using complex_type = std::complex<T>;
+
+        // The bit reversal permutation and the twiddle factors are computed once per size.
+        explicit FFT(const std::size_t size = 1){
+            setSize(size);
+        }
+
+        std::size_t size() const{ return _size; }
+
+        void setSize(const std::size_t size);
+
+        void forward(complex_type* data) const{
+            transform(data, false);
+        }
+
+        void inverse(complex_type* data) const{
+            transform(data, true);
+            const T normalization = T(1) / static_cast<T>(_size);
+            for(std::size_t i{0}; i < _size; ++i){
+                data[i] *= normalization;
+            }
+        }
+
+        static bool isPowerOfTwo(const std::size_t n){
+            return n != 0 && (n & (n - 1)) == 0;
+        }
+
+    private:
+        std::size_t _size = 0;
+
+        // Pairs of indices that are swapped by the bit reversal permutation.
+        std::vector<std::pair<std::size_t, std::size_t>> _swaps;
+
+        // exp(-2 pi i k / n) for k < n/2.
+        std::vector<complex_type> _twiddles;
+
+        // Iterative radix-2 Cooley-Tukey transform. The inverse transform uses the conjugate
+        // twiddle factors.
+        void transform(complex_type* data, const bool inverse) const;
+};
+
+
+template<typename T> void FFT<T>::setSize(const std::size_t size){
+    if(!isPowerOfTwo(size)){
+        throw std::invalid_argument("The size of an FFT must be a power of two, got " + std::to_string(size) + ".");
+    }
+    _size = size;
+
+    _swaps.clear();
+    for(std::size_t i{1}, j{0}; i < size; ++i){
+        std::size_t bit = size >> 1;
+        for(; j & bit; bit >>= 1){
+            j ^= bit;
+        }
+        j ^= bit;
+        if(i < j){
+            _swaps.emplace_back(i, j);
+        }
+    }
+
+    // The twiddle factors are computed directly in long double instead of by repeated
+    // multiplication, which would accumulate rounding errors.
+    const long double pi = 3.141592653589793238462643383279502884L;
+    _twiddles.resize(size / 2);
+    for(std::size_t k{0}; k < size / 2; ++k){
+        const long double angle = -2 * pi * static_cast<long double>(k) / static_cast<long double>(size);
+        _twiddles[k] = complex_type(static_cast<T>(std::cos(angle)), static_cast<T>(std::sin(angle)));
+    }
+}
+
+
+template<typename T> void FFT<T>::transform(complex_type* data, const bool inverse) const{
+    for(const auto& swap: _swaps){
+        std::swap(data[swap.first], data[swap.second]);
+    }
+    for(std::size_t length{2}; length <= _size; length <<= 1){
+        const std::size_t half = length / 2;
+        const std::size_t twiddle_stride = _size / length;
+        for(std::size_t start{0}; start < _size; start += length){
+            for(std::size_t k{0}; k < half; ++k){
+                const complex_type twiddle = (inverse ? std::conj(_twiddles[k * twiddle_stride]) : _twiddles[k * twiddle_stride]);
+                const complex_type even = data[start + k];
+                // Written out, since std::complex multiplication checks for infinities and NaNs.
+                const complex_type rhs = data[start + k + half];
+                const complex_type odd(
+                    twiddle.real() * rhs.real() - twiddle.imag() * rhs.imag(),
+                    twiddle.real() * rhs.imag() + twiddle.imag() * rhs.real()
+                );
+                data[start + k] = even + odd;
+                data[start + k + half] = even - odd;
+            }
+        }
+    }
+}
+
+
+// Transform of a three dimensional grid of size nx * ny * nz, stored with the last index running
+// fastest: element (x, y, z) is at data[(x * ny + y) * nz + z]. The grid is transformed along
+// each axis in turn. Lines along the first two axes are strided, so they are copied into a
+// contiguous buffer in batches of neighbouring lines, which reads whole cache lines at once.
+template<typename T> class FFT3D{
+
+    public:
+        using complex_type = std::complex<T>;
+
+        FFT3D(const std::size_t nx = 1, const std::size_t ny = 1, const std::size_t nz = 1){
+            setSize(nx, ny, nz);
+        }
+
+        std::size_t size(const std::size_t axis) const{ return _transforms[axis].size(); }
+
+        // Number of elements of the grid.
+        std::size_t numElements() const{ return size(0) * size(1) * size(2); }
+
+        void setSize(const std::size_t nx, const std::size_t ny, const std::size_t nz){
+            _transforms[0].setSize(nx);
+            _transforms[1].setSize(ny);
+            _transforms[2].setSize(nz);
+            _lines.resize(batch_size * std::max(nx, ny));
+        }
+
+        void forward(complex_type* data) const{
+            forward(data, size(0), size(1));
+        }
+
+        void inverse(complex_type* data) const{
+            inverse(data, size(0), size(1));
+        }
+
+        // Transforms of grids that are zero-padded along the first two axes, as used for
+        // convolutions. The forward transform assumes that the elements with x >= num_x or
+        // y >= num_y are zero, and skips the lines along z that only hold zeros. The inverse
+        // transform only computes the elements with x < num_x and y < num_y, the others are left
+        // with meaningless values.
+        void forward(complex_type* data, const std::size_t num_x, const std::size_t num_y) const{
+            transformContiguousLines(data, num_x, num_y, false);
+            transformLines(data, 1, num_x, size(1) * size(2), size(2), false);
+            transformLines(data, 0, 1, 0, size(1) * size(2), false);
+        }
+
+        void inverse(complex_type* data, const std::size_t num_x, const std::size_t num_y) const{
+            transformLines(data, 0, 1, 0, size(1) * size(2), true);
+            transformLines(data, 1, num_x, size(1) * size(2), size(2), true);
+            transformContiguousLines(data, num_x, num_y, true);
+        }
+
+    private:
+        static constexpr std::size_t batch_size = 16;
+
+        FFT<T> _transforms[3];
+
+        // Scratch space for a batch of lines of the grid, so that the transforms do not allocate.
+        mutable std::vector<complex_type> _lines;
+
+        // Transform the lines along z with x < num_x and y < num_y.
+        void transformContiguousLines(complex_type* data, const std::size_t num_x, const std::size_t num_y, const bool inverse) const;
+
+        // Transform the lines along the first or second axis. Within each of num_outer blocks of
+        // outer_stride elements, the lines start at the first num_inner elements and their
+        // elements are num_inner apart.
+        void transformLines(complex_type* data, const std::size_t axis, const std::size_t num_outer, const std::size_t outer_stride, const std::size_t num_inner, const bool inverse) const;
+};
+
+
+template<typename T> void FFT3D<T>::transformContiguousLines(complex_type* data, const std::size_t num_x, const std::size_t num_y, const bool inverse) const{
+    const FFT<T>& fft = _transforms[2];
+    for(std::size_t x{0}; x < num_x; ++x){
+        for(std::size_t y{0}; y < num_y; ++y){
+            complex_type* line = data + (x * size(1) + y) * size(2);
+            if(inverse){
+                fft.inverse(line);
+            } else {
+                fft.forward(line);
+            }
+        }
+    }
+}
+
+
+template<typename T> void FFT3D<T>::transformLines(
+    complex_type* data,
+    const std::size_t axis,
+    const std::size_t num_outer,
+    const std::size_t outer_stride,
+    const std::size_t num_inner,
+    const bool inverse) const
+{
+    const FFT<T>& fft = _transforms[axis];
+    const std::size_t n = fft.size();
+    for(std::size_t outer{0}; outer < num_outer; ++outer){
+        complex_type* block = data + outer * outer_stride;
+        for(std::size_t first{0}; first < num_inner; first += batch_size){
+            const std::size_t batch = std::min(batch_size, num_inner - first);
+            for(std::size_t i{0}; i < n; ++i){
+                for(std::size_t b{0}; b < batch; ++b){
+                    _lines[b * n + i] = block[i * num_inner + first + b];
+                }
+            }
+            for(std::size_t b{0}; b < batch; ++b){
+                if(inverse){
+                    fft.inverse(_lines.data() + b * n);
+                } else {
+                    fft.forward(_lines.data() + b * n);
+                }
+            }
+            for(std::size_t i{0}; i < n; ++i){
+                for(std::size_t b{0}; b < batch; ++b){
+                    block[i * num_inner + first + b] = _lines[b * n + i];
+                }
+            }
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,161 @@
+#include <cmath>
+#include <complex>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/fft.h"
+
+using complex_type = std::complex<double>;
+
+
+// Discrete Fourier transform by its definition, in O(n^2).
+std::vector<complex_type> naive_dft(const std::vector<complex_type>& data, const std::size_t offset, const std::size_t stride, const std::size_t n){
+    const double pi = 3.14159265358979323846;
+    std::vector<complex_type> result(n);
+    for(std::size_t k{0}; k < n; ++k){
+        for(std::size_t j{0}; j < n; ++j){
+            result[k] += data[offset + j * stride] * std::polar(1., -2 * pi * static_cast<double>(j * k % n) / static_cast<double>(n));
+        }
+    }
+    return result;
+}
+
+
+double max_difference(const std::vector<complex_type>& lhs, const std::vector<complex_type>& rhs){
+    double difference = 0.;
+    for(std::size_t i{0}; i < lhs.size(); ++i){
+        difference = std::max(difference, std::abs(lhs[i] - rhs[i]));
+    }
+    return difference;
+}
+
+
+std::vector<complex_type> random_data(const std::size_t n, std::mt19937& random_device){
+    std::uniform_real_distribution<double> uniform(-1., 1.);
+    std::vector<complex_type> data(n);
+    for(complex_type& value: data){
+        value = complex_type(uniform(random_device), uniform(random_device));
+    }
+    return data;
+}
+
+
+void check_one_dimensional(std::mt19937& random_device){
+    for(std::size_t n{1}; n <= 512; n *= 2){
+        const std::vector<complex_type> data = random_data(n, random_device);
+        const FFT<double> fft(n);
+
+        std::vector<complex_type> transformed = data;
+        fft.forward(transformed.data());
+        const double forward_error = max_difference(transformed, naive_dft(data, 0, 1, n));
+
+        fft.inverse(transformed.data());
+        const double round_trip_error = max_difference(transformed, data);
+
+        std::cout << "n = " << n << " | forward error = " << forward_error << " | round trip error = " << round_trip_error << std::endl;
+        if(forward_error > 1e-12 * n || round_trip_error > 1e-14 * n){
+            throw std::runtime_error("The FFT of size " + std::to_string(n) + " differs from the discrete Fourier transform.\n");
+        }
+    }
+}
+
+
+// The 3D transform is checked against 1D transforms along every axis of the naive DFT.
+void check_three_dimensional(std::mt19937& random_device){
+    const std::size_t nx = 4;
+    const std::size_t ny = 8;
+    const std::size_t nz = 16;
+    const std::vector<complex_type> data = random_data(nx * ny * nz, random_device);
+    const FFT3D<double> fft(nx, ny, nz);
+
+    std::vector<complex_type> expected = data;
+    for(std::size_t x{0}; x < nx; ++x){
+        for(std::size_t y{0}; y < ny; ++y){
+            const std::vector<complex_type> line = naive_dft(expected, (x * ny + y) * nz, 1, nz);
+            for(std::size_t z{0}; z < nz; ++z){
+                expected[(x * ny + y) * nz + z] = line[z];
+            }
+        }
+    }
+    for(std::size_t x{0}; x < nx; ++x){
+        for(std::size_t z{0}; z < nz; ++z){
+            const std::vector<complex_type> line = naive_dft(expected, x * ny * nz + z, nz, ny);
+            for(std::size_t y{0}; y < ny; ++y){
+                expected[(x * ny + y) * nz + z] = line[y];
+            }
+        }
+    }
+    for(std::size_t y{0}; y < ny; ++y){
+        for(std::size_t z{0}; z < nz; ++z){
+            const std::vector<complex_type> line = naive_dft(expected, y * nz + z, ny * nz, nx);
+            for(std::size_t x{0}; x < nx; ++x){
+                expected[(x * ny + y) * nz + z] = line[x];
+            }
+        }
+    }
+
+    std::vector<complex_type> transformed = data;
+    fft.forward(transformed.data());
+    const double forward_error = max_difference(transformed, expected);
+    fft.inverse(transformed.data());
+    const double round_trip_error = max_difference(transformed, data);
+
+    std::cout << "3D grid | forward error = " << forward_error << " | round trip error = " << round_trip_error << std::endl;
+    if(forward_error > 1e-10 || round_trip_error > 1e-13){
+        throw std::runtime_error("The 3D FFT differs from the discrete Fourier transform.\n");
+    }
+
+    // The transforms of a zero-padded grid skip lines, but the result has to be the same.
+    const std::size_t num_x = nx / 2;
+    const std::size_t num_y = ny / 2;
+    std::vector<complex_type> padded = data;
+    for(std::size_t x{0}; x < nx; ++x){
+        for(std::size_t y{0}; y < ny; ++y){
+            for(std::size_t z{0}; z < nz; ++z){
+                if(x >= num_x || y >= num_y){
+                    padded[(x * ny + y) * nz + z] = 0.;
+                }
+            }
+        }
+    }
+    std::vector<complex_type> expected_padded = padded;
+    fft.forward(expected_padded.data());
+    transformed = padded;
+    fft.forward(transformed.data(), num_x, num_y);
+    const double padded_forward_error = max_difference(transformed, expected_padded);
+    fft.inverse(transformed.data(), num_x, num_y);
+    double padded_round_trip_error = 0.;
+    for(std::size_t x{0}; x < num_x; ++x){
+        for(std::size_t y{0}; y < num_y; ++y){
+            for(std::size_t z{0}; z < nz; ++z){
+                const std::size_t i = (x * ny + y) * nz + z;
+                padded_round_trip_error = std::max(padded_round_trip_error, std::abs(transformed[i] - padded[i]));
+            }
+        }
+    }
+
+    std::cout << "Zero-padded 3D grid | forward error = " << padded_forward_error << " | round trip error = " << padded_round_trip_error << std::endl;
+    if(padded_forward_error > 1e-13 || padded_round_trip_error > 1e-13){
+        throw std::runtime_error("The 3D FFT of a zero-padded grid differs from the full transform.\n");
+    }
+}
+
+
+int main(){
+    std::mt19937 random_device{0};
+    check_one_dimensional(random_device);
+    check_three_dimensional(random_device);
+
+    bool thrown = false;
+    try{
+        FFT<double> fft(12);
+    } catch(const std::invalid_argument&){
+        thrown = true;
+    }
+    if(!thrown){
+        throw std::runtime_error("An FFT whose size is not a power of two was accepted.\n");
+    }
+}
@@ -0,0 +1,45 @@
+// Policies selecting at compile time what a force computer accumulates for every pair of bodies.
+// Force computers template their inner loops on a policy, so the per-pair work is known to the
+// compiler and can be fully inlined, instead of going through a function pointer for each pair.
+#ifndef AccumulationPolicy_H
+#define AccumulationPolicy_H
+
+// Only the forces are needed, e.g. for the intermediate stages of an integrator.
+struct ForcePolicy{
+    static constexpr bool with_potential = false;
+
+    // Force exerted on the lhs body by the rhs body.
+    template<typename ForceComputerType, typename VectorType, typename NumericType> static VectorType pairwise(
+        const ForceComputerType& force_computer,
+        const VectorType& lhs_position,
+        const NumericType lhs_mass,
+        const VectorType& rhs_position,
+        const NumericType rhs_mass,
+        NumericType&)
+    {
+        return force_computer.pairwiseForce(lhs_position, lhs_mass, rhs_position, rhs_mass);
+    }
+};
+
+
+// Both the forces and the potential energy are needed.
+struct ForceAndPotentialPolicy{
+    static constexpr bool with_potential = true;
+
+    // Force exerted on the lhs body by the rhs body. The potential energy of the pair is added to
+    // potential.
+    template<typename ForceComputerType, typename VectorType, typename NumericType> static VectorType pairwise(
+        const ForceComputerType& force_computer,
+        const VectorType& lhs_position,
+        const NumericType lhs_mass,
+        const VectorType& rhs_position,
+        const NumericType rhs_mass,
+        NumericType& potential)
+    {
+        auto force_and_potential = force_computer.pairwiseForceAndPotential(lhs_position, lhs_mass, rhs_position, rhs_mass);
+        potential += force_and_potential.second;
+        return force_and_potential.first;
+    }
+};
+
+#endif
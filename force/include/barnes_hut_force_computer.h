@@ -0,0 +1,120 @@
+// Barnes-Hut force computation.
+// The bodies are sorted into an octree (a quadtree for 2D vectors), and the pull of a cell that
+// is far enough away from a body is approximated by that of a single body with the total mass of
+// the cell, placed at its center of mass. This reduces the cost of a force computation from
+// O(N^2) to O(N log N).
+#ifndef BarnesHutForceComputer_H
+#define BarnesHutForceComputer_H
+
+#include <vector>
+
+#include "accumulation_policy.h"
+#include "force_computer_base.h"
+#include "octree.h"
+
+
+template<typename BodyType> class BarnesHutForceComputer: public ForceComputerBase<BodyType>{
+
+    public:
+        using numeric_type = typename ForceComputerBase<BodyType>::numeric_type;
+        using vector_type = typename ForceComputerBase<BodyType>::vector_type;
+        using ForceComputerBase<BodyType>::pairwiseForce;
+        using ForceComputerBase<BodyType>::pairwiseForceAndPotential;
+
+        // The opening angle theta sets the accuracy of the approximation. A cell of side length s
+        // at a distance d is approximated by its center of mass if s/d < theta. A value of 0
+        // reduces to an exact direct summation, typical values are between 0.3 and 1.
+        BarnesHutForceComputer(const numeric_type G = 1., const numeric_type opening_angle = 0.5, const std::size_t leaf_size = 1):
+            ForceComputerBase<BodyType>(G),
+            _opening_angle(opening_angle),
+            _tree(leaf_size)
+        {}
+
+        numeric_type openingAngle() const{ return _opening_angle; }
+        void setOpeningAngle(const numeric_type opening_angle){ _opening_angle = opening_angle; }
+
+    protected:
+        virtual void computeForcesImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForcePolicy>(star_system);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForceAndPotentialPolicy>(star_system);
+        }
+
+        // Only the active bodies walk the tree, but all bodies are needed to build it.
+        virtual void computeSubsetForcesImpl(const StarSystem<BodyType>& star_system, const std::vector<std::size_t>& active_bodies) override{
+            _tree.build(star_system);
+            for(const std::size_t b: active_bodies){
+                walkTree<ForcePolicy>(star_system, b);
+            }
+        }
+
+    private:
+        using Node = typename Octree<BodyType>::Node;
+        using ForceComputerBase<BodyType>::_forces;
+        using ForceComputerBase<BodyType>::_potential;
+
+        numeric_type _opening_angle;
+        Octree<BodyType> _tree;
+
+        // Nodes that still have to be visited during the tree walk of a single body.
+        std::vector<std::size_t> _stack;
+
+        template<typename AccumulationPolicy> void computeAllTerms(const StarSystem<BodyType>& star_system){
+            _tree.build(star_system);
+            for(std::size_t b{0}; b < star_system.size(); ++b){
+                walkTree<AccumulationPolicy>(star_system, b);
+            }
+
+            // Every pair of bodies was counted twice, once for each body in the pair.
+            if(AccumulationPolicy::with_potential){
+                _potential /= 2;
+            }
+        }
+
+        template<typename AccumulationPolicy> void walkTree(const StarSystem<BodyType>& star_system, const std::size_t body_index){
+            const vector_type position = star_system.position(body_index);
+            const numeric_type mass = star_system.mass(body_index);
+            const numeric_type opening_angle_squared = _opening_angle * _opening_angle;
+
+            _stack.clear();
+            _stack.push_back(0);
+            while(!_stack.empty()){
+                const Node& node = _tree[_stack.back()];
+                _stack.pop_back();
+                if(node.mass == 0){
+                    continue;
+                }
+
+                if(node.isLeaf()){
+                    for(std::size_t k{node.begin}; k < node.end; ++k){
+                        const std::size_t other_index = _tree.bodyIndex(k);
+                        if(other_index == body_index){
+                            continue;
+                        }
+                        _forces[body_index] += AccumulationPolicy::pairwise(
+                            *this, position, mass, star_system.position(other_index), star_system.mass(other_index), _potential
+                        );
+                    }
+                    continue;
+                }
+
+                // A cell containing the body itself is always opened, so that no body ever
+                // attracts itself.
+                const numeric_type size = 2 * node.half_size;
+                const numeric_type distance_squared = square(node.center_of_mass - position);
+                if(size * size < opening_angle_squared * distance_squared && !Octree<BodyType>::contains(node, position)){
+                    _forces[body_index] += AccumulationPolicy::pairwise(
+                        *this, position, mass, node.center_of_mass, node.mass, _potential
+                    );
+                } else {
+                    for(std::size_t c{0}; c < node.num_children; ++c){
+                        _stack.push_back(node.first_child + c);
+                    }
+                }
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,270 @@
+// Cartesian multipole and local expansions of the gravitational potential 1/r in 3D, up to a
+// configurable order p. Coefficients are indexed by multi-indices k = (k_x, k_y, k_z) with
+// |k| = k_x + k_y + k_z <= p, ordered by |k|.
+//
+// With x^k = x_x^k_x x_y^k_y x_z^k_z and k! = k_x! k_y! k_z!, the expansions are:
+//     multipole of sources j about z:    M_k = sum_j m_j (x_j - z)^k
+//     potential at x far from z:         phi(x) = sum_k (-1)^|k| M_k T_k(x - z)
+//     local expansion about z:           phi(z + s) = sum_n L_n s^n
+// where T_k(r) = (1/k!) d^k/dr^k 1/|r| are the Taylor coefficients of 1/|r|. They follow from the
+// recurrence, with n = |k| and e_i the unit multi-indices,
+//     n |r|^2 T_k = -(2n - 1) sum_i r_i T_{k - e_i} - (n - 1) sum_i T_{k - 2e_i}
+// The translations between expansions are
+//     M2M: M'_k = sum_{q <= k} C(k, q) t^{k - q} M_q                  (t = old center - new center)
+//     M2L: L_n = sum_k (-1)^|k| C(k + n, k) M_k T_{k + n}(R)          (R = local center - multipole center)
+//     L2L: L'_q = sum_{n >= q} C(n, q) t^{n - q} L_n                 (t = new center - old center)
+// with C(k, q) the product of the binomial coefficients of the components.
+#ifndef CartesianExpansion_H
+#define CartesianExpansion_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+template<typename T> class CartesianExpansion{
+
+    public:
+        using point_type = std::array<T, 3>;
+
+        explicit CartesianExpansion(const unsigned order = 4){
+            setOrder(order);
+        }
+
+        unsigned order() const{ return _order; }
+
+        // Number of coefficients of an expansion.
+        std::size_t size() const{ return _multi_indices.size(); }
+
+        const std::array<unsigned, 3>& multiIndex(const std::size_t index) const{ return _multi_indices[index]; }
+
+        void setOrder(const unsigned order);
+
+        // x^k for every multi-index k.
+        void monomials(const point_type& x, T* result) const;
+
+        // T_k(r) for every multi-index k.
+        void derivatives(const point_type& r, T* result) const;
+
+        // Add a point mass at offset d from the center to a multipole expansion.
+        void addMass(const point_type& d, const T mass, T* multipole) const;
+
+        // Add a multipole expansion about a center at offset t from the new center.
+        void translateMultipole(const T* multipole, const point_type& t, T* result) const;
+
+        // Add the local expansion of the pull of a multipole expansion at separation R.
+        void multipoleToLocal(const T* multipole, const point_type& R, T* local) const;
+
+        // Add a local expansion, shifted to a center at offset t from its center.
+        void translateLocal(const T* local, const point_type& t, T* result) const;
+
+        // Potential and its gradient at offset s from the center of a local expansion.
+        void evaluateLocal(const T* local, const point_type& s, T& potential, point_type& gradient) const;
+
+    private:
+        // A term coefficient * lhs[lhs_index] * rhs[rhs_index] of a sum.
+        struct Term{
+            std::uint32_t lhs_index;
+            std::uint32_t rhs_index;
+            T coefficient;
+        };
+
+        // The terms of an operator, grouped by the coefficient of the result they add to. The
+        // terms of result coefficient i are [offsets[i], offsets[i + 1]).
+        struct Operator{
+            std::vector<Term> terms;
+            std::vector<std::size_t> offsets;
+
+            void apply(const T* lhs, const T* rhs, T* result) const{
+                for(std::size_t i{0}; i + 1 < offsets.size(); ++i){
+                    T sum = 0;
+                    for(std::size_t t{offsets[i]}; t < offsets[i + 1]; ++t){
+                        sum += terms[t].coefficient * lhs[terms[t].lhs_index] * rhs[terms[t].rhs_index];
+                    }
+                    result[i] += sum;
+                }
+            }
+        };
+
+        unsigned _order = 0;
+        std::vector<std::array<unsigned, 3>> _multi_indices;
+
+        // Index of the multi-index (k_x, k_y, k_z), stored densely over [0, p]^3.
+        std::vector<std::size_t> _index;
+
+        // Per multi-index, the indices of k - e_i and k - 2e_i, or size() if a component would be
+        // negative.
+        std::vector<std::array<std::size_t, 3>> _minus_one;
+        std::vector<std::array<std::size_t, 3>> _minus_two;
+
+        Operator _m2m;
+        Operator _m2l;
+        Operator _l2l;
+
+        // Scratch space, so that the operators do not allocate.
+        mutable std::vector<T> _scratch;
+
+        std::size_t index(const unsigned kx, const unsigned ky, const unsigned kz) const{
+            return _index[(kx * (_order + 1) + ky) * (_order + 1) + kz];
+        }
+
+        static T binomial(const unsigned n, const unsigned k){
+            T result = 1;
+            for(unsigned i{1}; i <= k; ++i){
+                result = result * static_cast<T>(n - k + i) / static_cast<T>(i);
+            }
+            return result;
+        }
+};
+
+
+template<typename T> void CartesianExpansion<T>::setOrder(const unsigned order){
+    _order = order;
+    _multi_indices.clear();
+    _index.assign((order + 1) * (order + 1) * (order + 1), 0);
+    for(unsigned n{0}; n <= order; ++n){
+        for(unsigned kx{n + 1}; kx-- > 0;){
+            for(unsigned ky{n - kx + 1}; ky-- > 0;){
+                const unsigned kz = n - kx - ky;
+                _index[(kx * (order + 1) + ky) * (order + 1) + kz] = _multi_indices.size();
+                _multi_indices.push_back({kx, ky, kz});
+            }
+        }
+    }
+
+    _minus_one.resize(size());
+    _minus_two.resize(size());
+    for(std::size_t i{0}; i < size(); ++i){
+        for(std::size_t d{0}; d < 3; ++d){
+            std::array<unsigned, 3> k = _multi_indices[i];
+            _minus_one[i][d] = size();
+            _minus_two[i][d] = size();
+            if(k[d] >= 1){
+                --k[d];
+                _minus_one[i][d] = index(k[0], k[1], k[2]);
+            }
+            if(k[d] >= 1){
+                --k[d];
+                _minus_two[i][d] = index(k[0], k[1], k[2]);
+            }
+        }
+    }
+
+    std::vector<std::vector<Term>> m2m_terms(size());
+    std::vector<std::vector<Term>> m2l_terms(size());
+    std::vector<std::vector<Term>> l2l_terms(size());
+    for(std::uint32_t i{0}; i < size(); ++i){
+        const std::array<unsigned, 3>& k = _multi_indices[i];
+        for(std::uint32_t j{0}; j < size(); ++j){
+            const std::array<unsigned, 3>& q = _multi_indices[j];
+
+            // M2M and L2L pair every multi-index with those it dominates.
+            if(q[0] <= k[0] && q[1] <= k[1] && q[2] <= k[2]){
+                const T coefficient = binomial(k[0], q[0]) * binomial(k[1], q[1]) * binomial(k[2], q[2]);
+                const std::uint32_t difference = index(k[0] - q[0], k[1] - q[1], k[2] - q[2]);
+                m2m_terms[i].push_back({j, difference, coefficient});
+                l2l_terms[j].push_back({i, difference, coefficient});
+            }
+
+            // M2L pairs every local coefficient n = k with every multipole moment q such that
+            // the expansion stays within the order.
+            const unsigned total_order = k[0] + k[1] + k[2] + q[0] + q[1] + q[2];
+            if(total_order <= order){
+                T coefficient = binomial(k[0] + q[0], q[0]) * binomial(k[1] + q[1], q[1]) * binomial(k[2] + q[2], q[2]);
+                if((q[0] + q[1] + q[2]) % 2 == 1){
+                    coefficient = -coefficient;
+                }
+                m2l_terms[i].push_back({j, static_cast<std::uint32_t>(index(k[0] + q[0], k[1] + q[1], k[2] + q[2])), coefficient});
+            }
+        }
+    }
+    for(auto op_and_terms: {std::make_pair(&_m2m, &m2m_terms), std::make_pair(&_m2l, &m2l_terms), std::make_pair(&_l2l, &l2l_terms)}){
+        Operator& op = *op_and_terms.first;
+        op.terms.clear();
+        op.offsets.assign(1, 0);
+        for(const std::vector<Term>& terms: *op_and_terms.second){
+            op.terms.insert(op.terms.end(), terms.begin(), terms.end());
+            op.offsets.push_back(op.terms.size());
+        }
+    }
+    _scratch.resize(size());
+}
+
+
+template<typename T> void CartesianExpansion<T>::monomials(const point_type& x, T* result) const{
+    result[0] = 1;
+    for(std::size_t i{1}; i < size(); ++i){
+        std::size_t d{0};
+        while(_minus_one[i][d] == size()){
+            ++d;
+        }
+        result[i] = result[_minus_one[i][d]] * x[d];
+    }
+}
+
+
+template<typename T> void CartesianExpansion<T>::derivatives(const point_type& r, T* result) const{
+    const T distance_squared = r[0] * r[0] + r[1] * r[1] + r[2] * r[2];
+    const T inverse_distance_squared = 1 / distance_squared;
+    result[0] = std::sqrt(inverse_distance_squared);
+    for(std::size_t i{1}; i < size(); ++i){
+        const std::array<unsigned, 3>& k = _multi_indices[i];
+        const unsigned n = k[0] + k[1] + k[2];
+        T first = 0;
+        T second = 0;
+        for(std::size_t d{0}; d < 3; ++d){
+            if(_minus_one[i][d] != size()){
+                first += r[d] * result[_minus_one[i][d]];
+            }
+            if(_minus_two[i][d] != size()){
+                second += result[_minus_two[i][d]];
+            }
+        }
+        result[i] = -(static_cast<T>(2 * n - 1) * first + static_cast<T>(n - 1) * second) * inverse_distance_squared / static_cast<T>(n);
+    }
+}
+
+
+template<typename T> void CartesianExpansion<T>::addMass(const point_type& d, const T mass, T* multipole) const{
+    monomials(d, _scratch.data());
+    for(std::size_t i{0}; i < size(); ++i){
+        multipole[i] += mass * _scratch[i];
+    }
+}
+
+
+template<typename T> void CartesianExpansion<T>::translateMultipole(const T* multipole, const point_type& t, T* result) const{
+    monomials(t, _scratch.data());
+    _m2m.apply(multipole, _scratch.data(), result);
+}
+
+
+template<typename T> void CartesianExpansion<T>::multipoleToLocal(const T* multipole, const point_type& R, T* local) const{
+    derivatives(R, _scratch.data());
+    _m2l.apply(multipole, _scratch.data(), local);
+}
+
+
+template<typename T> void CartesianExpansion<T>::translateLocal(const T* local, const point_type& t, T* result) const{
+    monomials(t, _scratch.data());
+    _l2l.apply(local, _scratch.data(), result);
+}
+
+
+template<typename T> void CartesianExpansion<T>::evaluateLocal(const T* local, const point_type& s, T& potential, point_type& gradient) const{
+    monomials(s, _scratch.data());
+    potential = 0;
+    gradient = point_type{};
+    for(std::size_t i{0}; i < size(); ++i){
+        potential += local[i] * _scratch[i];
+        for(std::size_t d{0}; d < 3; ++d){
+            if(_minus_one[i][d] != size()){
+                gradient[d] += static_cast<T>(_multi_indices[i][d]) * local[i] * _scratch[_minus_one[i][d]];
+            }
+        }
+    }
+}
+
+#endif
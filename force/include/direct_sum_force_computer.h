@@ -2,75 +2,111 @@
 #define DirectSumForceComputer_H
 
 #include <algorithm>
+#include <unistd.h>
 
+#include "accumulation_policy.h"
 #include "force_computer_base.h"
 
 
+// The pairs of bodies are traversed in tiles: a block of bodies i is combined with a block of
+// bodies j before moving on to the next block of j. A block stays in the cache while the other
+// blocks stream past it, instead of the whole star system being streamed from memory for every
+// body. Each pair is still only computed once.
 template<typename BodyType> class DirectSumForceComputer: public ForceComputerBase<BodyType>{
 
     public:
+        using numeric_type = typename ForceComputerBase<BodyType>::numeric_type;
         using ForceComputerBase<BodyType>::pairwiseForce;
         using ForceComputerBase<BodyType>::pairwiseForceAndPotential;
 
-    protected:
-        virtual void computeForcesImpl(const StarSystem<BodyType>& star_system) override{
-            computeAllTerms(star_system, &DirectSumForceComputer<BodyType>::addForceComponent);
-        }
+        // A tile size of 0 selects one based on the size of the L1 data cache.
+        DirectSumForceComputer(const numeric_type G = 1., const std::size_t tile_size = 0):
+            ForceComputerBase<BodyType>(G),
+            _tile_size(tile_size == 0 ? automaticTileSize() : tile_size)
+        {}
 
-        virtual void computeForcesAndPotentialImpl(const StarSystem<BodyType>& star_system) override{
-            computeAllTerms(star_system, &DirectSumForceComputer<BodyType>::addForceAndPotentialComponent);
+        std::size_t tileSize() const{ return _tile_size; }
+        void setTileSize(const std::size_t tile_size){ _tile_size = (tile_size == 0 ? automaticTileSize() : tile_size); }
+
+        // Number of bodies per tile such that the positions, masses and forces of two tiles fill
+        // half of the L1 data cache.
+        static std::size_t automaticTileSize(){
+            long cache_size = -1;
+#ifdef _SC_LEVEL1_DCACHE_SIZE
+            cache_size = sysconf(_SC_LEVEL1_DCACHE_SIZE);
+#endif
+            if(cache_size <= 0){
+                cache_size = 32768;
+            }
+            constexpr std::size_t bytes_per_body = sizeof(typename BodyType::vector_type) * 2 + sizeof(numeric_type);
+            return std::max(static_cast<std::size_t>(cache_size) / (4 * bytes_per_body), std::size_t{16});
         }
 
-    private:
+    protected:
         using vector_type = typename ForceComputerBase<BodyType>::vector_type;
         using ForceComputerBase<BodyType>::_forces;
         using ForceComputerBase<BodyType>::_potential;
-        using ForceComputerBase<BodyType>::ForceComputerBase;
 
-        void addForceComponent(
-            const StarSystem<BodyType>& star_system,
-            const std::size_t lhs_index,
-            const std::size_t rhs_index
-        ){
-            // Compute the force from body i on body j.
-            vector_type pairwise_force{
-                pairwiseForce(star_system[lhs_index], star_system[rhs_index])
-            };
-            _forces[lhs_index] += pairwise_force;
-
-            // The force of body j on body i is the inverse of that of body i on body j.
-            _forces[rhs_index] -= pairwise_force;
+        virtual void computeForcesImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForcePolicy>(star_system);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForceAndPotentialPolicy>(star_system);
         }
 
-        void addForceAndPotentialComponent(
+        // Add the forces between all pairs of bodies i in [lhs_begin, lhs_end) and j in
+        // [rhs_begin, rhs_end) with j > i, and return the potential energy of these pairs if the
+        // policy computes it.
+        template<typename AccumulationPolicy> numeric_type computeTile(
             const StarSystem<BodyType>& star_system,
-            const std::size_t lhs_index,
-            const std::size_t rhs_index
-        ){
-            // Compute the force from body i on body j and the contribution to the potential energy.
-            // The first component of the returned pair is the force and the second the potential.
-            auto force_and_potential = 
-                pairwiseForceAndPotential(star_system[lhs_index], star_system[rhs_index]);
-            _forces[lhs_index] += force_and_potential.first;
-            _forces[rhs_index] -= force_and_potential.first;
-            
+            const std::size_t lhs_begin,
+            const std::size_t lhs_end,
+            const std::size_t rhs_begin,
+            const std::size_t rhs_end)
+        {
+            numeric_type potential = 0.;
+            for(std::size_t i{lhs_begin}; i < lhs_end; ++i){
+                const vector_type position = star_system.position(i);
+                const numeric_type mass = star_system.mass(i);
+
+                // On the diagonal tiles only the pairs with j > i are needed.
+                for(std::size_t j{std::max(rhs_begin, i + 1)}; j < rhs_end; ++j){
+
+                    // Compute the force from body j on body i. If the policy requires it, the
+                    // contribution of the pair to the potential energy is added as well.
+                    vector_type pairwise_force{AccumulationPolicy::pairwise(
+                        *this, position, mass, star_system.position(j), star_system.mass(j), potential
+                    )};
+                    _forces[i] += pairwise_force;
+
+                    // The force of body i on body j is the inverse of that of body j on body i.
+                    _forces[j] -= pairwise_force;
+                }
+            }
+
             // The potential energy body i has due to body j's gravitation is the same as the
             // potential energy body j has due to body i's gravitation. The potential energy for
             // each body has a factor 1/2 preceding it. We can thus simply sum a potential energy
             // without this factor and account for both bodies in the pair.
-            _potential += force_and_potential.second;
+            return potential;
         }
 
-        void computeAllTerms(
-            const StarSystem<BodyType>& star_system,
-            void (DirectSumForceComputer<BodyType>::*addComponent)(const StarSystem<BodyType>& star_system, const std::size_t, const std::size_t)
-        ){
-            for(std::size_t i{0U}; i < star_system.size() - 1; ++i){
-                for(std::size_t j{i+1}; j < star_system.size(); ++j){
-                    (this->*addComponent)(star_system, i, j);
+    private:
+        std::size_t _tile_size;
+
+        template<typename AccumulationPolicy> void computeAllTerms(const StarSystem<BodyType>& star_system){
+            const std::size_t num_bodies = star_system.size();
+            for(std::size_t lhs_begin{0U}; lhs_begin < num_bodies; lhs_begin += _tile_size){
+                const std::size_t lhs_end = std::min(lhs_begin + _tile_size, num_bodies);
+                for(std::size_t rhs_begin{lhs_begin}; rhs_begin < num_bodies; rhs_begin += _tile_size){
+                    const std::size_t rhs_end = std::min(rhs_begin + _tile_size, num_bodies);
+                    numeric_type potential = computeTile<AccumulationPolicy>(star_system, lhs_begin, lhs_end, rhs_begin, rhs_end);
+                    if(AccumulationPolicy::with_potential){
+                        _potential += potential;
+                    }
                 }
             }
-
         }
 };
 
@@ -0,0 +1,236 @@
+// Fast multipole method (FMM) force computation.
+// Like Barnes-Hut, the bodies are sorted into an octree and every cell gets a multipole expansion
+// of its mass distribution. Instead of evaluating these expansions for every body, the pull of a
+// distant cell on a whole group of bodies is converted into a single local expansion about the
+// center of the group, which is passed down the tree and only evaluated at the bodies in the end.
+// Pairs of cells are found with a dual tree walk. For a fixed accuracy the cost grows as O(N)
+// instead of O(N log N).
+//
+// The expansions are Cartesian, see CartesianExpansion, and the order of the expansions sets the
+// accuracy together with the opening angle. Only 3D vectors are supported.
+//
+// Softening is applied to the direct interactions between nearby bodies only. The expansions are
+// those of point masses, which is accurate as long as the softening length is much smaller than
+// the cells that are approximated.
+#ifndef FastMultipoleForceComputer_H
+#define FastMultipoleForceComputer_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "accumulation_policy.h"
+#include "cartesian_expansion.h"
+#include "force_computer_base.h"
+#include "octree.h"
+#include "../../vector/include/vector_traits.h"
+
+
+template<typename BodyType> class FastMultipoleForceComputer: public ForceComputerBase<BodyType>{
+
+    public:
+        using numeric_type = typename ForceComputerBase<BodyType>::numeric_type;
+        using vector_type = typename ForceComputerBase<BodyType>::vector_type;
+        using ForceComputerBase<BodyType>::pairwiseForce;
+        using ForceComputerBase<BodyType>::pairwiseForceAndPotential;
+
+        static_assert(vector_traits<vector_type>::dimension == 3, "The fast multipole method is only implemented for 3D vectors.");
+
+        // Two cells interact through their expansions if the sum of their radii is less than the
+        // opening angle times the distance between their centers. The error decreases with the
+        // order of the expansions and increases with the opening angle.
+        FastMultipoleForceComputer(
+            const numeric_type G = 1.,
+            const unsigned order = 4,
+            const numeric_type opening_angle = 0.5,
+            const std::size_t leaf_size = 64
+        ):
+            ForceComputerBase<BodyType>(G),
+            _opening_angle(opening_angle),
+            _tree(leaf_size),
+            _expansion(checkOrder(order))
+        {}
+
+        unsigned order() const{ return _expansion.order(); }
+        void setOrder(const unsigned order){ _expansion.setOrder(checkOrder(order)); }
+
+        numeric_type openingAngle() const{ return _opening_angle; }
+        void setOpeningAngle(const numeric_type opening_angle){ _opening_angle = opening_angle; }
+
+    protected:
+        virtual void computeForcesImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForcePolicy>(star_system);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForceAndPotentialPolicy>(star_system);
+        }
+
+    private:
+        using Node = typename Octree<BodyType>::Node;
+        using point_type = typename CartesianExpansion<numeric_type>::point_type;
+        using traits = vector_traits<vector_type>;
+        using ForceComputerBase<BodyType>::_forces;
+        using ForceComputerBase<BodyType>::_potential;
+
+        numeric_type _opening_angle;
+        Octree<BodyType> _tree;
+        CartesianExpansion<numeric_type> _expansion;
+
+        // Expansion coefficients of all nodes, stored contiguously per node.
+        std::vector<numeric_type> _multipoles;
+        std::vector<numeric_type> _locals;
+
+        // Radius around the center of mass of every node that contains all its bodies.
+        std::vector<numeric_type> _radii;
+
+        // Pairs of target and source nodes that still have to be visited during the tree walk.
+        std::vector<std::pair<std::size_t, std::size_t>> _stack;
+
+        // The force is the gradient of the local expansions, which vanishes at order 0.
+        static unsigned checkOrder(const unsigned order){
+            if(order == 0){
+                throw std::invalid_argument("The order of the fast multipole expansions must be at least 1.");
+            }
+            return order;
+        }
+
+        static point_type toPoint(const vector_type& vec){
+            return {traits::component(vec, 0), traits::component(vec, 1), traits::component(vec, 2)};
+        }
+
+        template<typename AccumulationPolicy> void computeAllTerms(const StarSystem<BodyType>& star_system){
+            if(star_system.size() == 0){
+                return;
+            }
+            _tree.build(star_system);
+            upwardPass(star_system);
+            walkTree<AccumulationPolicy>(star_system);
+            downwardPass<AccumulationPolicy>(star_system);
+
+            // Every pair of bodies was counted twice, once for each body in the pair.
+            if(AccumulationPolicy::with_potential){
+                _potential /= 2;
+            }
+        }
+
+        // Multipole expansions of the leaves from their bodies, and of the other nodes from their
+        // children. Children are always stored after their parent, so a backward sweep over the
+        // nodes visits the children first.
+        void upwardPass(const StarSystem<BodyType>& star_system){
+            const std::size_t size = _expansion.size();
+            _multipoles.assign(_tree.size() * size, 0.);
+            _radii.assign(_tree.size(), 0.);
+            for(std::size_t n{_tree.size()}; n-- > 0;){
+                const Node& node = _tree[n];
+                numeric_type* multipole = _multipoles.data() + n * size;
+                numeric_type radius = 0.;
+                if(node.isLeaf()){
+                    for(std::size_t k{node.begin}; k < node.end; ++k){
+                        const std::size_t b = _tree.bodyIndex(k);
+                        const vector_type offset = star_system.position(b) - node.center_of_mass;
+                        _expansion.addMass(toPoint(offset), star_system.mass(b), multipole);
+                        radius = std::max(radius, abs(offset));
+                    }
+                } else {
+                    for(std::size_t c{node.first_child}; c < node.first_child + node.num_children; ++c){
+                        const vector_type offset = _tree[c].center_of_mass - node.center_of_mass;
+                        _expansion.translateMultipole(_multipoles.data() + c * size, toPoint(offset), multipole);
+                        radius = std::max(radius, abs(offset) + _radii[c]);
+                    }
+
+                    // The cell itself bounds the distance to its bodies as well.
+                    radius = std::min(radius, abs(node.center_of_mass - node.center) + std::sqrt(numeric_type(3)) * node.half_size);
+                }
+                _radii[n] = radius;
+            }
+        }
+
+        // Dual tree walk over pairs of a target node and a source node. Well separated pairs add
+        // the multipole expansion of the source to the local expansion of the target, pairs of
+        // nearby leaves interact directly, and all other pairs are split.
+        template<typename AccumulationPolicy> void walkTree(const StarSystem<BodyType>& star_system){
+            const std::size_t size = _expansion.size();
+            _locals.assign(_tree.size() * size, 0.);
+            const numeric_type opening_angle_squared = _opening_angle * _opening_angle;
+
+            _stack.clear();
+            _stack.emplace_back(0, 0);
+            while(!_stack.empty()){
+                const std::size_t target_index = _stack.back().first;
+                const std::size_t source_index = _stack.back().second;
+                _stack.pop_back();
+                const Node& target = _tree[target_index];
+                const Node& source = _tree[source_index];
+                if(source.mass == 0){
+                    continue;
+                }
+
+                const vector_type separation = target.center_of_mass - source.center_of_mass;
+                const numeric_type radii = _radii[target_index] + _radii[source_index];
+                if(radii * radii < opening_angle_squared * square(separation)){
+                    _expansion.multipoleToLocal(_multipoles.data() + source_index * size, toPoint(separation), _locals.data() + target_index * size);
+                } else if(target.isLeaf() && source.isLeaf()){
+                    directInteraction<AccumulationPolicy>(star_system, target, source);
+                } else if(source.isLeaf() || (!target.isLeaf() && _radii[target_index] >= _radii[source_index])){
+                    for(std::size_t c{target.first_child}; c < target.first_child + target.num_children; ++c){
+                        _stack.emplace_back(c, source_index);
+                    }
+                } else {
+                    for(std::size_t c{source.first_child}; c < source.first_child + source.num_children; ++c){
+                        _stack.emplace_back(target_index, c);
+                    }
+                }
+            }
+        }
+
+        // Pull of the bodies of the source leaf on the bodies of the target leaf.
+        template<typename AccumulationPolicy> void directInteraction(const StarSystem<BodyType>& star_system, const Node& target, const Node& source){
+            for(std::size_t k{target.begin}; k < target.end; ++k){
+                const std::size_t i = _tree.bodyIndex(k);
+                const vector_type position = star_system.position(i);
+                const numeric_type mass = star_system.mass(i);
+                vector_type force;
+                for(std::size_t l{source.begin}; l < source.end; ++l){
+                    const std::size_t j = _tree.bodyIndex(l);
+                    if(j != i){
+                        force += AccumulationPolicy::pairwise(*this, position, mass, star_system.position(j), star_system.mass(j), _potential);
+                    }
+                }
+                _forces[i] += force;
+            }
+        }
+
+        // Local expansions are shifted from every node to its children, and evaluated at the
+        // bodies in the leaves.
+        template<typename AccumulationPolicy> void downwardPass(const StarSystem<BodyType>& star_system){
+            const std::size_t size = _expansion.size();
+            for(std::size_t n{0}; n < _tree.size(); ++n){
+                const Node& node = _tree[n];
+                const numeric_type* local = _locals.data() + n * size;
+                if(!node.isLeaf()){
+                    for(std::size_t c{node.first_child}; c < node.first_child + node.num_children; ++c){
+                        const vector_type offset = _tree[c].center_of_mass - node.center_of_mass;
+                        _expansion.translateLocal(local, toPoint(offset), _locals.data() + c * size);
+                    }
+                    continue;
+                }
+                for(std::size_t k{node.begin}; k < node.end; ++k){
+                    const std::size_t b = _tree.bodyIndex(k);
+                    const numeric_type mass = star_system.mass(b);
+                    numeric_type potential;
+                    point_type gradient;
+                    _expansion.evaluateLocal(local, toPoint(star_system.position(b) - node.center_of_mass), potential, gradient);
+                    _forces[b] += mass * traits::make(gradient);
+                    if(AccumulationPolicy::with_potential){
+                        _potential += mass * potential;
+                    }
+                }
+            }
+        }
+};
+
+#endif
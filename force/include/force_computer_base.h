@@ -3,11 +3,14 @@
 #ifndef ForceComputer_H
 #define ForceComputer_H
 
+#include <chrono>
 // For std::pair.
 #include <utility>
 #include <vector>
 
+#include "softening_kernel.h"
 #include "../../body/include/body.h"
+#include "../../body/include/checkpoint_state.h"
 #include "../../body/include/star_system.h"
 #include "../../vector/include/vector_math.h"
 
@@ -32,19 +35,70 @@ template<typename BodyType> class ForceComputerBase{
         // Precompute the forces exerted on each body in the star system.
         void computeForces(const StarSystem<BodyType>& star_system){
 
+            const auto start = std::chrono::steady_clock::now();
+
             // Clean up after the previous force calculation.
             cleanForces(star_system);
 
             // Do the actual force computation.
             computeForcesImpl(star_system);
+            addComputeTime(start);
         }
 
         // Precompute the forces exerted on each body in the star system and the potential energy
         // of the system.
         void computeForcesAndPotential(const StarSystem<BodyType>& star_system){
+            const auto start = std::chrono::steady_clock::now();
             cleanForces(star_system);
             _potential = 0.;
             computeForcesAndPotentialImpl(star_system);
+            addComputeTime(start);
+        }
+
+        // Compute the acceleration of every body and write it into the accelerations buffer, which is
+        // resized if needed. The gravitational constant and the inverse mass of each body are
+        // folded in, so integrators can read the accelerations without any further arithmetic.
+        // The forces remain available through totalForce as well.
+        void computeAccelerations(const StarSystem<BodyType>& star_system, std::vector<vector_type>& accelerations){
+            const auto start = std::chrono::steady_clock::now();
+            cleanForces(star_system);
+            accelerations.resize(star_system.size());
+            computeAccelerationsImpl(star_system, accelerations);
+            addComputeTime(start);
+        }
+
+        void computeAccelerationsAndPotential(const StarSystem<BodyType>& star_system, std::vector<vector_type>& accelerations){
+            const auto start = std::chrono::steady_clock::now();
+            cleanForces(star_system);
+            _potential = 0.;
+            accelerations.resize(star_system.size());
+            computeAccelerationsAndPotentialImpl(star_system, accelerations);
+            addComputeTime(start);
+        }
+
+        // Compute the forces exerted on a subset of the bodies by all bodies in the star system.
+        // This is used by integrators that only advance some of the bodies at a time. The forces
+        // on bodies outside the subset are zero afterwards.
+        void computeForces(const StarSystem<BodyType>& star_system, const std::vector<std::size_t>& active_bodies){
+            const auto start = std::chrono::steady_clock::now();
+            cleanForces(star_system);
+            computeSubsetForcesImpl(star_system, active_bodies);
+            addComputeTime(start);
+        }
+
+        // Compute the accelerations of a subset of the bodies. The accelerations buffer is resized
+        // to the size of the star system if needed, and the entries of bodies outside the subset
+        // are left untouched.
+        void computeAccelerations(
+            const StarSystem<BodyType>& star_system,
+            const std::vector<std::size_t>& active_bodies,
+            std::vector<vector_type>& accelerations)
+        {
+            const auto start = std::chrono::steady_clock::now();
+            cleanForces(star_system);
+            accelerations.resize(star_system.size());
+            computeSubsetAccelerationsImpl(star_system, active_bodies, accelerations);
+            addComputeTime(start);
         }
 
         // Retrieve the force being exerted on one body by the other bodies.
@@ -54,8 +108,50 @@ template<typename BodyType> class ForceComputerBase{
             return _G * _forces.at(body_index);
         }
 
+        // Gravitational potential energy of the star system, -G sum m_i m_j / r_ij, as of the last
+        // computation that included the potential. Like the forces, the pairwise terms are
+        // accumulated without the gravitational constant and with a positive sign, and both are
+        // applied here, so callers must not apply them again.
         numeric_type potentialEnergy() const{
-            return _potential;
+            return -_G * _potential;
+        }
+
+        numeric_type gravitationalConstant() const{
+            return _G;
+        }
+
+        // Wall clock time spent in the computations of forces and accelerations, in seconds, since
+        // construction or the last reset. This separates the force computation from the rest of
+        // the time step when profiling a simulation.
+        double computeSeconds() const{
+            return _compute_seconds;
+        }
+
+        void resetComputeSeconds(){
+            _compute_seconds = 0.;
+        }
+
+        // Softening applied to every pairwise interaction, both to the force and to the potential.
+        // There is no softening by default.
+        const SofteningKernel<numeric_type>& softening() const{
+            return _softening;
+        }
+
+        void setSoftening(const SofteningKernel<numeric_type>& softening){
+            _softening = softening;
+        }
+
+        // Save the forces and the potential energy of the last computation, so that they are
+        // still available after resuming from a checkpoint. Force computers that keep state
+        // between computations should save it as well.
+        virtual void saveState(CheckpointState& state) const{
+            state.save("force_computer/forces", _forces);
+            state.save("force_computer/potential", _potential);
+        }
+
+        virtual void loadState(const CheckpointState& state){
+            state.load("force_computer/forces", _forces);
+            state.load("force_computer/potential", _potential);
         }
 
         // Compute the unit agnostic pairwise force between two bodies.
@@ -63,14 +159,28 @@ template<typename BodyType> class ForceComputerBase{
         // to multiply each force component by it. Instead the total force can be multiplied by
         // this number.
         vector_type pairwiseForce(const BodyType& lhs, const BodyType& rhs) const{
-            vector_type position_difference = (rhs.position() - lhs.position());
+            return pairwiseForce(lhs.position(), lhs.mass(), rhs.position(), rhs.mass());
+        }
+
+        // Pairwise force between two point masses. This is used by force computers that
+        // approximate groups of bodies by a single mass, such as tree codes.
+        vector_type pairwiseForce(
+            const vector_type& lhs_position,
+            const numeric_type lhs_mass,
+            const vector_type& rhs_position,
+            const numeric_type rhs_mass) const
+        {
+            vector_type position_difference = (rhs_position - lhs_position);
+            if(_softening.type() != SofteningType::none){
+                return (lhs_mass * rhs_mass * _softening.forceFactor(square(position_difference))) * position_difference;
+            }
 
             // Avoid repeating the vector subtraction here.
             numeric_type distance = abs(position_difference);
 
             // Use pre-computed distance to avoid having to compute an inner product of vectors or
             // another square root.
-            return (lhs.mass() * rhs.mass() * position_difference) / (distance*distance*distance);
+            return (lhs_mass * rhs_mass * position_difference) / (distance*distance*distance);
         }
 
         // Conservation of energy can be used to check the correctness of the simulation over many
@@ -81,9 +191,25 @@ template<typename BodyType> class ForceComputerBase{
             const BodyType& lhs,
             const BodyType& rhs) const
         {
-            vector_type position_difference = (rhs.position() - lhs.position());
+            return pairwiseForceAndPotential(lhs.position(), lhs.mass(), rhs.position(), rhs.mass());
+        }
+
+        std::pair<vector_type, numeric_type> pairwiseForceAndPotential(
+            const vector_type& lhs_position,
+            const numeric_type lhs_mass,
+            const vector_type& rhs_position,
+            const numeric_type rhs_mass) const
+        {
+            vector_type position_difference = (rhs_position - lhs_position);
+            if(_softening.type() != SofteningType::none){
+                numeric_type force_factor;
+                numeric_type potential_factor;
+                _softening.factors(square(position_difference), force_factor, potential_factor);
+                numeric_type mass_product = lhs_mass * rhs_mass;
+                return {(mass_product * force_factor) * position_difference, mass_product * potential_factor};
+            }
             numeric_type distance = abs(position_difference);
-            numeric_type potential = lhs.mass() * rhs.mass() / distance;
+            numeric_type potential = lhs_mass * rhs_mass / distance;
             return {potential * position_difference / (distance*distance), potential};
         }
 
@@ -93,6 +219,55 @@ template<typename BodyType> class ForceComputerBase{
         virtual void computeForcesImpl(const StarSystem<BodyType>&) = 0;
         virtual void computeForcesAndPotentialImpl(const StarSystem<BodyType>&) = 0;
 
+        // Functions computing the accelerations. By default the forces are computed and converted
+        // in a single pass. Force computers that obtain the accelerations more directly can
+        // override these.
+        virtual void computeAccelerationsImpl(const StarSystem<BodyType>& star_system, std::vector<vector_type>& accelerations){
+            computeForcesImpl(star_system);
+            forcesToAccelerations(star_system, accelerations);
+        }
+
+        virtual void computeAccelerationsAndPotentialImpl(const StarSystem<BodyType>& star_system, std::vector<vector_type>& accelerations){
+            computeForcesAndPotentialImpl(star_system);
+            forcesToAccelerations(star_system, accelerations);
+        }
+
+        // Functions computing the forces on a subset of the bodies. By default the pull of every
+        // other body is summed directly, which costs O(N) per active body. Force computers that
+        // can do better, e.g. with a tree, should override these.
+        virtual void computeSubsetForcesImpl(const StarSystem<BodyType>& star_system, const std::vector<std::size_t>& active_bodies){
+            for(const std::size_t i: active_bodies){
+                const vector_type position = star_system.position(i);
+                const numeric_type mass = star_system.mass(i);
+                vector_type force;
+                for(std::size_t j{0}; j < star_system.size(); ++j){
+                    if(j != i){
+                        force += pairwiseForce(position, mass, star_system.position(j), star_system.mass(j));
+                    }
+                }
+                _forces[i] = force;
+            }
+        }
+
+        virtual void computeSubsetAccelerationsImpl(
+            const StarSystem<BodyType>& star_system,
+            const std::vector<std::size_t>& active_bodies,
+            std::vector<vector_type>& accelerations)
+        {
+            computeSubsetForcesImpl(star_system, active_bodies);
+            const numeric_type* masses = star_system.masses().data();
+            for(const std::size_t b: active_bodies){
+                accelerations[b] = (_G / masses[b]) * _forces[b];
+            }
+        }
+
+        void forcesToAccelerations(const StarSystem<BodyType>& star_system, std::vector<vector_type>& accelerations) const{
+            const numeric_type* masses = star_system.masses().data();
+            for(std::size_t b{0}; b < star_system.size(); ++b){
+                accelerations[b] = (_G / masses[b]) * _forces[b];
+            }
+        }
+
         // Reset all forces to be 0 vectors.
         // All vectors are initialized to 0 along each dimension with the defauly initializer.
         void resetForces(){
@@ -107,6 +282,14 @@ template<typename BodyType> class ForceComputerBase{
         // Gravitational constant used in the calculations.
         numeric_type _G = 1.;
 
+        SofteningKernel<numeric_type> _softening;
+
+        double _compute_seconds = 0.;
+
+        void addComputeTime(const std::chrono::steady_clock::time_point start){
+            _compute_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+
         // Some cleanup needed before every new force calculation.
         void cleanForces(const StarSystem<BodyType>& star_system){
 
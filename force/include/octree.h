@@ -0,0 +1,232 @@
+// Spatial tree over the bodies of a star system.
+// For 3D vectors every cell is split into 8 children (an octree), for 2D vectors into 4 children
+// (a quadtree). The tree is used by force computers that approximate the gravitational pull of
+// distant groups of bodies.
+#ifndef Octree_H
+#define Octree_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector_traits.h"
+
+template<typename BodyType> class Octree{
+
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+        using vector_type = typename BodyType::vector_type;
+
+        static constexpr std::size_t dimension = vector_traits<vector_type>::dimension;
+        static constexpr std::size_t max_children = (std::size_t{1} << dimension);
+
+        // A cell of the tree.
+        // The bodies in a cell are stored as a contiguous range [begin, end) of bodyIndex, and the
+        // children of a cell are stored contiguously starting at first_child. Empty children are
+        // not stored.
+        struct Node{
+            vector_type center;
+            numeric_type half_size;
+            vector_type center_of_mass;
+            numeric_type mass;
+            std::size_t begin;
+            std::size_t end;
+            std::size_t first_child;
+            std::size_t num_children;
+
+            bool isLeaf() const{ return num_children == 0; }
+            std::size_t numBodies() const{ return end - begin; }
+        };
+
+        // Cells with at most leaf_size bodies are not split any further.
+        // The maximum depth avoids infinite splitting when several bodies share the same position.
+        Octree(const std::size_t leaf_size = 1, const std::size_t max_depth = 48):
+            _leaf_size(std::max(leaf_size, std::size_t{1})),
+            _max_depth(max_depth)
+        {}
+
+        // (Re)build the tree for the current positions of the bodies in the star system.
+        // Memory of the previous build is reused.
+        void build(const StarSystem<BodyType>& star_system);
+
+        std::size_t size() const{ return _nodes.size(); }
+        const Node& root() const{ return _nodes.front(); }
+        const Node& operator[](const std::size_t index) const{ return _nodes[index]; }
+
+        // Index in the star system of the body at position k of the tree ordering.
+        std::size_t bodyIndex(const std::size_t k) const{ return _order[k]; }
+
+        // Whether a position lies inside the (closed) cell of a node.
+        static bool contains(const Node& node, const vector_type& position){
+            for(std::size_t d{0}; d < dimension; ++d){
+                numeric_type offset = (
+                    vector_traits<vector_type>::component(position, d) -
+                    vector_traits<vector_type>::component(node.center, d)
+                );
+                if(offset > node.half_size || offset < -node.half_size){
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    private:
+        std::size_t _leaf_size;
+        std::size_t _max_depth;
+        std::vector<Node> _nodes;
+        std::vector<std::size_t> _order;
+
+        // Scratch space for sorting bodies into the children of a cell.
+        std::vector<std::size_t> _scratch_order;
+        std::vector<unsigned char> _child_index;
+
+        void buildNode(const StarSystem<BodyType>& star_system, const std::size_t node_index, const std::size_t depth);
+        void computeMass(const StarSystem<BodyType>& star_system, Node& node) const;
+};
+
+
+template<typename BodyType> void Octree<BodyType>::build(const StarSystem<BodyType>& star_system){
+    using traits = vector_traits<vector_type>;
+
+    _nodes.clear();
+    _order.resize(star_system.size());
+    _scratch_order.resize(star_system.size());
+    _child_index.resize(star_system.size());
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        _order[b] = b;
+    }
+
+    // The root cell is the smallest cube enclosing all bodies.
+    std::array<numeric_type, dimension> min_corner{};
+    std::array<numeric_type, dimension> max_corner{};
+    if(star_system.size() > 0){
+        for(std::size_t d{0}; d < dimension; ++d){
+            min_corner[d] = traits::component(star_system.position(0), d);
+            max_corner[d] = min_corner[d];
+        }
+    }
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        const vector_type position = star_system.position(b);
+        for(std::size_t d{0}; d < dimension; ++d){
+            numeric_type x = traits::component(position, d);
+            min_corner[d] = std::min(min_corner[d], x);
+            max_corner[d] = std::max(max_corner[d], x);
+        }
+    }
+    std::array<numeric_type, dimension> center;
+    numeric_type half_size = 0.;
+    for(std::size_t d{0}; d < dimension; ++d){
+        center[d] = (min_corner[d] + max_corner[d]) / 2;
+        half_size = std::max(half_size, (max_corner[d] - min_corner[d]) / 2);
+    }
+
+    Node root;
+    root.center = traits::make(center);
+    root.half_size = half_size;
+    root.begin = 0;
+    root.end = star_system.size();
+    root.first_child = 0;
+    root.num_children = 0;
+    _nodes.push_back(root);
+    buildNode(star_system, 0, 0);
+}
+
+
+template<typename BodyType> void Octree<BodyType>::buildNode(
+    const StarSystem<BodyType>& star_system,
+    const std::size_t node_index,
+    const std::size_t depth)
+{
+    using traits = vector_traits<vector_type>;
+
+    // Copy the node since _nodes can be reallocated when the children are added.
+    Node node = _nodes[node_index];
+    if(node.numBodies() <= _leaf_size || depth >= _max_depth){
+        computeMass(star_system, node);
+        _nodes[node_index] = node;
+        return;
+    }
+
+    // Determine in which child each body lies, and sort the bodies by child.
+    std::array<std::size_t, max_children> counts{};
+    for(std::size_t k{node.begin}; k < node.end; ++k){
+        const vector_type position = star_system.position(_order[k]);
+        unsigned char child{0};
+        for(std::size_t d{0}; d < dimension; ++d){
+            if(traits::component(position, d) >= traits::component(node.center, d)){
+                child |= static_cast<unsigned char>(1U << d);
+            }
+        }
+        _child_index[k] = child;
+        ++counts[child];
+    }
+    std::array<std::size_t, max_children> offsets;
+    std::size_t offset{node.begin};
+    for(std::size_t c{0}; c < max_children; ++c){
+        offsets[c] = offset;
+        offset += counts[c];
+    }
+    for(std::size_t k{node.begin}; k < node.end; ++k){
+        _scratch_order[offsets[_child_index[k]]++] = _order[k];
+    }
+    std::copy(_scratch_order.begin() + node.begin, _scratch_order.begin() + node.end, _order.begin() + node.begin);
+
+    // Add the non-empty children contiguously before recursing into any of them.
+    node.first_child = _nodes.size();
+    node.num_children = 0;
+    std::size_t begin{node.begin};
+    const numeric_type child_half_size = node.half_size / 2;
+    for(std::size_t c{0}; c < max_children; ++c){
+        if(counts[c] == 0){
+            continue;
+        }
+        std::array<numeric_type, dimension> child_center;
+        for(std::size_t d{0}; d < dimension; ++d){
+            numeric_type shift = ((c >> d) & 1U) ? child_half_size : -child_half_size;
+            child_center[d] = traits::component(node.center, d) + shift;
+        }
+        Node child;
+        child.center = traits::make(child_center);
+        child.half_size = child_half_size;
+        child.begin = begin;
+        child.end = begin + counts[c];
+        child.first_child = 0;
+        child.num_children = 0;
+        _nodes.push_back(child);
+        begin += counts[c];
+        ++node.num_children;
+    }
+    _nodes[node_index] = node;
+
+    for(std::size_t c{0}; c < node.num_children; ++c){
+        buildNode(star_system, node.first_child + c, depth + 1);
+    }
+
+    // The mass and center of mass of a cell follow from those of its children.
+    numeric_type mass = 0.;
+    vector_type weighted_position;
+    for(std::size_t c{0}; c < node.num_children; ++c){
+        const Node& child = _nodes[node.first_child + c];
+        mass += child.mass;
+        weighted_position += child.mass * child.center_of_mass;
+    }
+    _nodes[node_index].mass = mass;
+    _nodes[node_index].center_of_mass = (mass > 0 ? weighted_position / mass : node.center);
+}
+
+
+template<typename BodyType> void Octree<BodyType>::computeMass(const StarSystem<BodyType>& star_system, Node& node) const{
+    numeric_type mass = 0.;
+    vector_type weighted_position;
+    for(std::size_t k{node.begin}; k < node.end; ++k){
+        const numeric_type body_mass = star_system.mass(_order[k]);
+        mass += body_mass;
+        weighted_position += body_mass * star_system.position(_order[k]);
+    }
+    node.mass = mass;
+    node.center_of_mass = (mass > 0 ? weighted_position / mass : node.center);
+}
+
+#endif
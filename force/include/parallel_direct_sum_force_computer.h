@@ -0,0 +1,161 @@
+// Multithreaded direct summation of the pairwise forces.
+// The bodies are divided in blocks of a fixed size, like the tiles of DirectSumForceComputer, and
+// the triangle of pairs of blocks is scheduled as a round-robin tournament: in every round each
+// block occurs in at most one pair.
+// The pairs of blocks in a round can therefore be computed by different threads writing straight
+// into _forces, without any locking or per-thread force buffers.
+// The order in which contributions are added to the force on any body only depends on the block
+// size, so the result is bit-identical for any number of threads.
+#ifndef ParallelDirectSumForceComputer_H
+#define ParallelDirectSumForceComputer_H
+
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "accumulation_policy.h"
+#include "direct_sum_force_computer.h"
+#include "../../parallel/include/barrier.h"
+
+
+template<typename BodyType> class ParallelDirectSumForceComputer: public DirectSumForceComputer<BodyType>{
+
+    public:
+        using numeric_type = typename ForceComputerBase<BodyType>::numeric_type;
+        using vector_type = typename ForceComputerBase<BodyType>::vector_type;
+
+        ParallelDirectSumForceComputer(
+            const numeric_type G = 1.,
+            const std::size_t num_threads = std::thread::hardware_concurrency(),
+            const std::size_t block_size = 256
+        ):
+            DirectSumForceComputer<BodyType>(G, std::max(block_size, std::size_t{1})),
+            _num_threads(std::max(num_threads, std::size_t{1})),
+            _block_size(std::max(block_size, std::size_t{1}))
+        {}
+
+        std::size_t numThreads() const{ return _num_threads; }
+        void setNumThreads(const std::size_t num_threads){ _num_threads = std::max(num_threads, std::size_t{1}); }
+
+        // The block size determines the summation order, so it is fixed at construction, and the
+        // tile size of DirectSumForceComputer can not be changed. The number of threads never
+        // changes the result.
+        std::size_t blockSize() const{ return _block_size; }
+
+    protected:
+        virtual void computeForcesImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForcePolicy>(star_system);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForceAndPotentialPolicy>(star_system);
+        }
+
+    private:
+        using DirectSumForceComputer<BodyType>::setTileSize;
+        using ForceComputerBase<BodyType>::_potential;
+        using BlockPair = std::pair<std::size_t, std::size_t>;
+
+        std::size_t _num_threads;
+        const std::size_t _block_size;
+
+        // Rounds of pairs of blocks. No block occurs twice in the same round.
+        std::vector<std::vector<BlockPair>> _schedule;
+        std::size_t _num_blocks = 0;
+
+        // Potential energy summed per block, to be reduced in a fixed order.
+        std::vector<numeric_type> _block_potential;
+
+        template<typename AccumulationPolicy> void computeAllTerms(const StarSystem<BodyType>& star_system){
+            const std::size_t num_blocks = (star_system.size() + blockSize() - 1) / blockSize();
+            if(num_blocks != _num_blocks){
+                makeSchedule(num_blocks);
+            }
+            _block_potential.assign(num_blocks, 0.);
+
+            const std::size_t num_threads = std::min(_num_threads, std::max(num_blocks / 2, std::size_t{1}));
+            if(num_threads == 1){
+                computeRounds<AccumulationPolicy>(star_system, 0, 1, nullptr);
+            } else {
+                Barrier barrier(num_threads);
+                std::vector<std::thread> threads;
+                for(std::size_t t{1}; t < num_threads; ++t){
+                    threads.emplace_back(
+                        &ParallelDirectSumForceComputer<BodyType>::template computeRounds<AccumulationPolicy>,
+                        this, std::cref(star_system), t, num_threads, &barrier
+                    );
+                }
+                computeRounds<AccumulationPolicy>(star_system, 0, num_threads, &barrier);
+                for(auto& thread: threads){
+                    thread.join();
+                }
+            }
+
+            if(AccumulationPolicy::with_potential){
+                for(const numeric_type potential: _block_potential){
+                    _potential += potential;
+                }
+            }
+        }
+
+        // Each thread handles a fixed subset of the pairs in every round, and waits for the other
+        // threads before moving on to the next round.
+        template<typename AccumulationPolicy> void computeRounds(
+            const StarSystem<BodyType>& star_system,
+            const std::size_t thread_index,
+            const std::size_t num_threads,
+            Barrier* barrier)
+        {
+            for(const auto& round: _schedule){
+                for(std::size_t p{thread_index}; p < round.size(); p += num_threads){
+                    computeBlockPair<AccumulationPolicy>(star_system, round[p].first, round[p].second);
+                }
+                if(barrier != nullptr){
+                    barrier->wait();
+                }
+            }
+        }
+
+        template<typename AccumulationPolicy> void computeBlockPair(
+            const StarSystem<BodyType>& star_system,
+            const std::size_t lhs_block,
+            const std::size_t rhs_block)
+        {
+            const std::size_t lhs_begin = lhs_block * blockSize();
+            const std::size_t lhs_end = std::min(lhs_begin + blockSize(), star_system.size());
+            const std::size_t rhs_begin = rhs_block * blockSize();
+            const std::size_t rhs_end = std::min(rhs_begin + blockSize(), star_system.size());
+            _block_potential[lhs_block] += this->template computeTile<AccumulationPolicy>(star_system, lhs_begin, lhs_end, rhs_begin, rhs_end);
+        }
+
+        // Round-robin tournament (circle method) over the blocks, preceded by a round with the
+        // pairs of every block with itself.
+        void makeSchedule(const std::size_t num_blocks){
+            _num_blocks = num_blocks;
+            _schedule.clear();
+
+            std::vector<BlockPair> diagonal;
+            for(std::size_t b{0}; b < num_blocks; ++b){
+                diagonal.emplace_back(b, b);
+            }
+            _schedule.push_back(diagonal);
+
+            // With an odd number of blocks a dummy block is added, and pairs with it are skipped.
+            const std::size_t num_players = num_blocks + (num_blocks % 2);
+            for(std::size_t r{0}; r + 1 < num_players; ++r){
+                std::vector<BlockPair> round;
+                if(num_players - 1 < num_blocks){
+                    round.emplace_back(r, num_players - 1);
+                }
+                for(std::size_t k{1}; k < num_players / 2; ++k){
+                    std::size_t lhs = (r + k) % (num_players - 1);
+                    std::size_t rhs = (r + num_players - 1 - k) % (num_players - 1);
+                    round.emplace_back(std::min(lhs, rhs), std::max(lhs, rhs));
+                }
+                _schedule.push_back(round);
+            }
+        }
+};
+
+#endif
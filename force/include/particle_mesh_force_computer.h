@@ -0,0 +1,410 @@
+// Particle-mesh (PM) force computation.
+// The mass of the bodies is assigned to a regular 3D grid, the potential on the grid is the
+// convolution of the density with the Green's function of the Poisson equation, computed with
+// FFTs, and the forces are interpolated back from finite differences of the potential. The cost
+// is O(N + M log M) for M grid cells, independent of the clustering of the bodies, but the force
+// is only resolved down to a few cells.
+//
+// The boundaries are isolated rather than periodic: the grid is zero-padded to twice its size in
+// every dimension (Hockney & Eastwood, Computer Simulation Using Particles, 1988), so the
+// periodic convolution of the FFTs does not wrap around. The grid is a cube that follows the
+// bodies. It is kept between force computations as long as the bodies fit inside, so the
+// transform of the Green's function only needs to be recomputed when the grid moves.
+//
+// The Green's function is a virtual method, so that a TreePM force computer can replace it with
+// the long-range part of a split interaction and add the short-range part with a tree.
+#ifndef ParticleMeshForceComputer_H
+#define ParticleMeshForceComputer_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "force_computer_base.h"
+#include "softening_kernel.h"
+#include "../../fft/include/fft.h"
+#include "../../vector/include/vector_traits.h"
+
+
+// Scheme to assign the mass of a body to the grid, and to interpolate the forces back.
+enum class MassAssignment{
+    // Cloud in cell: the mass is shared by the 8 nearest cells, with linear weights.
+    cic,
+    // Triangular shaped cloud: the mass is shared by the 27 nearest cells, with quadratic
+    // weights. The force is smoother, and less dependent on the position relative to the grid.
+    tsc
+};
+
+inline std::string to_string(const MassAssignment assignment){
+    return (assignment == MassAssignment::cic ? "CIC" : "TSC");
+}
+
+
+template<typename BodyType> class ParticleMeshForceComputer: public ForceComputerBase<BodyType>{
+
+    public:
+        using numeric_type = typename ForceComputerBase<BodyType>::numeric_type;
+        using vector_type = typename ForceComputerBase<BodyType>::vector_type;
+
+        static_assert(vector_traits<vector_type>::dimension == 3, "The particle-mesh method is only implemented for 3D vectors.");
+
+        // The grid has grid_size cells along every dimension, which must be a power of two.
+        ParticleMeshForceComputer(
+            const numeric_type G = 1.,
+            const std::size_t grid_size = 64,
+            const MassAssignment assignment = MassAssignment::tsc
+        ):
+            ForceComputerBase<BodyType>(G),
+            _grid_size(checkGridSize(grid_size)),
+            _assignment(assignment),
+            _fft(2 * grid_size, 2 * grid_size, 2 * grid_size)
+        {}
+
+        std::size_t gridSize() const{ return _grid_size; }
+        MassAssignment assignment() const{ return _assignment; }
+
+        // Side length of a grid cell, as of the last force computation.
+        numeric_type cellSize() const{ return _cell_size; }
+
+        // The placement of the grid, which is kept between force computations, so that a resumed
+        // simulation uses the same grid as the uninterrupted one. The transform of the Green's
+        // function follows from the cell size and is recomputed.
+        virtual void saveState(CheckpointState& state) const override{
+            ForceComputerBase<BodyType>::saveState(state);
+            state.save("force_computer/grid_origin", _origin);
+            state.save("force_computer/cell_size", _cell_size);
+        }
+
+        virtual void loadState(const CheckpointState& state) override{
+            ForceComputerBase<BodyType>::loadState(state);
+            state.load("force_computer/grid_origin", _origin);
+            state.load("force_computer/cell_size", _cell_size);
+            invalidateGreensFunction();
+        }
+
+    protected:
+        virtual void computeForcesImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<false>(star_system, nullptr);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<true>(star_system, nullptr);
+        }
+
+        // The potential on the grid costs the same for any number of active bodies, only the
+        // interpolation is restricted to the active ones.
+        virtual void computeSubsetForcesImpl(const StarSystem<BodyType>& star_system, const std::vector<std::size_t>& active_bodies) override{
+            computeAllTerms<false>(star_system, &active_bodies);
+        }
+
+        // Potential of a unit mass at the given distance, with a positive sign as for the pairwise
+        // potentials. By default this is the softened potential if there is softening, and 1/r
+        // otherwise, with 1/r averaged over a cell at the origin.
+        virtual numeric_type greensFunction(const numeric_type distance, const numeric_type cell_size) const{
+            if(this->softening().type() != SofteningType::none){
+                return this->softening().potentialFactor(distance * distance);
+            }
+            if(distance == 0){
+                return mean_inverse_distance / cell_size;
+            }
+            return 1 / distance;
+        }
+
+        // Force the transform of the Green's function to be recomputed, e.g. after a parameter of
+        // an overriding greensFunction has changed.
+        void invalidateGreensFunction(){
+            _greens_cell_size = 0.;
+        }
+
+    private:
+        using complex_type = std::complex<numeric_type>;
+        using traits = vector_traits<vector_type>;
+        using ForceComputerBase<BodyType>::_forces;
+        using ForceComputerBase<BodyType>::_potential;
+
+        // Mean of 1/r over a unit cube centered at the origin.
+        static constexpr numeric_type mean_inverse_distance = 2.38008;
+
+        // Bodies stay this many cells away from the edges of the grid, so that the assignment and
+        // the finite differences never leave it.
+        static constexpr std::size_t margin = 4;
+
+        // The grid is made larger than the bodies by this factor, so that it does not have to move
+        // every time a body leaves the bounding box.
+        static constexpr numeric_type slack = 1.25;
+
+        // Range of the offsets between cells covered by the assignment scheme of two bodies.
+        static constexpr int max_offset = 2;
+        static constexpr std::size_t num_offsets = 2 * max_offset + 1;
+
+        // Cells and weights of the assignment of a body along one dimension.
+        struct Stencil{
+            std::size_t first;
+            std::size_t size;
+            std::array<numeric_type, 3> weights;
+        };
+
+        std::size_t _grid_size;
+        MassAssignment _assignment;
+
+        // Position of the center of the cell with index (0, 0, 0), and the side length of a cell.
+        std::array<numeric_type, 3> _origin{};
+        numeric_type _cell_size = 0.;
+
+        // The zero-padded grid with twice the size along every dimension. It holds the density
+        // and, after the convolution, the potential in the real parts.
+        FFT3D<numeric_type> _fft;
+        std::vector<complex_type> _grid;
+
+        // Gradient and value of the potential at every cell of the unpadded grid.
+        std::vector<std::array<numeric_type, 4>> _field;
+
+        // Transform of the Green's function, which is real because the Green's function is even,
+        // and the parameters it was computed for.
+        std::vector<numeric_type> _greens_transform;
+        numeric_type _greens_cell_size = 0.;
+        SofteningKernel<numeric_type> _greens_softening;
+
+        // The Green's function at the offsets between cells within max_offset of each other, for
+        // the interaction of a body with its own mass on the grid.
+        std::array<numeric_type, num_offsets * num_offsets * num_offsets> _near_greens{};
+
+        static std::size_t checkGridSize(const std::size_t grid_size){
+            if(!FFT<numeric_type>::isPowerOfTwo(grid_size) || grid_size < 4 * margin){
+                throw std::invalid_argument("The particle-mesh grid size must be a power of two of at least " + std::to_string(4 * margin) + ", got " + std::to_string(grid_size) + ".");
+            }
+            return grid_size;
+        }
+
+        std::size_t paddedSize() const{ return 2 * _grid_size; }
+
+        std::size_t gridIndex(const std::size_t x, const std::size_t y, const std::size_t z) const{
+            return (x * paddedSize() + y) * paddedSize() + z;
+        }
+
+        template<bool with_potential> void computeAllTerms(const StarSystem<BodyType>& star_system, const std::vector<std::size_t>* active_bodies){
+            if(star_system.size() == 0){
+                return;
+            }
+            placeGrid(star_system);
+            if(_cell_size != _greens_cell_size || _greens_softening.type() != this->softening().type() || _greens_softening.length() != this->softening().length()){
+                computeGreensFunction();
+            }
+
+            // Only the part of the padded grid that holds the bodies is needed in the end.
+            assignMasses(star_system);
+            _fft.forward(_grid.data(), _grid_size, _grid_size);
+            for(std::size_t i{0}; i < _grid.size(); ++i){
+                _grid[i] *= _greens_transform[i];
+            }
+            _fft.inverse(_grid.data(), _grid_size, _grid_size);
+            computeField();
+
+            if(active_bodies){
+                for(const std::size_t b: *active_bodies){
+                    interpolate<with_potential>(star_system, b);
+                }
+            } else {
+                for(std::size_t b{0}; b < star_system.size(); ++b){
+                    interpolate<with_potential>(star_system, b);
+                }
+            }
+
+            // Every pair of bodies was counted twice, once for each body in the pair.
+            if(with_potential){
+                _potential /= 2;
+            }
+        }
+
+        // Keep the grid if all bodies are inside and still cover a good part of it, otherwise
+        // center a new grid on the bounding box of the bodies.
+        void placeGrid(const StarSystem<BodyType>& star_system){
+            std::array<numeric_type, 3> lower;
+            std::array<numeric_type, 3> upper;
+            for(std::size_t d{0}; d < 3; ++d){
+                lower[d] = upper[d] = traits::component(star_system.position(0), d);
+            }
+            for(std::size_t b{1}; b < star_system.size(); ++b){
+                for(std::size_t d{0}; d < 3; ++d){
+                    const numeric_type component = traits::component(star_system.position(b), d);
+                    lower[d] = std::min(lower[d], component);
+                    upper[d] = std::max(upper[d], component);
+                }
+            }
+
+            const numeric_type usable_cells = static_cast<numeric_type>(_grid_size - 1 - 2 * margin);
+            numeric_type extent = 0.;
+            bool inside = (_cell_size > 0);
+            for(std::size_t d{0}; d < 3; ++d){
+                extent = std::max(extent, upper[d] - lower[d]);
+                inside = inside && (lower[d] - _origin[d] >= margin * _cell_size) && (upper[d] - _origin[d] <= (margin + usable_cells) * _cell_size);
+            }
+            if(inside && 2 * extent >= usable_cells * _cell_size){
+                return;
+            }
+
+            _cell_size = (extent > 0 ? slack * extent / usable_cells : numeric_type(1));
+            for(std::size_t d{0}; d < 3; ++d){
+                _origin[d] = (lower[d] + upper[d]) / 2 - _cell_size * static_cast<numeric_type>(_grid_size - 1) / 2;
+            }
+        }
+
+        // Green's function on the padded grid, where the offsets wrap around: index i is the
+        // offset i for i < grid_size, and i - 2 * grid_size otherwise.
+        void computeGreensFunction(){
+            const std::size_t padded_size = paddedSize();
+            const auto offset = [padded_size](const std::size_t i){
+                return static_cast<numeric_type>(i < padded_size / 2 ? i : padded_size - i);
+            };
+            _grid.resize(padded_size * padded_size * padded_size);
+            for(std::size_t x{0}; x < padded_size; ++x){
+                for(std::size_t y{0}; y < padded_size; ++y){
+                    for(std::size_t z{0}; z < padded_size; ++z){
+                        const numeric_type distance = _cell_size * std::sqrt(offset(x) * offset(x) + offset(y) * offset(y) + offset(z) * offset(z));
+                        _grid[gridIndex(x, y, z)] = greensFunction(distance, _cell_size);
+                    }
+                }
+            }
+            _fft.forward(_grid.data());
+            _greens_transform.resize(_grid.size());
+            for(std::size_t i{0}; i < _grid.size(); ++i){
+                _greens_transform[i] = _grid[i].real();
+            }
+
+            for(int x{-max_offset}; x <= max_offset; ++x){
+                for(int y{-max_offset}; y <= max_offset; ++y){
+                    for(int z{-max_offset}; z <= max_offset; ++z){
+                        const numeric_type distance = _cell_size * std::sqrt(static_cast<numeric_type>(x * x + y * y + z * z));
+                        _near_greens[((x + max_offset) * num_offsets + (y + max_offset)) * num_offsets + (z + max_offset)] = greensFunction(distance, _cell_size);
+                    }
+                }
+            }
+
+            _greens_cell_size = _cell_size;
+            _greens_softening = this->softening();
+        }
+
+        Stencil stencil(const numeric_type position, const std::size_t d) const{
+            const numeric_type u = (position - _origin[d]) / _cell_size;
+            Stencil result;
+            if(_assignment == MassAssignment::cic){
+                const numeric_type cell = std::floor(u);
+                const numeric_type fraction = u - cell;
+                result.first = static_cast<std::size_t>(cell);
+                result.size = 2;
+                result.weights = {1 - fraction, fraction, 0.};
+            } else {
+                const numeric_type cell = std::round(u);
+                const numeric_type fraction = u - cell;
+                result.first = static_cast<std::size_t>(cell) - 1;
+                result.size = 3;
+                result.weights = {
+                    (numeric_type(0.5) - fraction) * (numeric_type(0.5) - fraction) / 2,
+                    numeric_type(0.75) - fraction * fraction,
+                    (numeric_type(0.5) + fraction) * (numeric_type(0.5) + fraction) / 2
+                };
+            }
+            return result;
+        }
+
+        std::array<Stencil, 3> stencils(const vector_type& position) const{
+            return {stencil(traits::component(position, 0), 0), stencil(traits::component(position, 1), 1), stencil(traits::component(position, 2), 2)};
+        }
+
+        void assignMasses(const StarSystem<BodyType>& star_system){
+            std::fill(_grid.begin(), _grid.end(), complex_type());
+            for(std::size_t b{0}; b < star_system.size(); ++b){
+                const std::array<Stencil, 3> s = stencils(star_system.position(b));
+                const numeric_type mass = star_system.mass(b);
+                for(std::size_t i{0}; i < s[0].size; ++i){
+                    for(std::size_t j{0}; j < s[1].size; ++j){
+                        const numeric_type weight = mass * s[0].weights[i] * s[1].weights[j];
+                        complex_type* line = _grid.data() + gridIndex(s[0].first + i, s[1].first + j, s[2].first);
+                        for(std::size_t k{0}; k < s[2].size; ++k){
+                            line[k] += weight * s[2].weights[k];
+                        }
+                    }
+                }
+            }
+        }
+
+        numeric_type gridPotential(const std::size_t x, const std::size_t y, const std::size_t z) const{
+            return _grid[gridIndex(x, y, z)].real();
+        }
+
+        std::size_t fieldIndex(const std::size_t x, const std::size_t y, const std::size_t z) const{
+            return (x * _grid_size + y) * _grid_size + z;
+        }
+
+        // Gradient of the potential with fourth order central differences, at all cells that are
+        // far enough from the edges. This is cheaper than differencing at every body for all but
+        // the smallest numbers of bodies.
+        void computeField(){
+            _field.resize(_grid_size * _grid_size * _grid_size);
+            const numeric_type scale = 1 / (12 * _cell_size);
+            for(std::size_t x{2}; x + 2 < _grid_size; ++x){
+                for(std::size_t y{2}; y + 2 < _grid_size; ++y){
+                    for(std::size_t z{2}; z + 2 < _grid_size; ++z){
+                        _field[fieldIndex(x, y, z)] = {
+                            scale * (8 * (gridPotential(x + 1, y, z) - gridPotential(x - 1, y, z)) - (gridPotential(x + 2, y, z) - gridPotential(x - 2, y, z))),
+                            scale * (8 * (gridPotential(x, y + 1, z) - gridPotential(x, y - 1, z)) - (gridPotential(x, y + 2, z) - gridPotential(x, y - 2, z))),
+                            scale * (8 * (gridPotential(x, y, z + 1) - gridPotential(x, y, z - 1)) - (gridPotential(x, y, z + 2) - gridPotential(x, y, z - 2))),
+                            gridPotential(x, y, z)
+                        };
+                    }
+                }
+            }
+        }
+
+        // The force on a body is its mass times the gradient of the potential interpolated with
+        // the weights of its mass assignment, which conserves momentum.
+        template<bool with_potential> void interpolate(const StarSystem<BodyType>& star_system, const std::size_t b){
+            const std::array<Stencil, 3> s = stencils(star_system.position(b));
+            const numeric_type mass = star_system.mass(b);
+            std::array<numeric_type, 4> field{};
+            for(std::size_t i{0}; i < s[0].size; ++i){
+                for(std::size_t j{0}; j < s[1].size; ++j){
+                    const numeric_type weight = s[0].weights[i] * s[1].weights[j];
+                    const std::array<numeric_type, 4>* line = _field.data() + fieldIndex(s[0].first + i, s[1].first + j, s[2].first);
+                    for(std::size_t k{0}; k < s[2].size; ++k){
+                        for(std::size_t d{0}; d < 4; ++d){
+                            field[d] += weight * s[2].weights[k] * line[k][d];
+                        }
+                    }
+                }
+            }
+            _forces[b] += mass * traits::make({field[0], field[1], field[2]});
+            if(with_potential){
+                _potential += mass * (field[3] - mass * selfPotential(s));
+            }
+        }
+
+        // Potential of a body at its own position due to its own mass on the grid, which is not
+        // part of the potential energy. With w the weights of the assignment along a dimension,
+        // the pairs of cells at offset o contribute sum_i w_i w_{i + o} along that dimension.
+        numeric_type selfPotential(const std::array<Stencil, 3>& s) const{
+            std::array<std::array<numeric_type, num_offsets>, 3> overlaps{};
+            for(std::size_t d{0}; d < 3; ++d){
+                for(std::size_t i{0}; i < s[d].size; ++i){
+                    for(std::size_t j{0}; j < s[d].size; ++j){
+                        overlaps[d][j + max_offset - i] += s[d].weights[i] * s[d].weights[j];
+                    }
+                }
+            }
+            numeric_type potential = 0.;
+            for(std::size_t x{0}; x < num_offsets; ++x){
+                for(std::size_t y{0}; y < num_offsets; ++y){
+                    for(std::size_t z{0}; z < num_offsets; ++z){
+                        potential += overlaps[0][x] * overlaps[1][y] * overlaps[2][z] * _near_greens[(x * num_offsets + y) * num_offsets + z];
+                    }
+                }
+            }
+            return potential;
+        }
+};
+
+#endif
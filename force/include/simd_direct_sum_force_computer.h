@@ -0,0 +1,254 @@
+// Direct summation of the forces using the vectorized pairwise kernel.
+// Unlike DirectSumForceComputer every pair is computed twice, once for each body, since the kernel
+// accumulates the pull of many partners on one body and never writes to the partners. The
+// vectorization more than makes up for the lost symmetry.
+//
+// The second template parameter is the numeric type of the kernel. By default it is the numeric
+// type of the bodies. A float kernel for double bodies gives a mixed precision computation with
+// twice the vector width and half the memory traffic. The target bodies are grouped into blocks
+// by the leaves of an octree, so that every block is spatially compact, and the positions are
+// converted to float relative to a local origin at the center of each block. The rounding error
+// of the difference between two bodies then scales with the size of the leaf of the target
+// instead of its distance from the origin of the coordinates, which keeps close pairs in dense
+// regions accurate. The kernel sums the pull of a chunk of partners in float, and the sums of
+// the chunks are accumulated in double.
+#ifndef SimdDirectSumForceComputer_H
+#define SimdDirectSumForceComputer_H
+
+#include <algorithm>
+#include <array>
+#include <type_traits>
+#include <vector>
+
+#include "accumulation_policy.h"
+#include "force_computer_base.h"
+#include "octree.h"
+#include "simd_pairwise_kernel.h"
+#include "../../vector/include/vector_traits.h"
+
+
+template<typename BodyType, typename KernelType = typename BodyType::numeric_type> class SimdDirectSumForceComputer: public ForceComputerBase<BodyType>{
+
+    public:
+        using numeric_type = typename ForceComputerBase<BodyType>::numeric_type;
+        using vector_type = typename ForceComputerBase<BodyType>::vector_type;
+        using kernel_numeric_type = KernelType;
+
+        static constexpr bool mixed_precision = !std::is_same<KernelType, numeric_type>::value;
+
+        SimdDirectSumForceComputer(const numeric_type G = 1., const SimdInstructionSet instruction_set = detectInstructionSet()):
+            ForceComputerBase<BodyType>(G),
+            _kernel(instruction_set),
+            _octree(block_size)
+        {}
+
+        SimdInstructionSet instructionSet() const{ return _kernel.instructionSet(); }
+        void setInstructionSet(const SimdInstructionSet instruction_set){ _kernel.setInstructionSet(instruction_set); }
+
+    protected:
+        virtual void computeForcesImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForcePolicy>(star_system);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms<ForceAndPotentialPolicy>(star_system);
+        }
+
+        // The kernel computes the field of the other bodies, which only differs from the
+        // acceleration by the gravitational constant.
+        virtual void computeAccelerationsImpl(const StarSystem<BodyType>& star_system, std::vector<vector_type>& accelerations) override{
+            computeAllTerms<ForcePolicy>(star_system, accelerations.data());
+        }
+
+        virtual void computeAccelerationsAndPotentialImpl(const StarSystem<BodyType>& star_system, std::vector<vector_type>& accelerations) override{
+            computeAllTerms<ForceAndPotentialPolicy>(star_system, accelerations.data());
+        }
+
+        virtual void computeSubsetForcesImpl(const StarSystem<BodyType>& star_system, const std::vector<std::size_t>& active_bodies) override{
+            computeSubset(star_system, active_bodies, nullptr);
+        }
+
+        virtual void computeSubsetAccelerationsImpl(
+            const StarSystem<BodyType>& star_system,
+            const std::vector<std::size_t>& active_bodies,
+            std::vector<vector_type>& accelerations) override
+        {
+            computeSubset(star_system, active_bodies, accelerations.data());
+        }
+
+    private:
+        using traits = vector_traits<vector_type>;
+        static constexpr std::size_t dimension = traits::dimension;
+        using ForceComputerBase<BodyType>::_forces;
+        using ForceComputerBase<BodyType>::_potential;
+
+        // With mixed precision, the maximum number of target bodies sharing a local origin, which
+        // is the leaf size of the octree, and the number of partners whose pull is summed in float.
+        static constexpr std::size_t block_size = 256;
+        static constexpr std::size_t chunk_size = 1024;
+
+        SimdPairwiseKernel<KernelType, dimension> _kernel;
+
+        // With mixed precision, the tree whose leaves are the blocks of target bodies, and which
+        // bodies are active in a subset computation.
+        Octree<BodyType> _octree;
+        std::vector<char> _active;
+
+        // Positions relative to the local origin of the current block, and masses, converted to
+        // the numeric type of the kernel.
+        std::array<std::vector<KernelType>, dimension> _local_positions;
+        std::vector<KernelType> _local_masses;
+
+        // Target bodies of the current block, and the field and potential at each of them.
+        std::vector<std::size_t> _targets;
+        std::vector<std::array<numeric_type, dimension + 1>> _sums;
+
+        template<typename AccumulationPolicy> void computeAllTerms(const StarSystem<BodyType>& star_system, vector_type* accelerations = nullptr){
+            if constexpr(mixed_precision){
+                convertMasses(star_system);
+                _octree.build(star_system);
+                for(std::size_t n{0}; n < _octree.size(); ++n){
+                    if(_octree[n].isLeaf()){
+                        _targets.clear();
+                        for(std::size_t k{_octree[n].begin}; k < _octree[n].end; ++k){
+                            _targets.push_back(_octree.bodyIndex(k));
+                        }
+                        if(!_targets.empty()){
+                            computeBlock<AccumulationPolicy>(star_system, accelerations);
+                        }
+                    }
+                }
+            } else {
+                for(std::size_t i{0}; i < star_system.size(); ++i){
+                    computeBody<AccumulationPolicy>(star_system, i, accelerations);
+                }
+            }
+
+            // Every pair was counted once for each of its bodies.
+            if(AccumulationPolicy::with_potential){
+                _potential /= 2;
+            }
+        }
+
+        void computeSubset(const StarSystem<BodyType>& star_system, const std::vector<std::size_t>& active_bodies, vector_type* accelerations){
+            if constexpr(mixed_precision){
+                convertMasses(star_system);
+                _octree.build(star_system);
+                _active.assign(star_system.size(), 0);
+                for(const std::size_t i: active_bodies){
+                    _active[i] = 1;
+                }
+                for(std::size_t n{0}; n < _octree.size(); ++n){
+                    if(_octree[n].isLeaf()){
+                        _targets.clear();
+                        for(std::size_t k{_octree[n].begin}; k < _octree[n].end; ++k){
+                            if(_active[_octree.bodyIndex(k)]){
+                                _targets.push_back(_octree.bodyIndex(k));
+                            }
+                        }
+                        if(!_targets.empty()){
+                            computeBlock<ForcePolicy>(star_system, accelerations);
+                        }
+                    }
+                }
+            } else {
+                for(const std::size_t i: active_bodies){
+                    computeBody<ForcePolicy>(star_system, i, accelerations);
+                }
+            }
+        }
+
+        void convertMasses(const StarSystem<BodyType>& star_system){
+            const numeric_type* masses = star_system.masses().data();
+            _local_masses.resize(star_system.size());
+            for(std::size_t j{0}; j < star_system.size(); ++j){
+                _local_masses[j] = static_cast<KernelType>(masses[j]);
+            }
+        }
+
+        // Pull of all bodies on the target bodies of a block, with the mixed precision kernel.
+        template<typename AccumulationPolicy> void computeBlock(const StarSystem<BodyType>& star_system, vector_type* accelerations){
+            std::array<numeric_type, dimension> origin{};
+            for(const std::size_t i: _targets){
+                for(std::size_t d{0}; d < dimension; ++d){
+                    origin[d] += star_system.positions().data(d)[i];
+                }
+            }
+            std::array<const KernelType*, dimension> positions;
+            for(std::size_t d{0}; d < dimension; ++d){
+                origin[d] /= static_cast<numeric_type>(_targets.size());
+                const numeric_type* global = star_system.positions().data(d);
+                _local_positions[d].resize(star_system.size());
+                for(std::size_t j{0}; j < star_system.size(); ++j){
+                    _local_positions[d][j] = static_cast<KernelType>(global[j] - origin[d]);
+                }
+                positions[d] = _local_positions[d].data();
+            }
+            const SofteningKernel<KernelType> softening(this->softening().type(), static_cast<KernelType>(this->softening().length()));
+
+            // The targets are the inner loop, so that a chunk of partners stays in the cache.
+            _sums.assign(_targets.size(), {});
+            for(std::size_t begin{0}; begin < star_system.size(); begin += chunk_size){
+                const std::size_t end = std::min(begin + chunk_size, star_system.size());
+                for(std::size_t t{0}; t < _targets.size(); ++t){
+                    std::array<KernelType, dimension> target;
+                    for(std::size_t d{0}; d < dimension; ++d){
+                        target[d] = positions[d][_targets[t]];
+                    }
+                    std::array<KernelType, dimension> field{};
+                    KernelType potential = 0;
+                    if(AccumulationPolicy::with_potential){
+                        _kernel.fieldAndPotential(positions.data(), _local_masses.data(), begin, end, target.data(), field.data(), &potential, softening);
+                    } else {
+                        _kernel.field(positions.data(), _local_masses.data(), begin, end, target.data(), field.data(), softening);
+                    }
+                    for(std::size_t d{0}; d < dimension; ++d){
+                        _sums[t][d] += field[d];
+                    }
+                    _sums[t][dimension] += potential;
+                }
+            }
+
+            const numeric_type* masses = star_system.masses().data();
+            for(std::size_t t{0}; t < _targets.size(); ++t){
+                const std::size_t i = _targets[t];
+                std::array<numeric_type, dimension> field;
+                std::copy(_sums[t].begin(), _sums[t].begin() + dimension, field.begin());
+                const vector_type field_vector = traits::make(field);
+                _forces[i] = masses[i] * field_vector;
+                if(accelerations != nullptr){
+                    accelerations[i] = this->gravitationalConstant() * field_vector;
+                }
+                if(AccumulationPolicy::with_potential){
+                    _potential += masses[i] * _sums[t][dimension];
+                }
+            }
+        }
+
+        // Pull of all bodies on body i.
+        template<typename AccumulationPolicy> void computeBody(const StarSystem<BodyType>& star_system, const std::size_t i, vector_type* accelerations){
+            std::array<const numeric_type*, dimension> positions;
+            std::array<numeric_type, dimension> target;
+            std::array<numeric_type, dimension> field{};
+            for(std::size_t d{0}; d < dimension; ++d){
+                positions[d] = star_system.positions().data(d);
+                target[d] = positions[d][i];
+            }
+            const numeric_type* masses = star_system.masses().data();
+
+            if(AccumulationPolicy::with_potential){
+                numeric_type potential = 0.;
+                _kernel.fieldAndPotential(positions.data(), masses, 0, star_system.size(), target.data(), field.data(), &potential, this->softening());
+                _potential += masses[i] * potential;
+            } else {
+                _kernel.field(positions.data(), masses, 0, star_system.size(), target.data(), field.data(), this->softening());
+            }
+            const vector_type field_vector = traits::make(field);
+            _forces[i] = masses[i] * field_vector;
+            if(accelerations != nullptr){
+                accelerations[i] = this->gravitationalConstant() * field_vector;
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,456 @@
+// Vectorized kernel computing the gravitational pull of many bodies on a single body.
+// The kernel works on the structure of arrays layout of a StarSystem and processes 4, 8 or 16
+// partner bodies at once, depending on the numeric type and the available instruction set. The
+// instruction set is detected at runtime, so a single binary runs on any x86-64 machine while
+// still using AVX-512 where it is available.
+//
+// The kernel computes the unit agnostic field
+//     field = sum_j m_j (x_j - x) / |x_j - x|^3
+//     potential = sum_j m_j / |x_j - x|
+// for a target position x. Multiplying by the mass of the target body gives the same force and
+// potential energy as ForceComputerBase::pairwiseForceAndPotential. Partners at the exact position
+// of the target, such as the target itself, are skipped.
+//
+// Plummer softening only adds eps^2 to the squared distance and is vectorized. The spline kernel is
+// piecewise, and is evaluated by the scalar kernel instead.
+#ifndef SimdPairwiseKernel_H
+#define SimdPairwiseKernel_H
+
+#include <cmath>
+#include <cstddef>
+#include <string>
+
+#include "softening_kernel.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define GALAXYSIM_X86_SIMD
+#include <immintrin.h>
+#endif
+
+enum class SimdInstructionSet{ scalar, avx2, avx512 };
+
+
+inline std::string to_string(const SimdInstructionSet instruction_set){
+    switch(instruction_set){
+        case SimdInstructionSet::avx2: return "AVX2";
+        case SimdInstructionSet::avx512: return "AVX-512";
+        default: return "scalar";
+    }
+}
+
+
+// Best instruction set supported by the CPU the program is running on.
+inline SimdInstructionSet detectInstructionSet(){
+#ifdef GALAXYSIM_X86_SIMD
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f")){
+        return SimdInstructionSet::avx512;
+    }
+    if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")){
+        return SimdInstructionSet::avx2;
+    }
+#endif
+    return SimdInstructionSet::scalar;
+}
+
+
+inline bool isSupported(const SimdInstructionSet instruction_set){
+    return static_cast<int>(instruction_set) <= static_cast<int>(detectInstructionSet());
+}
+
+
+// Reference implementation, also used for the remainder of a range that does not fill a full
+// vector register.
+template<typename T, std::size_t dimension, bool compute_potential> void pairwise_kernel_scalar(
+    const T* const* positions,
+    const T* masses,
+    const std::size_t begin,
+    const std::size_t end,
+    const T* target,
+    T* field,
+    T* potential,
+    const SofteningKernel<T>& softening)
+{
+    for(std::size_t j{begin}; j < end; ++j){
+        T difference[dimension];
+        T distance_squared = 0;
+        for(std::size_t d{0}; d < dimension; ++d){
+            difference[d] = positions[d][j] - target[d];
+            distance_squared += difference[d] * difference[d];
+        }
+        if(distance_squared == 0){
+            continue;
+        }
+        T mass_over_distance;
+        T scale;
+        if(softening.type() == SofteningType::none){
+            T inverse_distance = 1 / std::sqrt(distance_squared);
+            mass_over_distance = masses[j] * inverse_distance;
+            scale = mass_over_distance * inverse_distance * inverse_distance;
+        } else {
+            softening.factors(distance_squared, scale, mass_over_distance);
+            mass_over_distance *= masses[j];
+            scale *= masses[j];
+        }
+        for(std::size_t d{0}; d < dimension; ++d){
+            field[d] += scale * difference[d];
+        }
+        if(compute_potential){
+            *potential += mass_over_distance;
+        }
+    }
+}
+
+
+#ifdef GALAXYSIM_X86_SIMD
+
+// 8 floats per register. The rsqrt approximation has a relative error of 1.5*2^-12, one
+// Newton-Raphson step brings it to single precision.
+template<std::size_t dimension, bool compute_potential> __attribute__((target("avx2,fma"))) void pairwise_kernel_avx2(
+    const float* const* positions,
+    const float* masses,
+    const std::size_t begin,
+    const std::size_t end,
+    const float* target,
+    float* field,
+    float* potential,
+    const SofteningKernel<float>& softening)
+{
+    __m256 target_v[dimension];
+    __m256 field_v[dimension];
+    for(std::size_t d{0}; d < dimension; ++d){
+        target_v[d] = _mm256_set1_ps(target[d]);
+        field_v[d] = _mm256_setzero_ps();
+    }
+    __m256 potential_v = _mm256_setzero_ps();
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 three_halves = _mm256_set1_ps(1.5f);
+    const __m256 softening_squared = _mm256_set1_ps(softening.length() * softening.length());
+
+    std::size_t j{begin};
+    for(; j + 8 <= end; j += 8){
+        __m256 difference[dimension];
+        __m256 distance_squared = zero;
+        for(std::size_t d{0}; d < dimension; ++d){
+            difference[d] = _mm256_sub_ps(_mm256_loadu_ps(positions[d] + j), target_v[d]);
+            distance_squared = _mm256_fmadd_ps(difference[d], difference[d], distance_squared);
+        }
+
+        // Coinciding bodies are recognized before softening, which would make their distance
+        // nonzero.
+        __m256 nonzero = _mm256_cmp_ps(distance_squared, zero, _CMP_GT_OQ);
+        distance_squared = _mm256_add_ps(distance_squared, softening_squared);
+        __m256 inverse_distance = _mm256_rsqrt_ps(distance_squared);
+        __m256 correction = _mm256_mul_ps(_mm256_mul_ps(half, distance_squared), _mm256_mul_ps(inverse_distance, inverse_distance));
+        inverse_distance = _mm256_mul_ps(inverse_distance, _mm256_sub_ps(three_halves, correction));
+
+        // rsqrt(0) is infinite, so coinciding bodies are masked out after the refinement.
+        inverse_distance = _mm256_and_ps(inverse_distance, nonzero);
+
+        __m256 mass_over_distance = _mm256_mul_ps(_mm256_loadu_ps(masses + j), inverse_distance);
+        __m256 scale = _mm256_mul_ps(mass_over_distance, _mm256_mul_ps(inverse_distance, inverse_distance));
+        for(std::size_t d{0}; d < dimension; ++d){
+            field_v[d] = _mm256_fmadd_ps(scale, difference[d], field_v[d]);
+        }
+        if(compute_potential){
+            potential_v = _mm256_add_ps(potential_v, mass_over_distance);
+        }
+    }
+
+    alignas(32) float lanes[8];
+    for(std::size_t d{0}; d < dimension; ++d){
+        _mm256_store_ps(lanes, field_v[d]);
+        for(float lane: lanes){
+            field[d] += lane;
+        }
+    }
+    if(compute_potential){
+        _mm256_store_ps(lanes, potential_v);
+        for(float lane: lanes){
+            *potential += lane;
+        }
+    }
+    pairwise_kernel_scalar<float, dimension, compute_potential>(positions, masses, j, end, target, field, potential, softening);
+}
+
+
+// 4 doubles per register.
+// AVX2 has no double precision rsqrt. Going through the single precision one would overflow for
+// squared distances beyond 3e38, which are common in SI units, so an exact square root and
+// division are used instead.
+template<std::size_t dimension, bool compute_potential> __attribute__((target("avx2,fma"))) void pairwise_kernel_avx2(
+    const double* const* positions,
+    const double* masses,
+    const std::size_t begin,
+    const std::size_t end,
+    const double* target,
+    double* field,
+    double* potential,
+    const SofteningKernel<double>& softening)
+{
+    __m256d target_v[dimension];
+    __m256d field_v[dimension];
+    for(std::size_t d{0}; d < dimension; ++d){
+        target_v[d] = _mm256_set1_pd(target[d]);
+        field_v[d] = _mm256_setzero_pd();
+    }
+    __m256d potential_v = _mm256_setzero_pd();
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.);
+    const __m256d softening_squared = _mm256_set1_pd(softening.length() * softening.length());
+
+    std::size_t j{begin};
+    for(; j + 4 <= end; j += 4){
+        __m256d difference[dimension];
+        __m256d distance_squared = zero;
+        for(std::size_t d{0}; d < dimension; ++d){
+            difference[d] = _mm256_sub_pd(_mm256_loadu_pd(positions[d] + j), target_v[d]);
+            distance_squared = _mm256_fmadd_pd(difference[d], difference[d], distance_squared);
+        }
+        __m256d nonzero = _mm256_cmp_pd(distance_squared, zero, _CMP_GT_OQ);
+        distance_squared = _mm256_add_pd(distance_squared, softening_squared);
+        __m256d inverse_distance = _mm256_div_pd(one, _mm256_sqrt_pd(distance_squared));
+        inverse_distance = _mm256_and_pd(inverse_distance, nonzero);
+
+        __m256d mass_over_distance = _mm256_mul_pd(_mm256_loadu_pd(masses + j), inverse_distance);
+        __m256d scale = _mm256_mul_pd(mass_over_distance, _mm256_mul_pd(inverse_distance, inverse_distance));
+        for(std::size_t d{0}; d < dimension; ++d){
+            field_v[d] = _mm256_fmadd_pd(scale, difference[d], field_v[d]);
+        }
+        if(compute_potential){
+            potential_v = _mm256_add_pd(potential_v, mass_over_distance);
+        }
+    }
+
+    alignas(32) double lanes[4];
+    for(std::size_t d{0}; d < dimension; ++d){
+        _mm256_store_pd(lanes, field_v[d]);
+        for(double lane: lanes){
+            field[d] += lane;
+        }
+    }
+    if(compute_potential){
+        _mm256_store_pd(lanes, potential_v);
+        for(double lane: lanes){
+            *potential += lane;
+        }
+    }
+    pairwise_kernel_scalar<double, dimension, compute_potential>(positions, masses, j, end, target, field, potential, softening);
+}
+
+
+// 16 floats per register. rsqrt14 has a relative error below 2^-14, one Newton-Raphson step
+// brings it to single precision.
+template<std::size_t dimension, bool compute_potential> __attribute__((target("avx512f"))) void pairwise_kernel_avx512(
+    const float* const* positions,
+    const float* masses,
+    const std::size_t begin,
+    const std::size_t end,
+    const float* target,
+    float* field,
+    float* potential,
+    const SofteningKernel<float>& softening)
+{
+    __m512 target_v[dimension];
+    __m512 field_v[dimension];
+    for(std::size_t d{0}; d < dimension; ++d){
+        target_v[d] = _mm512_set1_ps(target[d]);
+        field_v[d] = _mm512_setzero_ps();
+    }
+    __m512 potential_v = _mm512_setzero_ps();
+    const __m512 zero = _mm512_setzero_ps();
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 three_halves = _mm512_set1_ps(1.5f);
+    const __m512 softening_squared = _mm512_set1_ps(softening.length() * softening.length());
+
+    std::size_t j{begin};
+    for(; j + 16 <= end; j += 16){
+        __m512 difference[dimension];
+        __m512 distance_squared = zero;
+        for(std::size_t d{0}; d < dimension; ++d){
+            difference[d] = _mm512_sub_ps(_mm512_loadu_ps(positions[d] + j), target_v[d]);
+            distance_squared = _mm512_fmadd_ps(difference[d], difference[d], distance_squared);
+        }
+
+        // Lanes of coinciding bodies are zeroed by the mask, and stay zero during the refinement.
+        __mmask16 nonzero = _mm512_cmp_ps_mask(distance_squared, zero, _CMP_GT_OQ);
+        distance_squared = _mm512_add_ps(distance_squared, softening_squared);
+        __m512 inverse_distance = _mm512_maskz_rsqrt14_ps(nonzero, distance_squared);
+        __m512 correction = _mm512_mul_ps(_mm512_mul_ps(half, distance_squared), _mm512_mul_ps(inverse_distance, inverse_distance));
+        inverse_distance = _mm512_mul_ps(inverse_distance, _mm512_sub_ps(three_halves, correction));
+
+        __m512 mass_over_distance = _mm512_mul_ps(_mm512_loadu_ps(masses + j), inverse_distance);
+        __m512 scale = _mm512_mul_ps(mass_over_distance, _mm512_mul_ps(inverse_distance, inverse_distance));
+        for(std::size_t d{0}; d < dimension; ++d){
+            field_v[d] = _mm512_fmadd_ps(scale, difference[d], field_v[d]);
+        }
+        if(compute_potential){
+            potential_v = _mm512_add_ps(potential_v, mass_over_distance);
+        }
+    }
+
+    // Summed like the registers of the AVX2 kernel, see the double precision kernel.
+    alignas(64) float lanes[16];
+    for(std::size_t d{0}; d < dimension; ++d){
+        _mm512_store_ps(lanes, field_v[d]);
+        for(float lane: lanes){
+            field[d] += lane;
+        }
+    }
+    if(compute_potential){
+        _mm512_store_ps(lanes, potential_v);
+        for(float lane: lanes){
+            *potential += lane;
+        }
+    }
+    pairwise_kernel_scalar<float, dimension, compute_potential>(positions, masses, j, end, target, field, potential, softening);
+}
+
+
+// 8 doubles per register. rsqrt14 has a relative error below 2^-14, two Newton-Raphson steps
+// bring it to double precision.
+template<std::size_t dimension, bool compute_potential> __attribute__((target("avx512f"))) void pairwise_kernel_avx512(
+    const double* const* positions,
+    const double* masses,
+    const std::size_t begin,
+    const std::size_t end,
+    const double* target,
+    double* field,
+    double* potential,
+    const SofteningKernel<double>& softening)
+{
+    __m512d target_v[dimension];
+    __m512d field_v[dimension];
+    for(std::size_t d{0}; d < dimension; ++d){
+        target_v[d] = _mm512_set1_pd(target[d]);
+        field_v[d] = _mm512_setzero_pd();
+    }
+    __m512d potential_v = _mm512_setzero_pd();
+    const __m512d zero = _mm512_setzero_pd();
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d three_halves = _mm512_set1_pd(1.5);
+    const __m512d softening_squared = _mm512_set1_pd(softening.length() * softening.length());
+
+    std::size_t j{begin};
+    for(; j + 8 <= end; j += 8){
+        __m512d difference[dimension];
+        __m512d distance_squared = zero;
+        for(std::size_t d{0}; d < dimension; ++d){
+            difference[d] = _mm512_sub_pd(_mm512_loadu_pd(positions[d] + j), target_v[d]);
+            distance_squared = _mm512_fmadd_pd(difference[d], difference[d], distance_squared);
+        }
+        __mmask8 nonzero = _mm512_cmp_pd_mask(distance_squared, zero, _CMP_GT_OQ);
+        distance_squared = _mm512_add_pd(distance_squared, softening_squared);
+        __m512d inverse_distance = _mm512_maskz_rsqrt14_pd(nonzero, distance_squared);
+        const __m512d half_distance_squared = _mm512_mul_pd(half, distance_squared);
+        for(int iteration{0}; iteration < 2; ++iteration){
+            __m512d correction = _mm512_mul_pd(half_distance_squared, _mm512_mul_pd(inverse_distance, inverse_distance));
+            inverse_distance = _mm512_mul_pd(inverse_distance, _mm512_sub_pd(three_halves, correction));
+        }
+
+        __m512d mass_over_distance = _mm512_mul_pd(_mm512_loadu_pd(masses + j), inverse_distance);
+        __m512d scale = _mm512_mul_pd(mass_over_distance, _mm512_mul_pd(inverse_distance, inverse_distance));
+        for(std::size_t d{0}; d < dimension; ++d){
+            field_v[d] = _mm512_fmadd_pd(scale, difference[d], field_v[d]);
+        }
+        if(compute_potential){
+            potential_v = _mm512_add_pd(potential_v, mass_over_distance);
+        }
+    }
+
+    // Summed like the registers of the AVX2 kernel. The reductions and half register extractions
+    // of GCC 12 start from an undefined register, which -Wall reports as uninitialized.
+    alignas(64) double lanes[8];
+    for(std::size_t d{0}; d < dimension; ++d){
+        _mm512_store_pd(lanes, field_v[d]);
+        for(double lane: lanes){
+            field[d] += lane;
+        }
+    }
+    if(compute_potential){
+        _mm512_store_pd(lanes, potential_v);
+        for(double lane: lanes){
+            *potential += lane;
+        }
+    }
+    pairwise_kernel_scalar<double, dimension, compute_potential>(positions, masses, j, end, target, field, potential, softening);
+}
+
+#endif
+
+
+// Selects the kernel for an instruction set once, so that every call is a single indirect call
+// for a whole range of partner bodies.
+template<typename T, std::size_t dimension> class SimdPairwiseKernel{
+
+    public:
+        using kernel_type = void (*)(const T* const*, const T*, std::size_t, std::size_t, const T*, T*, T*, const SofteningKernel<T>&);
+
+        // Requesting an instruction set the CPU does not support falls back to the best one it does.
+        SimdPairwiseKernel(const SimdInstructionSet instruction_set = detectInstructionSet()){
+            setInstructionSet(instruction_set);
+        }
+
+        SimdInstructionSet instructionSet() const{ return _instruction_set; }
+
+        void setInstructionSet(SimdInstructionSet instruction_set){
+            if(!isSupported(instruction_set)){
+                instruction_set = detectInstructionSet();
+            }
+            _instruction_set = instruction_set;
+            _force_kernel = &pairwise_kernel_scalar<T, dimension, false>;
+            _force_and_potential_kernel = &pairwise_kernel_scalar<T, dimension, true>;
+#ifdef GALAXYSIM_X86_SIMD
+            if(instruction_set == SimdInstructionSet::avx2){
+                _force_kernel = &pairwise_kernel_avx2<dimension, false>;
+                _force_and_potential_kernel = &pairwise_kernel_avx2<dimension, true>;
+            } else if(instruction_set == SimdInstructionSet::avx512){
+                _force_kernel = &pairwise_kernel_avx512<dimension, false>;
+                _force_and_potential_kernel = &pairwise_kernel_avx512<dimension, true>;
+            }
+#endif
+        }
+
+        // Add the field of the bodies in [begin, end) at the target position to field.
+        void field(
+            const T* const* positions,
+            const T* masses,
+            const std::size_t begin,
+            const std::size_t end,
+            const T* target,
+            T* field,
+            const SofteningKernel<T>& softening = SofteningKernel<T>()) const
+        {
+            if(softening.type() == SofteningType::spline){
+                pairwise_kernel_scalar<T, dimension, false>(positions, masses, begin, end, target, field, nullptr, softening);
+            } else {
+                _force_kernel(positions, masses, begin, end, target, field, nullptr, softening);
+            }
+        }
+
+        // Add the field and the potential of the bodies in [begin, end) at the target position.
+        void fieldAndPotential(
+            const T* const* positions,
+            const T* masses,
+            const std::size_t begin,
+            const std::size_t end,
+            const T* target,
+            T* field,
+            T* potential,
+            const SofteningKernel<T>& softening = SofteningKernel<T>()) const
+        {
+            if(softening.type() == SofteningType::spline){
+                pairwise_kernel_scalar<T, dimension, true>(positions, masses, begin, end, target, field, potential, softening);
+            } else {
+                _force_and_potential_kernel(positions, masses, begin, end, target, field, potential, softening);
+            }
+        }
+
+    private:
+        SimdInstructionSet _instruction_set;
+        kernel_type _force_kernel;
+        kernel_type _force_and_potential_kernel;
+};
+
+#endif
@@ -0,0 +1,141 @@
+// Gravitational softening of the pairwise interaction.
+// Without softening the pull between two bodies grows as 1/r^2 without bound, so close encounters
+// produce huge accelerations and force tiny time steps. Softening replaces the point masses by
+// smoothed mass distributions below a softening length, which bounds the force and the potential.
+//
+// A kernel provides two unit agnostic factors for a squared distance r^2:
+//     force factor g(r): the force exerted on the lhs body is m_lhs m_rhs (x_rhs - x_lhs) g(r)
+//     potential factor p(r): the potential energy of the pair is m_lhs m_rhs p(r)
+// Without softening g(r) = 1/r^3 and p(r) = 1/r. The force factor always equals -p'(r)/r, so the
+// force remains the gradient of the potential and energy checks stay meaningful.
+#ifndef SofteningKernel_H
+#define SofteningKernel_H
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+enum class SofteningType{
+    // Point masses, no softening.
+    none,
+
+    // Plummer spheres: p(r) = 1/sqrt(r^2 + eps^2). The force deviates from the Newtonian one at
+    // every distance, but by less than 1% beyond 10 eps.
+    plummer,
+
+    // Cubic spline kernel of Monaghan & Lattanzio, as used by GADGET. The interaction is exactly
+    // Newtonian beyond h = 2.8 eps, and the potential at r = 0 is -1/eps as for a Plummer sphere.
+    spline
+};
+
+
+inline std::string to_string(const SofteningType type){
+    switch(type){
+        case SofteningType::plummer: return "Plummer";
+        case SofteningType::spline: return "spline";
+        default: return "none";
+    }
+}
+
+
+template<typename T> class SofteningKernel{
+
+    public:
+        // Ratio between the support of the spline kernel and the Plummer equivalent softening
+        // length.
+        static constexpr T spline_support = T(2.8);
+
+        // No softening by default.
+        SofteningKernel() = default;
+
+        // The softening length eps is the Plummer equivalent length for both kernels.
+        SofteningKernel(const SofteningType type, const T length):
+            _type(type),
+            _length(type == SofteningType::none ? T(0) : length)
+        {
+            if(type != SofteningType::none && !(length > 0)){
+                throw std::invalid_argument("The softening length must be positive, got " + std::to_string(length) + ".");
+            }
+            if(type == SofteningType::spline){
+                _inverse_support = 1 / (spline_support * _length);
+            }
+        }
+
+        static SofteningKernel none(){ return SofteningKernel(); }
+        static SofteningKernel plummer(const T length){ return SofteningKernel(SofteningType::plummer, length); }
+        static SofteningKernel spline(const T length){ return SofteningKernel(SofteningType::spline, length); }
+
+        SofteningType type() const{ return _type; }
+        T length() const{ return _length; }
+
+        T forceFactor(const T distance_squared) const{
+            T force_factor;
+            T potential_factor;
+            factors(distance_squared, force_factor, potential_factor);
+            return force_factor;
+        }
+
+        T potentialFactor(const T distance_squared) const{
+            T force_factor;
+            T potential_factor;
+            factors(distance_squared, force_factor, potential_factor);
+            return potential_factor;
+        }
+
+        // Both factors at once, sharing the square root.
+        void factors(const T distance_squared, T& force_factor, T& potential_factor) const{
+            switch(_type){
+                case SofteningType::plummer:{
+                    T inverse_distance = 1 / std::sqrt(distance_squared + _length * _length);
+                    potential_factor = inverse_distance;
+                    force_factor = inverse_distance * inverse_distance * inverse_distance;
+                    return;
+                }
+                case SofteningType::spline:
+                    splineFactors(distance_squared, force_factor, potential_factor);
+                    return;
+                default:{
+                    T inverse_distance = 1 / std::sqrt(distance_squared);
+                    potential_factor = inverse_distance;
+                    force_factor = inverse_distance * inverse_distance * inverse_distance;
+                    return;
+                }
+            }
+        }
+
+    private:
+        SofteningType _type = SofteningType::none;
+        T _length = 0;
+        T _inverse_support = 0;
+
+        // Polynomials of u = r/h for the two halves of the kernel support, see Springel, Yoshida &
+        // White (2001), New Astronomy 6, 79.
+        void splineFactors(const T distance_squared, T& force_factor, T& potential_factor) const{
+            const T distance = std::sqrt(distance_squared);
+            const T u = distance * _inverse_support;
+            if(u >= 1){
+                T inverse_distance = 1 / distance;
+                potential_factor = inverse_distance;
+                force_factor = inverse_distance * inverse_distance * inverse_distance;
+                return;
+            }
+
+            const T h_inverse = _inverse_support;
+            const T h_inverse_cubed = h_inverse * h_inverse * h_inverse;
+            const T u2 = u * u;
+            if(u < T(0.5)){
+                force_factor = h_inverse_cubed * (T(32) / 3 + u2 * (32 * u - T(38.4)));
+                potential_factor = h_inverse * (T(2.8) - u2 * (T(16) / 3 + u2 * (T(6.4) * u - T(9.6))));
+            } else {
+                const T u3 = u2 * u;
+                force_factor = h_inverse_cubed * (
+                    T(64) / 3 - 48 * u + T(38.4) * u2 - T(32) / 3 * u3 - 1 / (15 * u3)
+                );
+                potential_factor = h_inverse * (
+                    T(3.2) - 1 / (15 * u) - u2 * (T(32) / 3 + u * (-16 + u * (T(9.6) - T(32) / 15 * u)))
+                );
+            }
+        }
+};
+
+#endif
@@ -0,0 +1,81 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/direct_sum_force_computer.h"
+#include "../include/simd_direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+// A gravitational constant other than one, so that forgetting to fold it in is noticed.
+constexpr numeric_type G = 2.5;
+
+
+// The accelerations written into the buffer must be the forces divided by the masses, with the
+// gravitational constant included, with and without the potential.
+void check_accelerations(ForceComputerBase<body_type>& force_computer, const std::string& name){
+    constexpr std::size_t num_bodies = 517;
+    constexpr numeric_type tolerance = 1e-12;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::uniform_real_distribution<numeric_type> mass(0.1, 5.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vector_type(0., 0., 0.), mass(random_device));
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    star_system.computeForcesAndPotential(force_computer);
+    std::vector<vector_type> forces(num_bodies);
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        forces[b] = force_computer.totalForce(b);
+    }
+    const numeric_type potential = force_computer.potentialEnergy();
+
+    for(const bool with_potential: {false, true}){
+        std::vector<vector_type> accelerations;
+        if(with_potential){
+            star_system.computeAccelerationsAndPotential(force_computer, accelerations);
+        } else {
+            star_system.computeAccelerations(force_computer, accelerations);
+        }
+        const std::string description = name + (with_potential ? " with the potential" : " without the potential");
+        if(accelerations.size() != num_bodies){
+            throw std::runtime_error("The " + description + " wrote " + std::to_string(accelerations.size()) + " accelerations for " + std::to_string(num_bodies) + " bodies.\n");
+        }
+        for(std::size_t b{0}; b < num_bodies; ++b){
+            const vector_type expected = forces[b] / star_system.mass(b);
+            if(abs(accelerations[b] - expected) > tolerance * abs(expected)){
+                throw std::runtime_error("The acceleration of body " + std::to_string(b) + " computed by the " + description + " is not its force divided by its mass.\n");
+            }
+        }
+        if(with_potential && std::abs(force_computer.potentialEnergy() - potential) > tolerance * std::abs(potential)){
+            throw std::runtime_error("The potential energy computed with the accelerations by the " + name + " differs from the one computed with the forces.\n");
+        }
+    }
+    std::cout << "Checked the accelerations of the " << name << "." << std::endl;
+}
+
+
+int main(){
+    DirectSumForceComputer<body_type> direct_sum(G);
+    check_accelerations(direct_sum, "direct summation");
+
+    for(SimdInstructionSet instruction_set: {SimdInstructionSet::scalar, SimdInstructionSet::avx2, SimdInstructionSet::avx512}){
+        if(!isSupported(instruction_set)){
+            std::cout << to_string(instruction_set) << " is not supported on this CPU, skipping it." << std::endl;
+            continue;
+        }
+        SimdDirectSumForceComputer<body_type> simd(G, instruction_set);
+        check_accelerations(simd, to_string(instruction_set) + " kernel");
+    }
+}
@@ -0,0 +1,86 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/barnes_hut_force_computer.h"
+#include "../include/direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector2D.h"
+#include "../../vector/include/vector3D.h"
+
+
+template<typename BodyType> StarSystem<BodyType> random_star_system(const std::size_t num_bodies, const unsigned seed);
+
+template<> StarSystem<Body<Vector3D<double>>> random_star_system(const std::size_t num_bodies, const unsigned seed){
+    std::mt19937 random_device{seed};
+    std::uniform_real_distribution<double> uniform(0., 10.);
+    std::vector<Body<Vector3D<double>>> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        Vector3D<double> pos(uniform(random_device), uniform(random_device), uniform(random_device));
+        Vector3D<double> vel(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = Body<Vector3D<double>>(pos, vel, uniform(random_device));
+    }
+    return StarSystem<Body<Vector3D<double>>>(bodies);
+}
+
+template<> StarSystem<Body<Vector2D<double>>> random_star_system(const std::size_t num_bodies, const unsigned seed){
+    std::mt19937 random_device{seed};
+    std::uniform_real_distribution<double> uniform(0., 10.);
+    std::vector<Body<Vector2D<double>>> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        Vector2D<double> pos(uniform(random_device), uniform(random_device));
+        Vector2D<double> vel(uniform(random_device), uniform(random_device));
+        bodies[i] = Body<Vector2D<double>>(pos, vel, uniform(random_device));
+    }
+    return StarSystem<Body<Vector2D<double>>>(bodies);
+}
+
+
+// Root-mean-square of the relative force errors of the Barnes-Hut approximation with respect to
+// the direct summation. The relative error of the potential energy is returned as second value.
+template<typename BodyType> std::pair<double, double> relative_errors(const StarSystem<BodyType>& star_system, const double opening_angle){
+    DirectSumForceComputer<BodyType> direct_sum(1.);
+    BarnesHutForceComputer<BodyType> barnes_hut(1., opening_angle);
+    star_system.computeForcesAndPotential(direct_sum);
+    star_system.computeForcesAndPotential(barnes_hut);
+
+    double sum_squared_error = 0.;
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        auto exact = direct_sum.totalForce(b);
+        auto approximate = barnes_hut.totalForce(b);
+        sum_squared_error += square(approximate - exact) / square(exact);
+    }
+    double force_error = std::sqrt(sum_squared_error / star_system.size());
+    double potential_error = std::abs(barnes_hut.potentialEnergy() - direct_sum.potentialEnergy()) / std::abs(direct_sum.potentialEnergy());
+    return {force_error, potential_error};
+}
+
+
+template<typename BodyType> void check_accuracy(const std::string& name, const double opening_angle, const double max_force_error, const double max_potential_error){
+    auto star_system = random_star_system<BodyType>(2000, 0);
+    auto errors = relative_errors(star_system, opening_angle);
+    std::cout << name << " | opening angle " << opening_angle << " | RMS relative force error = " << errors.first << " | relative potential error = " << errors.second << std::endl;
+    if(errors.first > max_force_error || errors.second > max_potential_error){
+        std::string error_message = "Barnes-Hut force computation for " + name + " with opening angle " + std::to_string(opening_angle) + " deviates too much from the direct summation.\n";
+        throw std::runtime_error(error_message);
+    }
+}
+
+
+int main(){
+
+    // An opening angle of zero opens every cell, so the result should equal the direct summation up
+    // to the order in which the terms are summed.
+    check_accuracy<Body<Vector3D<double>>>("octree", 0., 1e-12, 1e-12);
+    check_accuracy<Body<Vector2D<double>>>("quadtree", 0., 1e-12, 1e-12);
+
+    // The error grows with the opening angle. The forces in a uniform distribution largely cancel,
+    // so the relative errors are larger than they would be in a clustered system.
+    check_accuracy<Body<Vector3D<double>>>("octree", 0.3, 5e-3, 1e-4);
+    check_accuracy<Body<Vector3D<double>>>("octree", 0.5, 2e-2, 1e-3);
+    check_accuracy<Body<Vector2D<double>>>("quadtree", 0.5, 5e-2, 1e-2);
+    check_accuracy<Body<Vector3D<double>>>("octree", 1.0, 1e-1, 1e-2);
+}
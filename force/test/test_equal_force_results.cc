@@ -1,9 +1,12 @@
+#include <cmath>
 #include <iostream>
 #include <random>
 #include<string>
+#include <vector>
 
 #include "../include/direct_sum_force_computer.h"
 #include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
 #include "../../vector/include/vector3D.h"
 
 int main(){
@@ -38,4 +41,18 @@ int main(){
         }
     }
 
+    // The potential energy includes the gravitational constant and its sign: -G sum m_i m_j / r_ij.
+    constexpr numeric_type G = 2.;
+    DirectSumForceComputer<body_type> scaled_force_computer(G);
+    std::vector<body_type> triangle{
+        body_type(vector_type(0., 0., 0.), vector_type(), 1.),
+        body_type(vector_type(3., 0., 0.), vector_type(), 2.),
+        body_type(vector_type(0., 4., 0.), vector_type(), 3.)
+    };
+    StarSystem<body_type> star_system(triangle);
+    star_system.computeForcesAndPotential(scaled_force_computer);
+    const numeric_type expected = -G * (1. * 2. / 3. + 1. * 3. / 4. + 2. * 3. / 5.);
+    if(std::abs(scaled_force_computer.potentialEnergy() - expected) > 1e-12 * std::abs(expected)){
+        throw std::runtime_error("The potential energy is " + std::to_string(scaled_force_computer.potentialEnergy()) + " instead of " + std::to_string(expected) + ".\n");
+    }
 }
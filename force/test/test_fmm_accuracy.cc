@@ -0,0 +1,78 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/direct_sum_force_computer.h"
+#include "../include/fast_multipole_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+
+// Root-mean-square of the relative force errors of the fast multipole method with respect to the
+// direct summation. The relative error of the potential energy is returned as second value.
+std::pair<double, double> relative_errors(
+    const StarSystem<body_type>& star_system,
+    DirectSumForceComputer<body_type>& direct_sum,
+    const unsigned order,
+    const double opening_angle)
+{
+    FastMultipoleForceComputer<body_type> fast_multipole(1., order, opening_angle);
+    star_system.computeForcesAndPotential(fast_multipole);
+
+    double sum_squared_error = 0.;
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        auto exact = direct_sum.totalForce(b);
+        auto approximate = fast_multipole.totalForce(b);
+        sum_squared_error += square(approximate - exact) / square(exact);
+    }
+    double force_error = std::sqrt(sum_squared_error / star_system.size());
+    double potential_error = std::abs(fast_multipole.potentialEnergy() - direct_sum.potentialEnergy()) / std::abs(direct_sum.potentialEnergy());
+    return {force_error, potential_error};
+}
+
+
+int main(){
+    // A uniform cube and a centrally concentrated Plummer-like sphere.
+    constexpr std::size_t num_bodies = 4000;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 1.);
+    std::vector<body_type> uniform_bodies(num_bodies);
+    std::vector<body_type> clustered_bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        uniform_bodies[i] = body_type(10. * pos, vector_type(), uniform(random_device));
+
+        const numeric_type radius = 1. / std::sqrt(std::pow(uniform(random_device), -2. / 3.) - 1.);
+        const numeric_type cos_theta = 2. * uniform(random_device) - 1.;
+        const numeric_type sin_theta = std::sqrt(1. - cos_theta * cos_theta);
+        const numeric_type phi = 2. * 3.14159265358979323846 * uniform(random_device);
+        vector_type clustered_pos(radius * sin_theta * std::cos(phi), radius * sin_theta * std::sin(phi), radius * cos_theta);
+        clustered_bodies[i] = body_type(clustered_pos, vector_type(), 1. / num_bodies);
+    }
+
+    // Upper bounds on the force and potential errors at opening angle 0.5 for increasing orders.
+    // Each order reduces the force error by roughly the opening angle.
+    const std::vector<std::pair<unsigned, double>> max_errors{
+        {1, 2e-1}, {2, 5e-2}, {4, 6e-3}, {6, 1e-3}, {8, 2e-4}
+    };
+    for(const auto& distribution: {std::make_pair("uniform cube", &uniform_bodies), std::make_pair("Plummer sphere", &clustered_bodies)}){
+        StarSystem<body_type> star_system(*distribution.second);
+        DirectSumForceComputer<body_type> direct_sum(1.);
+        star_system.computeForcesAndPotential(direct_sum);
+        for(const auto& order_and_error: max_errors){
+            const unsigned order = order_and_error.first;
+            auto errors = relative_errors(star_system, direct_sum, order, 0.5);
+            std::cout << distribution.first << " | order " << order << " | RMS relative force error = " << errors.first << " | relative potential error = " << errors.second << std::endl;
+            if(errors.first > order_and_error.second || errors.second > order_and_error.second){
+                throw std::runtime_error("Fast multipole force computation of order " + std::to_string(order) + " for a " + distribution.first + " deviates too much from the direct summation.\n");
+            }
+        }
+    }
+}
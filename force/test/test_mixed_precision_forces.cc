@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/simd_direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+
+// Compare the mixed precision kernel with the all-double one for a cube of bodies at the given
+// offset from the origin of the coordinates. The local origins should make the error independent
+// of the offset.
+void check_offset(const SimdInstructionSet instruction_set, const numeric_type offset){
+    // The number of bodies is not a multiple of the block or chunk size.
+    constexpr std::size_t num_bodies = 3001;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos + vector_type(offset, offset, offset), vector_type(), uniform(random_device));
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    SimdDirectSumForceComputer<body_type> all_double(1., instruction_set);
+    SimdDirectSumForceComputer<body_type, float> mixed(1., instruction_set);
+    star_system.computeForcesAndPotential(all_double);
+    std::vector<vector_type> accelerations;
+    star_system.computeAccelerationsAndPotential(mixed, accelerations);
+
+    numeric_type max_error = 0.;
+    numeric_type sum_squared_error = 0.;
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        const vector_type exact = all_double.totalForce(b);
+        const numeric_type error = abs(mixed.totalForce(b) - exact) / abs(exact);
+        max_error = std::max(max_error, error);
+        sum_squared_error += error * error;
+        if(abs(star_system.mass(b) * accelerations[b] - mixed.totalForce(b)) > 1e-14 * abs(mixed.totalForce(b))){
+            throw std::runtime_error("The mixed precision accelerations do not match the mixed precision forces.\n");
+        }
+    }
+    const numeric_type rms_error = std::sqrt(sum_squared_error / num_bodies);
+    const numeric_type potential_error = std::abs(mixed.potentialEnergy() / all_double.potentialEnergy() - 1);
+    std::cout << to_string(instruction_set) << " kernel | offset " << offset << " | RMS relative force error = " << rms_error << " | maximum relative force error = " << max_error << " | relative potential error = " << potential_error << std::endl;
+
+    if(max_error > 1e-4 || rms_error > 1e-5 || potential_error > 1e-7){
+        throw std::runtime_error("The mixed precision forces with the " + to_string(instruction_set) + " kernel at offset " + std::to_string(offset) + " deviate too much from the all-double forces.\n");
+    }
+}
+
+
+// A dense core far from the center of a large, sparse system, with the bodies in random order.
+// The differences between the positions of the core bodies are only resolved in float relative
+// to a local origin in the core, so the core must get its own blocks.
+void check_dense_core(const SimdInstructionSet instruction_set){
+    constexpr std::size_t num_core_bodies = 600;
+    constexpr std::size_t num_bodies = 3001;
+    const vector_type core_center(300., 300., 300.);
+    std::mt19937 random_device{1};
+    std::uniform_real_distribution<numeric_type> uniform(-1., 1.);
+    std::vector<body_type> bodies;
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        const vector_type direction(uniform(random_device), uniform(random_device), uniform(random_device));
+        const vector_type pos = (i < num_core_bodies ? core_center + 1e-2 * direction : 500. * direction);
+        bodies.push_back(body_type(pos, vector_type(), 1.));
+    }
+    std::shuffle(bodies.begin(), bodies.end(), random_device);
+    StarSystem<body_type> star_system(bodies);
+
+    SimdDirectSumForceComputer<body_type> all_double(1., instruction_set);
+    SimdDirectSumForceComputer<body_type, float> mixed(1., instruction_set);
+    star_system.computeForces(all_double);
+    star_system.computeForces(mixed);
+    numeric_type max_error = 0.;
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        if(abs(star_system.position(b) - core_center) < 1.){
+            const vector_type exact = all_double.totalForce(b);
+            max_error = std::max(max_error, abs(mixed.totalForce(b) - exact) / abs(exact));
+        }
+    }
+    std::cout << to_string(instruction_set) << " kernel | dense core | maximum relative force error = " << max_error << std::endl;
+    if(max_error > 1e-4){
+        throw std::runtime_error("The mixed precision forces in the dense core with the " + to_string(instruction_set) + " kernel deviate too much from the all-double forces.\n");
+    }
+}
+
+
+int main(){
+    for(SimdInstructionSet instruction_set: {SimdInstructionSet::scalar, SimdInstructionSet::avx2, SimdInstructionSet::avx512}){
+        if(!isSupported(instruction_set)){
+            std::cout << to_string(instruction_set) << " is not supported on this CPU, skipping it." << std::endl;
+            continue;
+        }
+
+        // At an offset of 1e5 a float has a resolution of about 0.01, a thousandth of the size
+        // of the cube.
+        check_offset(instruction_set, 0.);
+        check_offset(instruction_set, 1e5);
+        check_dense_core(instruction_set);
+    }
+}
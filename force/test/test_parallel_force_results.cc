@@ -0,0 +1,81 @@
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/direct_sum_force_computer.h"
+#include "../include/parallel_direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+int main(){
+    using numeric_type = double;
+    using vector_type = Vector3D<numeric_type>;
+    using body_type = Body<vector_type>;
+
+    // The number of bodies is chosen not to be a multiple of the block size, so that the last
+    // block is only partially filled.
+    constexpr std::size_t num_bodies = 1000;
+    constexpr std::size_t block_size = 64;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        numeric_type mass = uniform(random_device);
+        bodies[i] = body_type(pos, vel, mass);
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    DirectSumForceComputer<body_type> direct_sum(1.);
+    star_system.computeForcesAndPotential(direct_sum);
+
+    ParallelDirectSumForceComputer<body_type> reference(1., 1, block_size);
+
+    // The force-only computation and the force-and-potential computation evaluate slightly different
+    // expressions, so each is compared to the single threaded result of the same computation.
+    for(bool with_potential: {false, true}){
+        if(with_potential){
+            star_system.computeForcesAndPotential(reference);
+        } else {
+            star_system.computeForces(reference);
+        }
+
+        for(std::size_t num_threads: {2, 3, 4, 7, 16}){
+            ParallelDirectSumForceComputer<body_type> parallel(1., num_threads, block_size);
+
+            // The tile size can still be set through the base class, but must not change the
+            // blocks of the parallel computation.
+            static_cast<DirectSumForceComputer<body_type>&>(parallel).setTileSize(block_size + 13);
+            if(with_potential){
+                star_system.computeForcesAndPotential(parallel);
+            } else {
+                star_system.computeForces(parallel);
+            }
+
+            for(std::size_t b{0}; b < num_bodies; ++b){
+                vector_type force = parallel.totalForce(b);
+                vector_type reference_force = reference.totalForce(b);
+
+                // The reduction must be deterministic, so the results have to be bit-identical.
+                if(force.x() != reference_force.x() || force.y() != reference_force.y() || force.z() != reference_force.z()){
+                    std::string error_message = "Force computation with " + std::to_string(num_threads) + " threads is not identical to the single threaded result.\n";
+                    throw std::runtime_error(error_message);
+                }
+
+                // Only the order of the summation differs from the serial direct summation.
+                if(abs(force - direct_sum.totalForce(b)) > 1e-10 * abs(direct_sum.totalForce(b))){
+                    std::string error_message = "Parallel force computation differs from the direct summation.\n";
+                    throw std::runtime_error(error_message);
+                }
+            }
+            if(with_potential && parallel.potentialEnergy() != reference.potentialEnergy()){
+                std::string error_message = "Potential energy with " + std::to_string(num_threads) + " threads is not identical to the single threaded result.\n";
+                throw std::runtime_error(error_message);
+            }
+        }
+    }
+    std::cout << "Test run successfully." << std::endl;
+}
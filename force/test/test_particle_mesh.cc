@@ -0,0 +1,103 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/direct_sum_force_computer.h"
+#include "../include/particle_mesh_force_computer.h"
+#include "../include/softening_kernel.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+
+// The pull of a single mass on light test bodies at increasing distances. Beyond a few cells the
+// force has to be Newtonian, in particular without the pull of periodic images. Below that the
+// force depends on the position of the bodies relative to the grid.
+void check_point_mass(const MassAssignment assignment){
+    constexpr std::size_t num_test_bodies = 100;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(-1., 1.);
+    std::vector<body_type> bodies;
+    bodies.push_back(body_type(vector_type(), vector_type(), 1.));
+    for(std::size_t i = 0; i < num_test_bodies; ++i){
+        const vector_type direction(uniform(random_device), uniform(random_device), uniform(random_device));
+        const numeric_type distance = 1. + 9. * static_cast<numeric_type>(i) / num_test_bodies;
+        bodies.push_back(body_type(distance * direction / abs(direction), vector_type(), 1e-10));
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    ParticleMeshForceComputer<body_type> particle_mesh(1., 64, assignment);
+    star_system.computeForces(particle_mesh);
+    const numeric_type cell_size = particle_mesh.cellSize();
+
+    numeric_type max_error = 0.;
+    for(std::size_t b{1}; b < star_system.size(); ++b){
+        const vector_type position = star_system.position(b);
+        const numeric_type distance = abs(position);
+        if(distance < 6 * cell_size){
+            continue;
+        }
+        const vector_type exact = -star_system.mass(b) * position / (distance * distance * distance);
+        max_error = std::max(max_error, abs(particle_mesh.totalForce(b) - exact) / abs(exact));
+    }
+    std::cout << to_string(assignment) << " | point mass | maximum relative force error beyond 6 cells = " << max_error << std::endl;
+    if(max_error > 1e-2){
+        throw std::runtime_error("The particle-mesh pull of a point mass with " + to_string(assignment) + " assignment is not Newtonian.\n");
+    }
+}
+
+
+// A uniform cube compared with the direct summation, softened on the scale of the grid cells.
+// The forces on all bodies have to add up to zero, as the assignment and the interpolation use the
+// same weights.
+void check_uniform_cube(const MassAssignment assignment){
+    constexpr std::size_t num_bodies = 4000;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 1.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vector_type(), uniform(random_device) / num_bodies);
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    ParticleMeshForceComputer<body_type> particle_mesh(1., 64, assignment);
+    star_system.computeForcesAndPotential(particle_mesh);
+    DirectSumForceComputer<body_type> direct_sum(1.);
+    direct_sum.setSoftening(SofteningKernel<numeric_type>::plummer(particle_mesh.cellSize()));
+    star_system.computeForcesAndPotential(direct_sum);
+
+    numeric_type sum_squared_error = 0.;
+    vector_type total_force;
+    numeric_type sum_force_magnitudes = 0.;
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        const vector_type exact = direct_sum.totalForce(b);
+        sum_squared_error += square(particle_mesh.totalForce(b) - exact) / square(exact);
+        total_force += particle_mesh.totalForce(b);
+        sum_force_magnitudes += abs(particle_mesh.totalForce(b));
+    }
+    const numeric_type force_error = std::sqrt(sum_squared_error / star_system.size());
+    const numeric_type potential_error = std::abs(particle_mesh.potentialEnergy() / direct_sum.potentialEnergy() - 1);
+    const numeric_type momentum_error = abs(total_force) / sum_force_magnitudes;
+    std::cout << to_string(assignment) << " | uniform cube | RMS relative force error = " << force_error << " | relative potential error = " << potential_error << " | relative total force = " << momentum_error << std::endl;
+    if(force_error > 0.1 || potential_error > 1e-2){
+        throw std::runtime_error("The particle-mesh forces with " + to_string(assignment) + " assignment deviate too much from the direct summation.\n");
+    }
+    if(momentum_error > 1e-12){
+        throw std::runtime_error("The particle-mesh forces with " + to_string(assignment) + " assignment do not conserve momentum.\n");
+    }
+}
+
+
+int main(){
+    for(const MassAssignment assignment: {MassAssignment::cic, MassAssignment::tsc}){
+        check_point_mass(assignment);
+        check_uniform_cube(assignment);
+    }
+}
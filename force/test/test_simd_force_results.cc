@@ -0,0 +1,76 @@
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/direct_sum_force_computer.h"
+#include "../include/simd_direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector2D.h"
+#include "../../vector/include/vector3D.h"
+#include "../../vector/include/vector_traits.h"
+
+
+template<typename VectorType> void check_instruction_set(const SimdInstructionSet instruction_set, const double tolerance){
+    using numeric_type = typename VectorType::value_type;
+    using body_type = Body<VectorType>;
+    using traits = vector_traits<VectorType>;
+
+    // The number of bodies is not a multiple of any vector width, so the remainder loop is tested
+    // as well.
+    constexpr std::size_t num_bodies = 1003;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        std::array<numeric_type, traits::dimension> pos;
+        std::array<numeric_type, traits::dimension> vel;
+        for(std::size_t d{0}; d < traits::dimension; ++d){
+            pos[d] = uniform(random_device);
+            vel[d] = uniform(random_device);
+        }
+        bodies[i] = body_type(traits::make(pos), traits::make(vel), uniform(random_device));
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    DirectSumForceComputer<body_type> direct_sum(1.);
+    SimdDirectSumForceComputer<body_type> simd(1., instruction_set);
+    star_system.computeForcesAndPotential(direct_sum);
+    star_system.computeForcesAndPotential(simd);
+
+    const std::string name = to_string(instruction_set) + " kernel with " + std::to_string(traits::dimension) + "D vectors of " + std::to_string(sizeof(numeric_type)) + "-byte numbers";
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        if(abs(simd.totalForce(b) - direct_sum.totalForce(b)) > tolerance * abs(direct_sum.totalForce(b))){
+            throw std::runtime_error("Force computed with the " + name + " differs from the direct summation.\n");
+        }
+    }
+    if(std::abs(simd.potentialEnergy() - direct_sum.potentialEnergy()) > tolerance * std::abs(direct_sum.potentialEnergy())){
+        throw std::runtime_error("Potential energy computed with the " + name + " differs from the direct summation.\n");
+    }
+
+    // The force-only path should agree with the force-and-potential path.
+    star_system.computeForces(simd);
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        if(abs(simd.totalForce(b) - direct_sum.totalForce(b)) > tolerance * abs(direct_sum.totalForce(b))){
+            throw std::runtime_error("Force-only computation with the " + name + " differs from the direct summation.\n");
+        }
+    }
+    std::cout << "Checked the " << name << "." << std::endl;
+}
+
+
+int main(){
+    for(SimdInstructionSet instruction_set: {SimdInstructionSet::scalar, SimdInstructionSet::avx2, SimdInstructionSet::avx512}){
+        if(!isSupported(instruction_set)){
+            std::cout << to_string(instruction_set) << " is not supported on this CPU, skipping it." << std::endl;
+            continue;
+        }
+        check_instruction_set<Vector3D<double>>(instruction_set, 1e-12);
+        check_instruction_set<Vector2D<double>>(instruction_set, 1e-12);
+
+        // The float results are limited by the accumulation over a thousand partners.
+        check_instruction_set<Vector3D<float>>(instruction_set, 1e-4);
+        check_instruction_set<Vector2D<float>>(instruction_set, 1e-4);
+    }
+}
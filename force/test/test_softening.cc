@@ -0,0 +1,120 @@
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/barnes_hut_force_computer.h"
+#include "../include/direct_sum_force_computer.h"
+#include "../include/parallel_direct_sum_force_computer.h"
+#include "../include/simd_direct_sum_force_computer.h"
+#include "../include/softening_kernel.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+
+// The force factor has to be -p'(r)/r for the force to be the gradient of the potential, and both
+// factors have to be continuous.
+void check_kernel(const SofteningKernel<double>& kernel){
+    const std::string name = to_string(kernel.type()) + " softening";
+    const double length = kernel.length();
+
+    // Both kernels have the potential of a Plummer sphere at the origin.
+    if(std::abs(kernel.potentialFactor(0.) - 1 / length) > 1e-12 / length){
+        throw std::runtime_error("The potential at zero distance with " + name + " differs from 1/eps.\n");
+    }
+
+    for(double distance = 0.01 * length; distance < 5 * length; distance += 0.01 * length){
+        const double step = 1e-5 * length;
+        const double derivative = (
+            kernel.potentialFactor((distance + step) * (distance + step)) -
+            kernel.potentialFactor((distance - step) * (distance - step))
+        ) / (2 * step);
+        const double force_factor = kernel.forceFactor(distance * distance);
+        if(std::abs(force_factor + derivative / distance) > 1e-6 * force_factor){
+            throw std::runtime_error("The force with " + name + " is not the gradient of the potential at r = " + std::to_string(distance) + ".\n");
+        }
+
+        // The Newtonian interaction is an upper bound.
+        if(kernel.forceFactor(distance * distance) > 1 / (distance * distance * distance) * (1 + 1e-12)){
+            throw std::runtime_error("The force with " + name + " exceeds the Newtonian force.\n");
+        }
+    }
+
+    if(kernel.type() == SofteningType::spline){
+        const double support = SofteningKernel<double>::spline_support * length;
+        for(double u: {0.5, 1.}){
+            const double below = (u * support) * (1 - 1e-12);
+            const double above = (u * support) * (1 + 1e-12);
+            if(std::abs(kernel.potentialFactor(below * below) - kernel.potentialFactor(above * above)) > 1e-9 / length ||
+               std::abs(kernel.forceFactor(below * below) - kernel.forceFactor(above * above)) > 1e-9 / (length * length * length)){
+                throw std::runtime_error("The spline kernel is discontinuous at u = " + std::to_string(u) + ".\n");
+            }
+        }
+        const double distance = 1.5 * support;
+        const double newtonian = 1 / (distance * distance * distance);
+        if(std::abs(kernel.forceFactor(distance * distance) - newtonian) > 1e-14 * newtonian){
+            throw std::runtime_error("The spline kernel is not Newtonian beyond its support.\n");
+        }
+    }
+    std::cout << "Checked the " << name << " kernel." << std::endl;
+}
+
+
+// All force computers should apply the same softening to the force and the potential.
+void check_force_computers(const SofteningKernel<double>& softening){
+    using vector_type = Vector3D<double>;
+    using body_type = Body<vector_type>;
+
+    // A dense cluster, so that many pairs are closer than the softening length.
+    constexpr std::size_t num_bodies = 501;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<double> uniform(0., 1.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vector_type(), uniform(random_device));
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    DirectSumForceComputer<body_type> reference(1.);
+    reference.setSoftening(softening);
+    star_system.computeForcesAndPotential(reference);
+
+    const std::string name = to_string(softening.type()) + " softening";
+    auto compare = [&](ForceComputerBase<body_type>& force_computer, const std::string& computer_name){
+        force_computer.setSoftening(softening);
+        star_system.computeForcesAndPotential(force_computer);
+        for(std::size_t b{0}; b < num_bodies; ++b){
+            if(abs(force_computer.totalForce(b) - reference.totalForce(b)) > 1e-10 * abs(reference.totalForce(b))){
+                throw std::runtime_error("Force computed by the " + computer_name + " with " + name + " differs from the direct summation.\n");
+            }
+        }
+        if(std::abs(force_computer.potentialEnergy() - reference.potentialEnergy()) > 1e-10 * std::abs(reference.potentialEnergy())){
+            throw std::runtime_error("Potential energy computed by the " + computer_name + " with " + name + " differs from the direct summation.\n");
+        }
+    };
+
+    ParallelDirectSumForceComputer<body_type> parallel(1., 4);
+    compare(parallel, "parallel direct summation");
+    BarnesHutForceComputer<body_type> barnes_hut(1., 0.);
+    compare(barnes_hut, "Barnes-Hut computer");
+    for(SimdInstructionSet instruction_set: {SimdInstructionSet::scalar, SimdInstructionSet::avx2, SimdInstructionSet::avx512}){
+        if(isSupported(instruction_set)){
+            SimdDirectSumForceComputer<body_type> simd(1., instruction_set);
+            compare(simd, to_string(instruction_set) + " kernel");
+        }
+    }
+    std::cout << "Checked the force computers with " << name << "." << std::endl;
+}
+
+
+int main(){
+    for(double length: {1e-3, 0.05}){
+        check_kernel(SofteningKernel<double>::plummer(length));
+        check_kernel(SofteningKernel<double>::spline(length));
+    }
+    check_force_computers(SofteningKernel<double>::plummer(0.05));
+    check_force_computers(SofteningKernel<double>::spline(0.05));
+}
@@ -0,0 +1,77 @@
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/barnes_hut_force_computer.h"
+#include "../include/direct_sum_force_computer.h"
+#include "../include/parallel_direct_sum_force_computer.h"
+#include "../include/particle_mesh_force_computer.h"
+#include "../include/simd_direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+
+// The accelerations of a subset of the bodies should be those of a full computation, and the
+// accelerations of the other bodies should be left untouched.
+void check_subset(ForceComputerBase<body_type>& force_computer, const std::string& name){
+    constexpr std::size_t num_bodies = 1000;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vector_type(), uniform(random_device));
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    std::vector<vector_type> full;
+    star_system.computeAccelerations(force_computer, full);
+
+    std::vector<std::size_t> active_bodies;
+    for(std::size_t b{3}; b < num_bodies; b += 7){
+        active_bodies.push_back(b);
+    }
+    const vector_type untouched(-1., -1., -1.);
+    std::vector<vector_type> subset(num_bodies, untouched);
+    star_system.computeAccelerations(force_computer, active_bodies, subset);
+
+    std::size_t next_active{0};
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        if(next_active < active_bodies.size() && active_bodies[next_active] == b){
+            ++next_active;
+            if(abs(subset[b] - full[b]) > 1e-12 * abs(full[b])){
+                throw std::runtime_error("Acceleration of an active body computed by the " + name + " differs from the full computation.\n");
+            }
+            if(abs(force_computer.totalForce(b) - star_system.mass(b) * full[b]) > 1e-12 * abs(force_computer.totalForce(b))){
+                throw std::runtime_error("Force on an active body computed by the " + name + " differs from the full computation.\n");
+            }
+        } else if(abs(subset[b] - untouched) != 0){
+            throw std::runtime_error("The " + name + " changed the acceleration of an inactive body.\n");
+        }
+    }
+    std::cout << "Checked the subset computation of the " << name << "." << std::endl;
+}
+
+
+int main(){
+    DirectSumForceComputer<body_type> direct_sum(1.);
+    check_subset(direct_sum, "direct summation");
+    ParallelDirectSumForceComputer<body_type> parallel(1., 4);
+    check_subset(parallel, "parallel direct summation");
+    SimdDirectSumForceComputer<body_type> simd(1.);
+    check_subset(simd, "vectorized direct summation");
+
+    // With an opening angle of 0 the tree walk is exact.
+    BarnesHutForceComputer<body_type> barnes_hut(1., 0.);
+    check_subset(barnes_hut, "Barnes-Hut computer");
+
+    // The grid stays in place between the full and the subset computation.
+    ParticleMeshForceComputer<body_type> particle_mesh(1., 32);
+    check_subset(particle_mesh, "particle-mesh computer");
+}
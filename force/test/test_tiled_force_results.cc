@@ -0,0 +1,48 @@
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+int main(){
+    using numeric_type = double;
+    using vector_type = Vector3D<numeric_type>;
+    using body_type = Body<vector_type>;
+
+    constexpr std::size_t num_bodies = 1000;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        numeric_type mass = uniform(random_device);
+        bodies[i] = body_type(pos, vel, mass);
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    // A single tile covering all bodies is the untiled traversal.
+    DirectSumForceComputer<body_type> untiled(1., num_bodies);
+    star_system.computeForcesAndPotential(untiled);
+
+    std::cout << "Automatic tile size: " << DirectSumForceComputer<body_type>::automaticTileSize() << " bodies." << std::endl;
+    for(std::size_t tile_size: {std::size_t{1}, std::size_t{7}, std::size_t{64}, std::size_t{999}, std::size_t{0}}){
+        DirectSumForceComputer<body_type> tiled(1., tile_size);
+        star_system.computeForcesAndPotential(tiled);
+        for(std::size_t b{0}; b < num_bodies; ++b){
+            if(abs(tiled.totalForce(b) - untiled.totalForce(b)) > 1e-12 * abs(untiled.totalForce(b))){
+                std::string error_message = "Force computation with tile size " + std::to_string(tiled.tileSize()) + " differs from the untiled result.\n";
+                throw std::runtime_error(error_message);
+            }
+        }
+        if(std::abs(tiled.potentialEnergy() - untiled.potentialEnergy()) > 1e-12 * std::abs(untiled.potentialEnergy())){
+            std::string error_message = "Potential energy with tile size " + std::to_string(tiled.tileSize()) + " differs from the untiled result.\n";
+            throw std::runtime_error(error_message);
+        }
+    }
+    std::cout << "Test run successfully." << std::endl;
+}
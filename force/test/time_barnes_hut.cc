@@ -0,0 +1,52 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+
+#include "../include/barnes_hut_force_computer.h"
+#include "../include/direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+
+template<typename ForceComputerType, typename BodyType> double time_force_computation(ForceComputerType& force_computer, const StarSystem<BodyType>& star_system){
+    auto t1 = std::chrono::high_resolution_clock::now();
+    star_system.computeForces(force_computer);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> time = t2 - t1;
+    return time.count();
+}
+
+
+int main(){
+    using numeric_type = double;
+    using vector_type = Vector3D<numeric_type>;
+    using body_type = Body<vector_type>;
+
+    // The direct summation scales as N^2, so it is only timed for the smaller star systems.
+    constexpr std::size_t max_direct_sum_bodies = 2e4;
+    constexpr numeric_type opening_angle = 0.5;
+
+    for(std::size_t num_bodies: {1000, 10000, 100000, 1000000}){
+        std::mt19937 random_device{0};
+        std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+        std::vector<body_type> bodies(num_bodies);
+        for(std::size_t i = 0; i < num_bodies; ++i){
+            vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+            vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+            numeric_type mass = uniform(random_device);
+            bodies[i] = body_type(pos, vel, mass);
+        }
+        StarSystem<body_type> star_system(bodies);
+
+        BarnesHutForceComputer<body_type> barnes_hut(1., opening_angle);
+        double time = time_force_computation(barnes_hut, star_system);
+        std::cout << "Elapsed time = " << time << " ms | for " << num_bodies << " bodies using Barnes-Hut with opening angle " << opening_angle << "." << std::endl;
+
+        if(num_bodies <= max_direct_sum_bodies){
+            DirectSumForceComputer<body_type> direct_sum(1.);
+            time = time_force_computation(direct_sum, star_system);
+            std::cout << "Elapsed time = " << time << " ms | for " << num_bodies << " bodies using direct summation." << std::endl;
+        }
+    }
+}
@@ -0,0 +1,54 @@
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "../include/barnes_hut_force_computer.h"
+#include "../include/fast_multipole_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+
+template<typename ForceComputerType, typename BodyType> double time_force_computation(ForceComputerType& force_computer, const StarSystem<BodyType>& star_system){
+    auto t1 = std::chrono::high_resolution_clock::now();
+    star_system.computeForces(force_computer);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> time = t2 - t1;
+    return time.count();
+}
+
+
+// Usage: time_fast_multipole [max_num_bodies]
+// The number of bodies grows tenfold from 10^4 up to max_num_bodies, 10^6 by default.
+int main(int argc, char** argv){
+    using numeric_type = double;
+    using vector_type = Vector3D<numeric_type>;
+    using body_type = Body<vector_type>;
+
+    const std::size_t max_num_bodies = (argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000);
+    constexpr numeric_type opening_angle = 0.5;
+
+    for(std::size_t num_bodies{10000}; num_bodies <= max_num_bodies; num_bodies *= 10){
+        std::mt19937 random_device{0};
+        std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+        std::vector<body_type> bodies(num_bodies);
+        for(std::size_t i = 0; i < num_bodies; ++i){
+            vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+            vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+            numeric_type mass = uniform(random_device);
+            bodies[i] = body_type(pos, vel, mass);
+        }
+        StarSystem<body_type> star_system(bodies);
+
+        for(unsigned order: {2, 4, 6}){
+            FastMultipoleForceComputer<body_type> fast_multipole(1., order, opening_angle);
+            double time = time_force_computation(fast_multipole, star_system);
+            std::cout << "Elapsed time = " << time << " ms | for " << num_bodies << " bodies using the fast multipole method of order " << order << "." << std::endl;
+        }
+
+        BarnesHutForceComputer<body_type> barnes_hut(1., opening_angle);
+        double time = time_force_computation(barnes_hut, star_system);
+        std::cout << "Elapsed time = " << time << " ms | for " << num_bodies << " bodies using Barnes-Hut with opening angle " << opening_angle << "." << std::endl;
+    }
+}
@@ -1,13 +1,71 @@
+#include <array>
 #include <chrono>
 #include <iostream>
 #include <random>
+#include <string>
 
 #include "../include/direct_sum_force_computer.h"
+#include "../include/simd_pairwise_kernel.h"
 #include "../../body/include/body.h"
-//#include "../../vector/include/vector3D_array.h"
+#include "../../body/include/star_system.h"
 #include "../../vector/include/vector3D.h"
 
-int main(){
+
+// Time the pull of all bodies in a star system on every body with the vectorized kernel, and report
+// the number of pair interactions per second.
+template<typename T> void time_kernel(const SimdInstructionSet instruction_set){
+    using vector_type = Vector3D<T>;
+    using body_type = Body<vector_type>;
+
+    constexpr std::size_t num_bodies = 1e4;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<T> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vel, uniform(random_device));
+    }
+    StarSystem<body_type> star_system(bodies);
+    const T* positions[3] = {star_system.positions().data(0), star_system.positions().data(1), star_system.positions().data(2)};
+
+    SimdPairwiseKernel<T, 3> kernel(instruction_set);
+    std::array<T, 3> total{};
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for(std::size_t i{0}; i < num_bodies; ++i){
+        T target[3] = {positions[0][i], positions[1][i], positions[2][i]};
+        kernel.field(positions, star_system.masses().data(), 0, num_bodies, target, total.data());
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    // Print the sum so the computation can not be optimized away.
+    std::chrono::duration<double> time = t2 - t1;
+    double interactions = static_cast<double>(num_bodies) * num_bodies;
+    std::cout << to_string(instruction_set) << " kernel with " << sizeof(T) << "-byte numbers: " << interactions / time.count() << " pair interactions per second (checksum " << total[0] << ")." << std::endl;
+}
+
+
+void time_kernels(){
+    for(SimdInstructionSet instruction_set: {SimdInstructionSet::scalar, SimdInstructionSet::avx2, SimdInstructionSet::avx512}){
+        if(!isSupported(instruction_set)){
+            std::cout << to_string(instruction_set) << " is not supported on this CPU." << std::endl;
+            continue;
+        }
+        time_kernel<float>(instruction_set);
+        time_kernel<double>(instruction_set);
+    }
+}
+
+
+// Usage: time_force_computation [kernel]
+// Without arguments the pairwise force functions are timed, with "kernel" the scalar and vectorized
+// kernels are compared.
+int main(int argc, char* argv[]){
+    if(argc > 1 && std::string(argv[1]) == "kernel"){
+        time_kernels();
+        return 0;
+    }
+
     using numeric_type = double;
     using vector_type = Vector3D<numeric_type>;
     using body_type = Body<vector_type>;
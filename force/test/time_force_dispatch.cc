@@ -0,0 +1,105 @@
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "../include/direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+
+// Direct summation that selects the per-pair work through a pointer to a member function, the way
+// DirectSumForceComputer used to. It serves as the baseline for the compile-time policies.
+template<typename BodyType> class MemberPointerDirectSumForceComputer: public ForceComputerBase<BodyType>{
+
+    public:
+        using ForceComputerBase<BodyType>::ForceComputerBase;
+
+    protected:
+        virtual void computeForcesImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms(star_system, &MemberPointerDirectSumForceComputer<BodyType>::addForceComponent);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<BodyType>& star_system) override{
+            computeAllTerms(star_system, &MemberPointerDirectSumForceComputer<BodyType>::addForceAndPotentialComponent);
+        }
+
+    private:
+        using vector_type = typename ForceComputerBase<BodyType>::vector_type;
+        using ForceComputerBase<BodyType>::_forces;
+        using ForceComputerBase<BodyType>::_potential;
+
+        void addForceComponent(const StarSystem<BodyType>& star_system, const std::size_t lhs_index, const std::size_t rhs_index){
+            vector_type pairwise_force{this->pairwiseForce(
+                star_system.position(lhs_index), star_system.mass(lhs_index),
+                star_system.position(rhs_index), star_system.mass(rhs_index)
+            )};
+            _forces[lhs_index] += pairwise_force;
+            _forces[rhs_index] -= pairwise_force;
+        }
+
+        void addForceAndPotentialComponent(const StarSystem<BodyType>& star_system, const std::size_t lhs_index, const std::size_t rhs_index){
+            auto force_and_potential = this->pairwiseForceAndPotential(
+                star_system.position(lhs_index), star_system.mass(lhs_index),
+                star_system.position(rhs_index), star_system.mass(rhs_index)
+            );
+            _forces[lhs_index] += force_and_potential.first;
+            _forces[rhs_index] -= force_and_potential.first;
+            _potential += force_and_potential.second;
+        }
+
+        void computeAllTerms(
+            const StarSystem<BodyType>& star_system,
+            void (MemberPointerDirectSumForceComputer<BodyType>::*addComponent)(const StarSystem<BodyType>&, const std::size_t, const std::size_t))
+        {
+            for(std::size_t i{0U}; i + 1 < star_system.size(); ++i){
+                for(std::size_t j{i+1}; j < star_system.size(); ++j){
+                    (this->*addComponent)(star_system, i, j);
+                }
+            }
+        }
+};
+
+
+template<typename BodyType> void time_force_computer(ForceComputerBase<BodyType>& force_computer, const StarSystem<BodyType>& star_system, const std::string& name){
+    auto t1 = std::chrono::high_resolution_clock::now();
+    star_system.computeForces(force_computer);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    std::chrono::duration<double, std::milli> time = t2 - t1;
+    std::cout << "Elapsed time = " << time.count() << " ms | for the forces between " << star_system.size() << " bodies using " << name << "." << std::endl;
+
+    t1 = std::chrono::high_resolution_clock::now();
+    star_system.computeForcesAndPotential(force_computer);
+    t2 = std::chrono::high_resolution_clock::now();
+    time = t2 - t1;
+    std::cout << "Elapsed time = " << time.count() << " ms | for the forces and potential energy between " << star_system.size() << " bodies using " << name << "." << std::endl;
+}
+
+
+int main(){
+    using numeric_type = double;
+    using vector_type = Vector3D<numeric_type>;
+    using body_type = Body<vector_type>;
+
+    constexpr std::size_t num_bodies = 1e4;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        numeric_type mass = uniform(random_device);
+        bodies[i] = body_type(pos, vel, mass);
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    // The untiled policy version only differs from the baseline in how the per-pair work is
+    // dispatched.
+    MemberPointerDirectSumForceComputer<body_type> member_pointer(1.);
+    DirectSumForceComputer<body_type> untiled(1., num_bodies);
+    DirectSumForceComputer<body_type> tiled(1.);
+    time_force_computer(member_pointer, star_system, "member function pointer dispatch");
+    time_force_computer(untiled, star_system, "compile-time policies without tiling");
+    time_force_computer(tiled, star_system, "compile-time policies with tiles of " + std::to_string(tiled.tileSize()) + " bodies");
+}
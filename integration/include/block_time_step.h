@@ -0,0 +1,185 @@
+// Leapfrog integrator with individual, hierarchical time steps.
+// Every body gets its own time step, chosen from the power-of-two fractions time_step/2^k of the
+// time step passed to timeStep. Bodies with the same k form a time bin, and the bins are nested
+// so that the steps of all bodies end together at the end of timeStep. Each body is advanced with
+// kick-drift-kick steps of its own length; between its kicks it drifts along with all other
+// bodies, but only the bodies whose step ends get new forces. In clustered systems most bodies
+// sit in the coarse bins, so a few bodies in close encounters no longer force every body onto
+// their tiny steps.
+//
+// The time step of a body follows from its acceleration a as in GADGET:
+//     dt = sqrt(2 accuracy length / |a|)
+// where length is a typical length scale, by default the softening length of the force computer.
+#ifndef BlockTimeStep_H
+#define BlockTimeStep_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "integrator_base.h"
+
+template<typename BodyType> class BlockTimeStep: public IntegratorBase<BodyType>{
+
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+        using vector_type = typename BodyType::vector_type;
+
+        // A length of zero uses the softening length of the force computer. Bodies that would
+        // need more than max_level halvings of the time step are put in the finest bin.
+        BlockTimeStep(const numeric_type accuracy = 0.025, const numeric_type length = 0., const unsigned max_level = 20):
+            _accuracy(accuracy),
+            _length(length),
+            _max_level(max_level)
+        {
+            if(max_level > 62){
+                throw std::invalid_argument("The maximum time bin level must be at most 62.");
+            }
+        }
+
+        numeric_type accuracy() const{ return _accuracy; }
+        numeric_type length() const{ return _length; }
+        unsigned maxLevel() const{ return _max_level; }
+
+        // Time bin of every body during the last step, body b moved with steps of
+        // time_step/2^level(b).
+        const std::vector<unsigned>& levels() const{ return _levels; }
+
+        // Number of bodies whose forces were computed during the last step.
+        std::size_t numForceComputations() const{ return _num_force_computations; }
+
+        virtual void timeStep(StarSystem<BodyType>& star_system,
+                              ForceComputerBase<BodyType>& force_computer,
+                              const numeric_type time_step) override
+        {
+            const numeric_type length = (_length > 0 ? _length : force_computer.softening().length());
+            if(!(length > 0)){
+                throw std::invalid_argument("Block time steps need a length scale, either given explicitly or as the softening length of the force computer.");
+            }
+
+            // As for the leapfrog integrator, the accelerations at the end of the previous step are
+            // those at the start of this one.
+            _num_force_computations = 0;
+            if(_restored){
+                _star_system = &star_system;
+                _force_computer = &force_computer;
+                _version = star_system.version();
+                _restored = false;
+            }
+            if(&star_system != _star_system || &force_computer != _force_computer || star_system.version() != _version || star_system.size() != _accelerations.size()){
+                star_system.computeAccelerations(force_computer, _accelerations);
+                _star_system = &star_system;
+                _force_computer = &force_computer;
+                _num_force_computations += star_system.size();
+            }
+
+            // Time is counted in integer ticks of the finest bin, so that the ends of the steps of
+            // the different bins can be compared exactly.
+            const std::uint64_t num_ticks = std::uint64_t{1} << _max_level;
+            const numeric_type tick = time_step / static_cast<numeric_type>(num_ticks);
+            _levels.resize(star_system.size());
+            _end_ticks.resize(star_system.size());
+            for(std::size_t b{0}; b < star_system.size(); ++b){
+                _levels[b] = level(time_step, length, _accelerations[b], 0);
+                startStep(star_system, b, 0, tick);
+            }
+
+            std::uint64_t current_tick = 0;
+            while(current_tick < num_ticks){
+                const std::uint64_t next_tick = *std::min_element(_end_ticks.begin(), _end_ticks.end());
+
+                // All bodies drift, but only those at the end of their step are active.
+                const numeric_type drift_time = static_cast<numeric_type>(next_tick - current_tick) * tick;
+                _active_bodies.clear();
+                for(std::size_t b{0}; b < star_system.size(); ++b){
+                    star_system.updatePosition(b, drift_time * star_system.velocity(b));
+                    if(_end_ticks[b] == next_tick){
+                        _active_bodies.push_back(b);
+                    }
+                }
+                current_tick = next_tick;
+
+                star_system.computeAccelerations(force_computer, _active_bodies, _accelerations);
+                _num_force_computations += _active_bodies.size();
+                for(const std::size_t b: _active_bodies){
+                    star_system.updateVelocity(b, (stepLength(b, tick) / 2) * _accelerations[b]);
+                    if(current_tick < num_ticks){
+                        _levels[b] = level(time_step, length, _accelerations[b], current_tick);
+                        startStep(star_system, b, current_tick, tick);
+                    }
+                }
+            }
+            _version = star_system.version();
+        }
+
+        // Discard the accelerations of the previous step, see Leapfrog::reset.
+        void reset(){
+            _star_system = nullptr;
+            _force_computer = nullptr;
+            _restored = false;
+        }
+
+        // The accelerations at the end of the last step, see Leapfrog::saveState. The time bins
+        // follow from them at the start of every step, so they need not be saved.
+        virtual void saveState(CheckpointState& state) const override{
+            state.save("integrator/accelerations", (_star_system != nullptr || _restored) ? _accelerations : std::vector<vector_type>());
+        }
+
+        virtual void loadState(const CheckpointState& state) override{
+            state.load("integrator/accelerations", _accelerations);
+            _star_system = nullptr;
+            _force_computer = nullptr;
+            _restored = !_accelerations.empty();
+        }
+
+    private:
+        numeric_type _accuracy;
+        numeric_type _length;
+        unsigned _max_level;
+
+        std::vector<vector_type> _accelerations;
+        std::vector<unsigned> _levels;
+        std::vector<std::uint64_t> _end_ticks;
+        std::vector<std::size_t> _active_bodies;
+        std::size_t _num_force_computations = 0;
+
+        const StarSystem<BodyType>* _star_system = nullptr;
+        const ForceComputerBase<BodyType>* _force_computer = nullptr;
+        std::uint64_t _version = 0;
+        bool _restored = false;
+
+        // Finest bin whose step is not longer than the step required by the acceleration.
+        // A body can only move to a coarser bin at a tick where a step of that bin starts, so the
+        // bins stay nested.
+        unsigned level(const numeric_type time_step, const numeric_type length, const vector_type& acceleration, const std::uint64_t tick) const{
+            const numeric_type magnitude = abs(acceleration);
+            unsigned bin = 0;
+            if(magnitude > 0){
+                const numeric_type required_step = std::sqrt(2 * _accuracy * length / magnitude);
+                const numeric_type halvings = std::ceil(std::log2(time_step / required_step));
+                bin = static_cast<unsigned>(std::min(std::max(halvings, numeric_type(0)), static_cast<numeric_type>(_max_level)));
+            }
+            while(bin < _max_level && tick % ticksPerStep(bin) != 0){
+                ++bin;
+            }
+            return bin;
+        }
+
+        std::uint64_t ticksPerStep(const unsigned level) const{
+            return std::uint64_t{1} << (_max_level - level);
+        }
+
+        numeric_type stepLength(const std::size_t b, const numeric_type tick) const{
+            return static_cast<numeric_type>(ticksPerStep(_levels[b])) * tick;
+        }
+
+        // Opening half kick of a new step of body b.
+        void startStep(StarSystem<BodyType>& star_system, const std::size_t b, const std::uint64_t current_tick, const numeric_type tick){
+            _end_ticks[b] = current_tick + ticksPerStep(_levels[b]);
+            star_system.updateVelocity(b, (stepLength(b, tick) / 2) * _accelerations[b]);
+        }
+};
+
+#endif
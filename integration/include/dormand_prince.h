@@ -0,0 +1,251 @@
+// Adaptive Dormand-Prince integrator, an embedded Runge-Kutta method of order 5(4).
+// Every step gives a fifth order solution and a fourth order solution for nearly the same cost.
+// Their difference estimates the error of the step. A step with too large an error is rejected
+// and retried with a smaller step, and the step size grows again when the error gets small.
+//
+// timeStep advances the star system by exactly the given time step, using as many internal steps
+// as the tolerance requires. The internal step size is kept between calls, so the caller can pick
+// time_step for the output cadence instead of for the worst moment of the run.
+//
+// The last stage is evaluated at the new state, so its accelerations are the first stage of the
+// next step (first same as last). Every step, accepted or rejected, therefore costs six force
+// computations.
+#ifndef DormandPrince_H
+#define DormandPrince_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "integrator_base.h"
+
+template<typename BodyType> class DormandPrince: public IntegratorBase<BodyType>{
+
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+        using vector_type = typename BodyType::vector_type;
+
+        // The error of a step is accepted if, for every body, the error of the position and of
+        // the velocity is below absolute_tolerance + relative_tolerance * magnitude.
+        DormandPrince(const numeric_type relative_tolerance = 1e-6, const numeric_type absolute_tolerance = 1e-6):
+            _relative_tolerance(relative_tolerance),
+            _absolute_tolerance(absolute_tolerance)
+        {
+            if(!(relative_tolerance > 0) && !(absolute_tolerance > 0)){
+                throw std::invalid_argument("At least one of the tolerances of the Dormand-Prince integrator must be positive.");
+            }
+        }
+
+        numeric_type relativeTolerance() const{ return _relative_tolerance; }
+        numeric_type absoluteTolerance() const{ return _absolute_tolerance; }
+
+        // Number of internal steps since construction.
+        std::size_t numAcceptedSteps() const{ return _num_accepted_steps; }
+        std::size_t numRejectedSteps() const{ return _num_rejected_steps; }
+
+        // Size of the next internal step, or 0 before the first step.
+        numeric_type stepSize() const{ return _step_size; }
+
+        virtual void timeStep(StarSystem<BodyType>& star_system,
+                              ForceComputerBase<BodyType>& force_computer,
+                              const numeric_type time_step) override
+        {
+            // The scratch buffers are only reallocated if the size of the star system changes.
+            if(star_system.size() != _start_positions.size()){
+                _start_positions.resize(star_system.size());
+                _start_velocities.resize(star_system.size());
+                for(std::size_t s{0}; s < num_stages; ++s){
+                    _k_pos[s].resize(star_system.size());
+                    _k_vel[s].resize(star_system.size());
+                }
+                _star_system = nullptr;
+                _restored = false;
+            }
+
+            // The first stage is the last stage of the previous step, unless the star system or the
+            // force computer changed. After resuming from a checkpoint it is the loaded stage.
+            if(_restored){
+                _star_system = &star_system;
+                _force_computer = &force_computer;
+                _version = star_system.version();
+                _restored = false;
+            }
+            if(&star_system != _star_system || &force_computer != _force_computer || star_system.version() != _version){
+                star_system.computeAccelerationsAndPotential(force_computer, _k_vel[0]);
+                _star_system = &star_system;
+                _force_computer = &force_computer;
+            }
+            if(!(_step_size > 0)){
+                _step_size = time_step;
+            }
+
+            numeric_type remaining = time_step;
+            while(remaining > 0){
+                // The last step is shortened to end exactly at time_step, without changing the step
+                // size for the next call.
+                const bool last_step = (_step_size >= remaining);
+                const numeric_type step = (last_step ? remaining : _step_size);
+                const numeric_type error = attemptStep(star_system, force_computer, step);
+
+                const numeric_type factor = (error > 0 ? safety * std::pow(error, numeric_type(-0.2)) : max_factor);
+                if(error <= 1){
+                    ++_num_accepted_steps;
+                    remaining = (last_step ? 0 : remaining - step);
+                    std::swap(_k_vel[0], _k_vel[num_stages - 1]);
+                    if(!last_step || factor < 1){
+                        _step_size = step * std::min(max_factor, std::max(min_factor, factor));
+                    }
+                } else {
+                    ++_num_rejected_steps;
+                    restoreStart(star_system);
+                    _step_size = step * std::max(min_factor, std::min(numeric_type(1), factor));
+                    if(_step_size <= std::numeric_limits<numeric_type>::epsilon() * time_step){
+                        throw std::runtime_error("The step size of the Dormand-Prince integrator became too small to reach the tolerance.");
+                    }
+                }
+            }
+            _version = star_system.version();
+        }
+
+        // The last stage of an accepted step is at its end.
+        virtual bool potentialAtEndOfStep() const override{ return true; }
+
+        // Discard the accelerations of the last stage, see Leapfrog::reset.
+        void reset(){
+            _star_system = nullptr;
+            _force_computer = nullptr;
+            _restored = false;
+        }
+
+        // The step size and the last stage of the previous step. The other stages are
+        // recomputed by every step.
+        virtual void saveState(CheckpointState& state) const override{
+            state.save("integrator/step_size", _step_size);
+            state.save("integrator/num_accepted_steps", _num_accepted_steps);
+            state.save("integrator/num_rejected_steps", _num_rejected_steps);
+            state.save("integrator/accelerations", (_star_system != nullptr || _restored) ? _k_vel[0] : std::vector<vector_type>());
+        }
+
+        virtual void loadState(const CheckpointState& state) override{
+            state.load("integrator/step_size", _step_size);
+            state.load("integrator/num_accepted_steps", _num_accepted_steps);
+            state.load("integrator/num_rejected_steps", _num_rejected_steps);
+            state.load("integrator/accelerations", _k_vel[0]);
+
+            // The scratch buffers are sized here, as timeStep discards the loaded stage if their
+            // size does not match the star system.
+            const std::size_t num_bodies = _k_vel[0].size();
+            _start_positions.resize(num_bodies);
+            _start_velocities.resize(num_bodies);
+            for(std::size_t s{0}; s < num_stages; ++s){
+                _k_pos[s].resize(num_bodies);
+                _k_vel[s].resize(num_bodies);
+            }
+            _star_system = nullptr;
+            _force_computer = nullptr;
+            _restored = (num_bodies != 0);
+        }
+
+    private:
+        static constexpr std::size_t num_stages = 7;
+
+        // Limits on the change of the step size after a step.
+        static constexpr numeric_type safety = 0.9;
+        static constexpr numeric_type min_factor = 0.2;
+        static constexpr numeric_type max_factor = 5.;
+
+        numeric_type _relative_tolerance;
+        numeric_type _absolute_tolerance;
+        numeric_type _step_size = 0.;
+        std::size_t _num_accepted_steps = 0;
+        std::size_t _num_rejected_steps = 0;
+
+        // State at the start of the step.
+        std::vector<vector_type> _start_positions;
+        std::vector<vector_type> _start_velocities;
+
+        // Derivatives of the positions and velocities at every stage.
+        std::array<std::vector<vector_type>, num_stages> _k_pos;
+        std::array<std::vector<vector_type>, num_stages> _k_vel;
+
+        const StarSystem<BodyType>* _star_system = nullptr;
+        const ForceComputerBase<BodyType>* _force_computer = nullptr;
+        std::uint64_t _version = 0;
+        bool _restored = false;
+
+        // Butcher tableau. The last row equals the weights of the fifth order solution.
+        static constexpr numeric_type a[num_stages][num_stages - 1] = {
+            {},
+            {1. / 5},
+            {3. / 40, 9. / 40},
+            {44. / 45, -56. / 15, 32. / 9},
+            {19372. / 6561, -25360. / 2187, 64448. / 6561, -212. / 729},
+            {9017. / 3168, -355. / 33, 46732. / 5247, 49. / 176, -5103. / 18656},
+            {35. / 384, 0., 500. / 1113, 125. / 192, -2187. / 6784, 11. / 84}
+        };
+
+        // Difference between the weights of the fifth and the fourth order solutions.
+        static constexpr numeric_type e[num_stages] = {
+            71. / 57600, 0., -71. / 16695, 71. / 1920, -17253. / 339200, 22. / 525, -1. / 40
+        };
+
+        // Take a step from the current state and return the error relative to the tolerance.
+        // The star system is left at the fifth order solution.
+        numeric_type attemptStep(StarSystem<BodyType>& star_system, ForceComputerBase<BodyType>& force_computer, const numeric_type step){
+            for(std::size_t b{0}; b < star_system.size(); ++b){
+                _start_positions[b] = star_system.position(b);
+                _start_velocities[b] = star_system.velocity(b);
+                _k_pos[0][b] = _start_velocities[b];
+            }
+
+            for(std::size_t s{1}; s < num_stages; ++s){
+                for(std::size_t b{0}; b < star_system.size(); ++b){
+                    vector_type position_update;
+                    vector_type velocity_update;
+                    for(std::size_t j{0}; j < s; ++j){
+                        position_update += a[s][j] * _k_pos[j][b];
+                        velocity_update += a[s][j] * _k_vel[j][b];
+                    }
+                    const vector_type velocity = _start_velocities[b] + step * velocity_update;
+                    star_system.setPosition(b, _start_positions[b] + step * position_update);
+                    star_system.setVelocity(b, velocity);
+                    _k_pos[s][b] = velocity;
+                }
+
+                // The potential is only needed at the end of the step.
+                if(s == num_stages - 1){
+                    star_system.computeAccelerationsAndPotential(force_computer, _k_vel[s]);
+                } else {
+                    star_system.computeAccelerations(force_computer, _k_vel[s]);
+                }
+            }
+
+            numeric_type error = 0.;
+            for(std::size_t b{0}; b < star_system.size(); ++b){
+                vector_type position_error;
+                vector_type velocity_error;
+                for(std::size_t s{0}; s < num_stages; ++s){
+                    position_error += e[s] * _k_pos[s][b];
+                    velocity_error += e[s] * _k_vel[s][b];
+                }
+                const numeric_type position_scale = _absolute_tolerance + _relative_tolerance * std::max(abs(_start_positions[b]), abs(star_system.position(b)));
+                const numeric_type velocity_scale = _absolute_tolerance + _relative_tolerance * std::max(abs(_start_velocities[b]), abs(star_system.velocity(b)));
+                error = std::max(error, step * abs(position_error) / position_scale);
+                error = std::max(error, step * abs(velocity_error) / velocity_scale);
+            }
+            return error;
+        }
+
+        void restoreStart(StarSystem<BodyType>& star_system) const{
+            for(std::size_t b{0}; b < star_system.size(); ++b){
+                star_system.setPosition(b, _start_positions[b]);
+                star_system.setVelocity(b, _start_velocities[b]);
+            }
+        }
+};
+
+#endif
@@ -1,27 +1,32 @@
 #ifndef ForwardEuler_H
 #define ForwardEuler_H
 
-#include "integrator_base.h"
+#include <vector>
 
-#include <iostream>
+#include "integrator_base.h"
 
-template<typename BodyType> class ForwardEuler: IntegratorBase<BodyType>{
+template<typename BodyType> class ForwardEuler: public IntegratorBase<BodyType>{
 
     public:
         using numeric_type = typename BodyType::numeric_type;
+        using vector_type = typename BodyType::vector_type;
         
         virtual void timeStep(StarSystem<BodyType>& star_system,
                               ForceComputerBase<BodyType>& force_computer,
                               const numeric_type time_step) override
         {
-            // Compute forces and potentials.
-            star_system.computeForcesAndPotential(force_computer);
+            // Compute accelerations and potentials.
+            star_system.computeAccelerationsAndPotential(force_computer, _accelerations);
             for(std::size_t b{0}; b < star_system.size(); ++b){
-                BodyType& body = star_system[b];
-                body.updatePosition(time_step * body.velocity());        
-                body.updateVelocity(time_step * star_system.acceleration(force_computer, b));
+                star_system.updatePosition(b, time_step * star_system.velocity(b));
+                star_system.updateVelocity(b, time_step * _accelerations[b]);
             }
         }
+
+    private:
+
+        // Accelerations of the bodies, filled by the force computer.
+        std::vector<vector_type> _accelerations;
 };
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef IntegratorBase_H
 #define IntegratorBase_H
 
+#include "../../body/include/checkpoint_state.h"
 #include "../../body/include/star_system.h"
 #include "../../force/include/force_computer_base.h"
 
@@ -11,6 +12,17 @@ template <typename BodyType> class IntegratorBase{
 
         // Integrators might be stateful, so this method can not be const for all integrators.
         virtual void timeStep(StarSystem<BodyType>&, ForceComputerBase<BodyType>&, const numeric_type) = 0;
+
+        // Whether the potential energy of the force computer is that of the positions at the end
+        // of a step. Otherwise it is from an earlier stage, or never computed, and the potential
+        // has to be computed again for the energy of the star system after a step.
+        virtual bool potentialAtEndOfStep() const{ return false; }
+
+        // Save the state that is carried from one time step to the next, so that a simulation
+        // resumed from a checkpoint continues exactly as it would have without the interruption.
+        // Integrators that only use scratch buffers within a step have nothing to save.
+        virtual void saveState(CheckpointState&) const{}
+        virtual void loadState(const CheckpointState&){}
 };
 
 
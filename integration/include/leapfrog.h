@@ -0,0 +1,103 @@
+// Kick-drift-kick leapfrog integrator, also known as velocity Verlet.
+// Every step is a half step kick of the velocities, a full step drift of the positions, and a
+// second half step kick with the accelerations at the new positions:
+//     v_half = v + a(x) time_step/2
+//     x_new = x + v_half time_step
+//     v_new = v_half + a(x_new) time_step/2
+// The accelerations at the end of a step are those at the start of the next one, so they are kept
+// and each step costs a single force computation. The integrator is second order and symplectic,
+// so the energy error stays bounded over long runs instead of drifting like for the Runge-Kutta
+// integrators.
+#ifndef Leapfrog_H
+#define Leapfrog_H
+
+#include <cstdint>
+#include <vector>
+
+#include "integrator_base.h"
+
+template<typename BodyType> class Leapfrog: public IntegratorBase<BodyType>{
+
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+        using vector_type = typename BodyType::vector_type;
+
+        virtual void timeStep(StarSystem<BodyType>& star_system,
+                              ForceComputerBase<BodyType>& force_computer,
+                              const numeric_type time_step) override
+        {
+            // Accelerations loaded from a checkpoint belong to the star system and force computer
+            // the simulation is resumed with.
+            if(_restored){
+                _star_system = &star_system;
+                _force_computer = &force_computer;
+                _version = star_system.version();
+                _restored = false;
+            }
+
+            // The accelerations of the previous step can only be reused if they were computed for
+            // the same star system and force computer, and the positions and masses have not been
+            // changed since.
+            if(&star_system != _star_system || &force_computer != _force_computer || star_system.version() != _version || star_system.size() != _accelerations.size()){
+                star_system.computeAccelerations(force_computer, _accelerations);
+                _star_system = &star_system;
+                _force_computer = &force_computer;
+            }
+
+            const numeric_type half_time_step = time_step / 2;
+            for(std::size_t b{0U}; b < star_system.size(); ++b){
+                star_system.updateVelocity(b, half_time_step * _accelerations[b]);
+                star_system.updatePosition(b, time_step * star_system.velocity(b));
+            }
+
+            // The potential energy is computed at the end of the step, where positions and
+            // velocities are synchronized, so that the energy of the star system can be checked
+            // after every step.
+            star_system.computeAccelerationsAndPotential(force_computer, _accelerations);
+            for(std::size_t b{0U}; b < star_system.size(); ++b){
+                star_system.updateVelocity(b, half_time_step * _accelerations[b]);
+            }
+            _version = star_system.version();
+        }
+
+        virtual bool potentialAtEndOfStep() const override{ return true; }
+
+        // Discard the accelerations of the previous step.
+        // Changes to the positions and masses are detected through the version of the star
+        // system, but this is needed when the force computer was modified in between two steps,
+        // e.g. after changing the softening, or when an array of the star system was written
+        // through a reference kept from before the previous step.
+        void reset(){
+            _star_system = nullptr;
+            _force_computer = nullptr;
+            _restored = false;
+        }
+
+        // The accelerations at the current positions, so that the first step after resuming does
+        // not compute them again.
+        virtual void saveState(CheckpointState& state) const override{
+            state.save("integrator/accelerations", (_star_system != nullptr || _restored) ? _accelerations : std::vector<vector_type>());
+        }
+
+        virtual void loadState(const CheckpointState& state) override{
+            state.load("integrator/accelerations", _accelerations);
+            _star_system = nullptr;
+            _force_computer = nullptr;
+            _restored = !_accelerations.empty();
+        }
+
+    private:
+
+        // Accelerations at the current positions of the bodies.
+        std::vector<vector_type> _accelerations;
+
+        // Star system and force computer the accelerations were computed with.
+        const StarSystem<BodyType>* _star_system = nullptr;
+        const ForceComputerBase<BodyType>* _force_computer = nullptr;
+        std::uint64_t _version = 0;
+
+        // Whether the accelerations were loaded from a checkpoint and not used since.
+        bool _restored = false;
+};
+
+#endif
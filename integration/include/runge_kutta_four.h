@@ -25,34 +25,34 @@ template<typename BodyType> class RungeKuttaFour: public IntegratorBase<BodyType
             }
 
             // Start by computing the forces at the initial positions.
-            star_system.computeForcesAndPotential(force_computer);
+            star_system.computeAccelerationsAndPotential(force_computer, _accelerations);
             for(std::size_t b{0U}; b < star_system.size(); ++b){
-                star_system[b].updatePosition(star_system[b].velocity() * time_step / 2.);
-                _k_vel_1[b] = star_system.acceleration(force_computer, b) * time_step;
+                star_system.updatePosition(b, star_system.velocity(b) * time_step / 2.);
+                _k_vel_1[b] = _accelerations[b] * time_step;
             }
 
             // The position updates happen in-place so some algebra is necessary to obtain the
             // equations used below from the normal Runge-Kutta update rules.
-            star_system.computeForces(force_computer);
+            star_system.computeAccelerations(force_computer, _accelerations);
             for(std::size_t b{0U}; b < star_system.size(); ++b){
-                star_system[b].updatePosition(time_step * _k_vel_1[b] / 4.);
-                _k_vel_2[b] = star_system.acceleration(force_computer, b) * time_step;
+                star_system.updatePosition(b, time_step * _k_vel_1[b] / 4.);
+                _k_vel_2[b] = _accelerations[b] * time_step;
             }
-            star_system.computeForces(force_computer);
+            star_system.computeAccelerations(force_computer, _accelerations);
             for(std::size_t b{0U}; b < star_system.size(); ++b){
-                star_system[b].updatePosition(
-                    time_step / 2. * ( star_system[b].velocity() + _k_vel_2[b] - _k_vel_1[b] / 2.)
+                star_system.updatePosition(b,
+                    time_step / 2. * ( star_system.velocity(b) + _k_vel_2[b] - _k_vel_1[b] / 2.)
                 );
-                _k_vel_3[b] = star_system.acceleration(force_computer, b) * time_step;
+                _k_vel_3[b] = _accelerations[b] * time_step;
             }
-            star_system.computeForces(force_computer);
+            star_system.computeAccelerations(force_computer, _accelerations);
             for(std::size_t b{0U}; b < star_system.size(); ++b){
-                star_system[b].updatePosition(
+                star_system.updatePosition(b,
                     time_step / 6. * (_k_vel_1[b] + _k_vel_3[b] - 2. * _k_vel_2[b])
                 );
-                star_system[b].updateVelocity(
+                star_system.updateVelocity(b,
                     1./6. * (_k_vel_1[b] + 2. * _k_vel_2[b] +
-                    2. * _k_vel_3[b] + star_system.acceleration(force_computer, b) * time_step)
+                    2. * _k_vel_3[b] + _accelerations[b] * time_step)
                 );
             }
         }
@@ -63,5 +63,8 @@ template<typename BodyType> class RungeKuttaFour: public IntegratorBase<BodyType
         std::vector<vector_type> _k_vel_1;
         std::vector<vector_type> _k_vel_2;
         std::vector<vector_type> _k_vel_3;
+
+        // Accelerations of the bodies, filled by the force computer.
+        std::vector<vector_type> _accelerations;
 };
 #endif
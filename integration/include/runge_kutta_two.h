@@ -23,12 +23,12 @@ template<typename BodyType> class RungeKuttaTwo: public IntegratorBase<BodyType>
             }
 
             // Start by computing the forces at the initial positions.
-            star_system.computeForcesAndPotential(force_computer);
+            star_system.computeAccelerationsAndPotential(force_computer, _accelerations);
             for(std::size_t b{0U}; b < star_system.size(); ++b){
 
                 // Part of the velocity update depends on the acceleration at the starting point of
                 // the step.
-                _k_vel[b] = star_system.acceleration(force_computer, b) * time_step;
+                _k_vel[b] = _accelerations[b] * time_step;
 
                 // The update to the position is of the form:
                 // x_new = x + (kx1 + kx2)/2
@@ -37,15 +37,15 @@ template<typename BodyType> class RungeKuttaTwo: public IntegratorBase<BodyType>
                 // so: x_new = x + v + kv1/2 
                 // However the update of the velocity depends on the force at x + kx1, so we do
                 // that partial update first and then add kv1/2 in the next step.
-                star_system[b].updatePosition(star_system[b].velocity() * time_step);
+                star_system.updatePosition(b, star_system.velocity(b) * time_step);
             }
 
             // We don't need to compute the potential energy at the intermediate stage of the
             // integrator.
-            star_system.computeForces(force_computer);
+            star_system.computeAccelerations(force_computer, _accelerations);
             for(std::size_t b{0U}; b < star_system.size(); ++b){
-                star_system[b].updatePosition( _k_vel[b] / 2.);
-                star_system[b].updateVelocity( (_k_vel[b] + time_step*star_system.acceleration(force_computer, b))/2.);
+                star_system.updatePosition(b, _k_vel[b] / 2.);
+                star_system.updateVelocity(b, (_k_vel[b] + time_step*_accelerations[b])/2.);
             }
         }
 
@@ -54,5 +54,8 @@ template<typename BodyType> class RungeKuttaTwo: public IntegratorBase<BodyType>
 
         // Intermediate update of the velocities of bodies.
         std::vector<vector_type> _k_vel;
+
+        // Accelerations of the bodies, filled by the force computer.
+        std::vector<vector_type> _accelerations;
 };
 #endif
@@ -0,0 +1,133 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/block_time_step.h"
+#include "../include/leapfrog.h"
+#include "../../force/include/direct_sum_force_computer.h"
+#include "../../force/include/softening_kernel.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+constexpr numeric_type softening_length = 1e-3;
+
+
+// A loose cluster with a tight binary at its center. The binary needs time steps that are orders
+// of magnitude smaller than those of the rest of the cluster.
+StarSystem<body_type> make_cluster_with_binary(){
+    constexpr std::size_t num_bodies = 256;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(-1., 1.);
+    std::vector<body_type> bodies;
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = 0.3 * vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies.push_back(body_type(pos, vel, 1. / num_bodies));
+    }
+
+    // Circular orbit of two equal masses at a distance of 10 softening lengths.
+    constexpr numeric_type binary_mass = 0.05;
+    constexpr numeric_type separation = 10 * softening_length;
+    const numeric_type orbital_velocity = std::sqrt(binary_mass / (2 * separation));
+    bodies.push_back(body_type(vector_type(separation / 2, 0., 0.), vector_type(0., orbital_velocity, 0.), binary_mass));
+    bodies.push_back(body_type(vector_type(-separation / 2, 0., 0.), vector_type(0., -orbital_velocity, 0.), binary_mass));
+    return StarSystem<body_type>(bodies);
+}
+
+
+// Integrate with the given integrator and return the largest relative energy error over the run.
+// after_step is called with the integrator after every step.
+template<typename IntegratorType, typename Callback> numeric_type energy_error(
+    IntegratorType& integrator,
+    const numeric_type time_step,
+    const std::size_t num_steps,
+    Callback after_step)
+{
+    StarSystem<body_type> star_system = make_cluster_with_binary();
+    DirectSumForceComputer<body_type> force_computer(1.);
+    force_computer.setSoftening(SofteningKernel<numeric_type>::plummer(softening_length));
+    DirectSumForceComputer<body_type> energy_computer(1.);
+    energy_computer.setSoftening(force_computer.softening());
+
+    star_system.computeForcesAndPotential(energy_computer);
+    const numeric_type initial_energy = star_system.energy(energy_computer);
+    numeric_type max_error = 0.;
+    for(std::size_t i{0}; i < num_steps; ++i){
+        integrator.timeStep(star_system, force_computer, time_step);
+        after_step(integrator);
+        star_system.computeForcesAndPotential(energy_computer);
+        max_error = std::max(max_error, std::abs(star_system.energy(energy_computer) / initial_energy - 1));
+    }
+    return max_error;
+}
+
+
+// Moving a body in between two steps must not leave the integrator with the accelerations at the
+// old positions, it has to continue exactly like one that was reset.
+void check_moved_body(){
+    StarSystem<body_type> star_system = make_cluster_with_binary();
+    StarSystem<body_type> expected = make_cluster_with_binary();
+    DirectSumForceComputer<body_type> force_computer(1.);
+    force_computer.setSoftening(SofteningKernel<numeric_type>::plummer(softening_length));
+    BlockTimeStep<body_type> integrator(0.025);
+    BlockTimeStep<body_type> reset_integrator(0.025);
+
+    integrator.timeStep(star_system, force_computer, 1. / 64);
+    reset_integrator.timeStep(expected, force_computer, 1. / 64);
+    star_system[0].updatePosition(vector_type(0.1, 0., 0.));
+    expected.setPosition(0, star_system.position(0));
+    reset_integrator.reset();
+    integrator.timeStep(star_system, force_computer, 1. / 64);
+    reset_integrator.timeStep(expected, force_computer, 1. / 64);
+
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        if(abs(star_system.position(b) - expected.position(b)) != 0 || abs(star_system.velocity(b) - expected.velocity(b)) != 0){
+            throw std::runtime_error("Block time steps used stale accelerations after a body was moved.\n");
+        }
+    }
+}
+
+
+int main(){
+    check_moved_body();
+
+
+    constexpr numeric_type end_time = 0.5;
+    constexpr numeric_type time_step = 1. / 16;
+    constexpr std::size_t num_steps = end_time / time_step;
+
+    BlockTimeStep<body_type> block_time_step(0.025);
+    std::size_t block_force_computations = 0;
+    unsigned finest_level = 0;
+    const numeric_type block_error = energy_error(block_time_step, time_step, num_steps, [&](const BlockTimeStep<body_type>& integrator){
+        block_force_computations += integrator.numForceComputations();
+        finest_level = std::max(finest_level, *std::max_element(integrator.levels().begin(), integrator.levels().end()));
+    });
+    std::cout << "Block time steps: " << block_force_computations << " body force computations, finest level " << finest_level << ", relative energy error " << block_error << std::endl;
+
+    // A global leapfrog needs the time step of the finest bin for every body, and computes the
+    // forces on all bodies once per step.
+    const std::size_t num_leapfrog_steps = num_steps << finest_level;
+    Leapfrog<body_type> leapfrog;
+    const numeric_type leapfrog_error = energy_error(leapfrog, end_time / num_leapfrog_steps, num_leapfrog_steps, [](const Leapfrog<body_type>&){});
+    const std::size_t leapfrog_force_computations = (num_leapfrog_steps + 1) * make_cluster_with_binary().size();
+    std::cout << "Leapfrog: " << leapfrog_force_computations << " body force computations, relative energy error " << leapfrog_error << std::endl;
+
+    if(finest_level < 3){
+        throw std::runtime_error("The binary was not put in a finer time bin than the rest of the cluster.\n");
+    }
+    if(block_error > 1e-3){
+        throw std::runtime_error("The energy error with block time steps is too large: " + std::to_string(block_error) + ".\n");
+    }
+    if(4 * block_force_computations > leapfrog_force_computations){
+        throw std::runtime_error("Block time steps did not save force computations compared with a global time step.\n");
+    }
+}
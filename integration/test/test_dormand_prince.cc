@@ -0,0 +1,126 @@
+#include <cmath>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "../include/dormand_prince.h"
+#include "../include/runge_kutta_four.h"
+#include "../../force/include/direct_sum_force_computer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+constexpr numeric_type pi = 3.14159265358979323846;
+
+
+// Two bodies of equal mass on an orbit with eccentricity 0.9 and semi-major axis 1, starting at
+// apocenter. The accelerations at pericenter are 361 times larger than at apocenter, so a fixed
+// time step has to be chosen for the pericenter passage.
+StarSystem<body_type> make_binary(){
+    constexpr numeric_type eccentricity = 0.9;
+    constexpr numeric_type mass = 0.5;
+    const numeric_type separation = 1 + eccentricity;
+    const numeric_type relative_velocity = std::sqrt((1 - eccentricity) / (1 + eccentricity));
+    std::vector<body_type> bodies{
+        body_type(vector_type(separation / 2, 0., 0.), vector_type(0., relative_velocity / 2, 0.), mass),
+        body_type(vector_type(-separation / 2, 0., 0.), vector_type(0., -relative_velocity / 2, 0.), mass)
+    };
+    return StarSystem<body_type>(bodies);
+}
+
+
+// Direct summation that counts how often the forces are computed.
+class CountingForceComputer: public DirectSumForceComputer<body_type>{
+
+    public:
+        CountingForceComputer(): DirectSumForceComputer<body_type>(1.){}
+        std::size_t numEvaluations() const{ return _num_evaluations; }
+
+    protected:
+        virtual void computeForcesImpl(const StarSystem<body_type>& star_system) override{
+            ++_num_evaluations;
+            DirectSumForceComputer<body_type>::computeForcesImpl(star_system);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<body_type>& star_system) override{
+            ++_num_evaluations;
+            DirectSumForceComputer<body_type>::computeForcesAndPotentialImpl(star_system);
+        }
+
+    private:
+        std::size_t _num_evaluations = 0;
+};
+
+
+// Distance from the starting position after one orbit, integrated in num_steps calls to timeStep.
+template<typename IntegratorType> numeric_type orbit_error(IntegratorType& integrator, const std::size_t num_steps, std::size_t& num_evaluations){
+    StarSystem<body_type> star_system = make_binary();
+    const vector_type start = star_system.position(0);
+    CountingForceComputer force_computer;
+    constexpr numeric_type period = 2 * pi;
+    for(std::size_t i{0}; i < num_steps; ++i){
+        integrator.timeStep(star_system, force_computer, period / num_steps);
+    }
+    num_evaluations = force_computer.numEvaluations();
+    return abs(star_system.position(0) - start);
+}
+
+
+// Moving a body in between two steps must not leave the first stage at the old positions, the
+// integrator has to continue exactly like one that was reset.
+void check_moved_body(){
+    constexpr numeric_type time_step = 0.1;
+    StarSystem<body_type> star_system = make_binary();
+    StarSystem<body_type> expected = make_binary();
+    CountingForceComputer force_computer;
+    DormandPrince<body_type> integrator(1e-9, 1e-9);
+    DormandPrince<body_type> reset_integrator(1e-9, 1e-9);
+
+    integrator.timeStep(star_system, force_computer, time_step);
+    reset_integrator.timeStep(expected, force_computer, time_step);
+    star_system[0].updatePosition(vector_type(0.1, 0., 0.));
+    expected.setPosition(0, star_system.position(0));
+    reset_integrator.reset();
+    integrator.timeStep(star_system, force_computer, time_step);
+    reset_integrator.timeStep(expected, force_computer, time_step);
+
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        if(abs(star_system.position(b) - expected.position(b)) != 0 || abs(star_system.velocity(b) - expected.velocity(b)) != 0){
+            throw std::runtime_error("The Dormand-Prince integrator used a stale first stage after a body was moved.\n");
+        }
+    }
+}
+
+
+int main(){
+    check_moved_body();
+
+
+    DormandPrince<body_type> dormand_prince(1e-9, 1e-9);
+    std::size_t adaptive_evaluations;
+    const numeric_type adaptive_error = orbit_error(dormand_prince, 10, adaptive_evaluations);
+    std::cout << "Dormand-Prince: " << dormand_prince.numAcceptedSteps() << " accepted and " << dormand_prince.numRejectedSteps() << " rejected steps, " << adaptive_evaluations << " force computations, position error " << adaptive_error << std::endl;
+
+    // Runge-Kutta 4 with about the same number of force computations.
+    RungeKuttaFour<body_type> runge_kutta;
+    std::size_t fixed_evaluations;
+    const numeric_type fixed_error = orbit_error(runge_kutta, adaptive_evaluations / 4, fixed_evaluations);
+    std::cout << "Runge-Kutta 4: " << fixed_evaluations << " force computations, position error " << fixed_error << std::endl;
+
+    if(adaptive_error > 1e-6){
+        throw std::runtime_error("The Dormand-Prince integrator did not reach the tolerance, the position error is " + std::to_string(adaptive_error) + ".\n");
+    }
+    if(dormand_prince.numRejectedSteps() == 0){
+        throw std::runtime_error("The Dormand-Prince integrator never rejected a step, so the step size control was not exercised.\n");
+    }
+    if(adaptive_evaluations != 6 * (dormand_prince.numAcceptedSteps() + dormand_prince.numRejectedSteps()) + 1){
+        throw std::runtime_error("The Dormand-Prince integrator did not reuse the last stage of its steps.\n");
+    }
+    if(fixed_error < adaptive_error){
+        throw std::runtime_error("The Dormand-Prince integrator is less accurate than Runge-Kutta 4 at the same cost.\n");
+    }
+}
@@ -0,0 +1,140 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+
+#include "../include/leapfrog.h"
+#include "../include/runge_kutta_four.h"
+#include "../../force/include/direct_sum_force_computer.h"
+#include "../../force/include/softening_kernel.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+
+// Direct summation that counts how often the forces are computed.
+class CountingForceComputer: public DirectSumForceComputer<body_type>{
+
+    public:
+        CountingForceComputer(): DirectSumForceComputer<body_type>(1.){
+            setSoftening(SofteningKernel<numeric_type>::plummer(0.05));
+        }
+
+        std::size_t numEvaluations() const{ return _num_evaluations; }
+
+    protected:
+        virtual void computeForcesImpl(const StarSystem<body_type>& star_system) override{
+            ++_num_evaluations;
+            DirectSumForceComputer<body_type>::computeForcesImpl(star_system);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<body_type>& star_system) override{
+            ++_num_evaluations;
+            DirectSumForceComputer<body_type>::computeForcesAndPotentialImpl(star_system);
+        }
+
+    private:
+        std::size_t _num_evaluations = 0;
+};
+
+
+// A cluster of bodies in a unit cube, with random velocities of the order of the virial velocity.
+StarSystem<body_type> make_cluster(){
+    constexpr std::size_t num_bodies = 64;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(-0.5, 0.5);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vel, 1. / num_bodies);
+    }
+    return StarSystem<body_type>(bodies);
+}
+
+
+// Largest relative energy error over the run.
+template<typename IntegratorType> numeric_type energy_error(
+    const numeric_type time_step,
+    const std::size_t num_steps,
+    std::size_t& num_evaluations)
+{
+    StarSystem<body_type> star_system = make_cluster();
+    CountingForceComputer force_computer;
+    CountingForceComputer energy_computer;
+    IntegratorType integrator;
+
+    star_system.computeForcesAndPotential(energy_computer);
+    const numeric_type initial_energy = star_system.energy(energy_computer);
+    numeric_type max_error = 0.;
+    for(std::size_t i{0}; i < num_steps; ++i){
+        integrator.timeStep(star_system, force_computer, time_step);
+        star_system.computeForcesAndPotential(energy_computer);
+        max_error = std::max(max_error, std::abs(star_system.energy(energy_computer) / initial_energy - 1));
+    }
+    num_evaluations = force_computer.numEvaluations();
+    return max_error;
+}
+
+
+bool same(const vector_type& a, const vector_type& b){
+    return a.x() == b.x() && a.y() == b.y() && a.z() == b.z();
+}
+
+
+// Moving a body in between two steps must not leave the leapfrog with the accelerations at the
+// old positions, it has to integrate exactly like a leapfrog that starts afresh.
+void check_moved_body(){
+    constexpr numeric_type time_step = 1e-3;
+    StarSystem<body_type> star_system = make_cluster();
+    StarSystem<body_type> expected = make_cluster();
+    CountingForceComputer force_computer;
+    Leapfrog<body_type> integrator;
+    Leapfrog<body_type> fresh_integrator;
+
+    integrator.timeStep(star_system, force_computer, time_step);
+    fresh_integrator.timeStep(expected, force_computer, time_step);
+    star_system[0].updatePosition(vector_type(0.1, 0., 0.));
+    expected.setPosition(0, star_system.position(0));
+    fresh_integrator.reset();
+    integrator.timeStep(star_system, force_computer, time_step);
+    fresh_integrator.timeStep(expected, force_computer, time_step);
+
+    for(std::size_t b{0}; b < star_system.size(); ++b){
+        if(!same(star_system.position(b), expected.position(b)) || !same(star_system.velocity(b), expected.velocity(b))){
+            throw std::runtime_error("The leapfrog integrator used stale accelerations after a body was moved.\n");
+        }
+    }
+}
+
+
+int main(){
+    check_moved_body();
+
+    constexpr numeric_type end_time = 10.;
+
+    // Each leapfrog step costs one force computation, after the initial one.
+    constexpr std::size_t num_leapfrog_steps = 2000;
+    std::size_t leapfrog_evaluations;
+    const numeric_type leapfrog_error = energy_error<Leapfrog<body_type>>(end_time / num_leapfrog_steps, num_leapfrog_steps, leapfrog_evaluations);
+    std::cout << "Leapfrog: " << leapfrog_evaluations << " force computations, relative energy error " << leapfrog_error << std::endl;
+    if(leapfrog_evaluations != num_leapfrog_steps + 1){
+        throw std::runtime_error("The leapfrog integrator computed the forces " + std::to_string(leapfrog_evaluations) + " times in " + std::to_string(num_leapfrog_steps) + " steps.\n");
+    }
+
+    // Runge-Kutta 4 with the same number of force computations.
+    constexpr std::size_t num_runge_kutta_steps = num_leapfrog_steps / 4;
+    std::size_t runge_kutta_evaluations;
+    const numeric_type runge_kutta_error = energy_error<RungeKuttaFour<body_type>>(end_time / num_runge_kutta_steps, num_runge_kutta_steps, runge_kutta_evaluations);
+    std::cout << "Runge-Kutta 4: " << runge_kutta_evaluations << " force computations, relative energy error " << runge_kutta_error << std::endl;
+
+    if(leapfrog_error > runge_kutta_error){
+        throw std::runtime_error("The leapfrog integrator conserves the energy worse than Runge-Kutta 4 at the same cost.\n");
+    }
+}
@@ -3,6 +3,7 @@
 #include <random>
 
 #include "../include/forward_euler.h"
+#include "../include/leapfrog.h"
 #include "../include/runge_kutta_two.h"
 #include "../include/runge_kutta_four.h"
 #include "../../force/include/direct_sum_force_computer.h"
@@ -54,4 +55,5 @@ int main(){
     time_integrator<ForwardEuler<body_type>, body_type>("forward Euler");
     time_integrator<RungeKuttaTwo<body_type>, body_type>("Runge-Kutta 2");
     time_integrator<RungeKuttaFour<body_type>, body_type>("Runge-Kutta 4");
+    time_integrator<Leapfrog<body_type>, body_type>("leapfrog");
 }
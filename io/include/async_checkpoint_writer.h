@@ -0,0 +1,170 @@
+// Checkpoint writer that writes the files on a background I/O thread.
+// write_checkpoint only copies the state of the simulation into one of a few staging states, which
+// costs about as much as copying the star system, and returns while the I/O thread writes the file.
+// The staging states keep their memory, so checkpointing the same simulation again does not
+// allocate. If the I/O thread falls behind by more checkpoints than there are staging states,
+// write_checkpoint blocks until one is free again.
+#ifndef AsyncCheckpointWriter_H
+#define AsyncCheckpointWriter_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "checkpoint.h"
+#include "../../body/include/checkpoint_state.h"
+#include "../../body/include/star_system.h"
+#include "../../force/include/force_computer_base.h"
+#include "../../integration/include/integrator_base.h"
+#include "../../parallel/include/bounded_queue.h"
+
+
+template<typename BodyType> class AsyncCheckpointWriter{
+    public:
+        explicit AsyncCheckpointWriter(const std::size_t num_staging_states = 1);
+
+        AsyncCheckpointWriter(const AsyncCheckpointWriter&) = delete;
+        AsyncCheckpointWriter(AsyncCheckpointWriter&&) = delete;
+        AsyncCheckpointWriter& operator=(const AsyncCheckpointWriter&) = delete;
+        AsyncCheckpointWriter& operator=(AsyncCheckpointWriter&&) = delete;
+
+        // Writes all checkpoints that are still queued.
+        ~AsyncCheckpointWriter();
+
+        std::size_t num_staging_states() const{ return _staging.size(); }
+
+        // Save the state of the simulation into a staging state and queue it for writing to the
+        // given path. Errors of earlier writes on the I/O thread are rethrown here.
+        void write_checkpoint(
+            const std::string& path,
+            const StarSystem<BodyType>& star_system,
+            const IntegratorBase<BodyType>& integrator,
+            const ForceComputerBase<BodyType>& force_computer,
+            const std::uint64_t step,
+            const double time);
+
+        // Block until all queued checkpoints are written.
+        void flush();
+
+    private:
+        // A staging state waiting to be written, or a request to flush if the path is empty.
+        struct Job{
+            std::size_t staging_state;
+            std::string path;
+        };
+
+        std::vector<CheckpointState> _staging;
+        BoundedQueue<std::size_t> _free_states;
+        BoundedQueue<Job> _jobs;
+
+        std::mutex _mutex;
+        std::condition_variable _flushed;
+        std::size_t _num_flush_requests = 0;
+        std::size_t _num_flushes = 0;
+        std::exception_ptr _error;
+
+        std::thread _io_thread;
+
+        void run();
+        void rethrowError();
+};
+
+
+template<typename BodyType> AsyncCheckpointWriter<BodyType>::AsyncCheckpointWriter(const std::size_t num_staging_states):
+    _staging(num_staging_states),
+    _free_states(num_staging_states == 0 ? 1 : num_staging_states),
+    _jobs((num_staging_states == 0 ? 1 : num_staging_states) + 1)
+{
+    if(num_staging_states == 0){
+        throw std::invalid_argument("The asynchronous checkpoint writer needs at least one staging state.");
+    }
+    for(std::size_t s{0}; s < num_staging_states; ++s){
+        _free_states.push(s);
+    }
+    _io_thread = std::thread(&AsyncCheckpointWriter::run, this);
+}
+
+
+template<typename BodyType> AsyncCheckpointWriter<BodyType>::~AsyncCheckpointWriter(){
+    _jobs.close();
+    _io_thread.join();
+}
+
+
+template<typename BodyType> void AsyncCheckpointWriter<BodyType>::write_checkpoint(
+    const std::string& path,
+    const StarSystem<BodyType>& star_system,
+    const IntegratorBase<BodyType>& integrator,
+    const ForceComputerBase<BodyType>& force_computer,
+    const std::uint64_t step,
+    const double time)
+{
+    rethrowError();
+    if(path.empty()){
+        throw std::invalid_argument("A checkpoint needs a path.");
+    }
+    std::size_t staging_state;
+    if(!_free_states.pop(staging_state)){
+        throw std::logic_error("The staging states of the checkpoint writer were closed.");
+    }
+    save_checkpoint(_staging[staging_state], star_system, integrator, force_computer, step, time);
+    _jobs.push(Job{staging_state, path});
+}
+
+
+template<typename BodyType> void AsyncCheckpointWriter<BodyType>::flush(){
+    std::size_t request;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        request = ++_num_flush_requests;
+    }
+    _jobs.push(Job{0, std::string()});
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _flushed.wait(lock, [this, request]{ return _num_flushes >= request; });
+    lock.unlock();
+    rethrowError();
+}
+
+
+template<typename BodyType> void AsyncCheckpointWriter<BodyType>::run(){
+    Job job;
+    while(_jobs.pop(job)){
+        const bool flush = job.path.empty();
+        if(!flush){
+            try{
+                ::write_checkpoint(job.path, _staging[job.staging_state]);
+            } catch(...){
+                std::lock_guard<std::mutex> lock(_mutex);
+                if(!_error){
+                    _error = std::current_exception();
+                }
+            }
+            _free_states.push(job.staging_state);
+        }
+
+        if(flush){
+            std::lock_guard<std::mutex> lock(_mutex);
+            ++_num_flushes;
+            _flushed.notify_all();
+        }
+    }
+}
+
+
+template<typename BodyType> void AsyncCheckpointWriter<BodyType>::rethrowError(){
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_error){
+        std::exception_ptr error = _error;
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+#endif
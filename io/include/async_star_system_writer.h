@@ -0,0 +1,195 @@
+// Star system writer that writes on a background I/O thread.
+// write_star_system only copies the state of the star system into one of a few staging buffers
+// and returns, while a dedicated thread packs the snapshots and runs HDF5, so that the output
+// overlaps with the next force computations. With the default two staging buffers the simulation
+// fills one while the other is being written. If the I/O thread falls behind by more snapshots
+// than there are staging buffers, write_star_system blocks until a buffer is free again.
+//
+// The HDF5 library is not thread safe, so no other HDF5 calls should be made while the writer
+// exists, except after flush() has returned.
+#ifndef AsyncStarSystemWriter_H
+#define AsyncStarSystemWriter_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "star_system_writer.h"
+#include "../../body/include/star_system.h"
+#include "../../parallel/include/bounded_queue.h"
+
+
+template<typename BodyType> class AsyncStarSystemWriter{
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+
+        AsyncStarSystemWriter(
+            const std::size_t num_bodies,
+            const std::string& output_path,
+            const StarSystemWriterOptions& options = StarSystemWriterOptions(),
+            const std::size_t num_staging_buffers = 2);
+
+        AsyncStarSystemWriter(const AsyncStarSystemWriter&) = delete;
+        AsyncStarSystemWriter(AsyncStarSystemWriter&&) = delete;
+        AsyncStarSystemWriter& operator=(const AsyncStarSystemWriter&) = delete;
+        AsyncStarSystemWriter& operator=(AsyncStarSystemWriter&&) = delete;
+
+        // Writes all snapshots that are still queued before the file is closed.
+        ~AsyncStarSystemWriter();
+
+        std::size_t num_staging_buffers() const{ return _staging.size(); }
+
+        // Copy the star system into a staging buffer and queue it for writing.
+        // Errors of earlier writes on the I/O thread are rethrown here.
+        void write_star_system(const StarSystem<BodyType>&, const numeric_type);
+
+        // Block until all queued snapshots are written to the file, including those buffered by
+        // the underlying writer, and return the HDF5 status of the last write.
+        herr_t flush();
+
+    private:
+        // A snapshot in a staging buffer that is waiting to be written, or a request to flush.
+        struct Job{
+            std::size_t buffer;
+            numeric_type timestamp;
+            bool flush;
+        };
+
+        // The staging buffers come before the writer, so that their number is checked before the
+        // file is created.
+        std::size_t _num_bodies;
+        std::vector<StarSystem<BodyType>> _staging;
+        StarSystemWriter<BodyType> _writer;
+
+        // Staging buffers that can be filled, and jobs for the I/O thread. The free buffers
+        // provide the backpressure.
+        BoundedQueue<std::size_t> _free_buffers;
+        BoundedQueue<Job> _jobs;
+
+        // Completed flushes, the status of the last write and the first error on the I/O thread.
+        std::mutex _mutex;
+        std::condition_variable _flushed;
+        std::size_t _num_flush_requests = 0;
+        std::size_t _num_flushes = 0;
+        herr_t _status = 0;
+        std::exception_ptr _error;
+
+        std::thread _io_thread;
+
+        static std::size_t checked_num_staging_buffers(const std::size_t num_staging_buffers);
+
+        void run();
+        void rethrowError();
+};
+
+
+template<typename BodyType> AsyncStarSystemWriter<BodyType>::AsyncStarSystemWriter(
+    const std::size_t num_bodies,
+    const std::string& output_path,
+    const StarSystemWriterOptions& options,
+    const std::size_t num_staging_buffers
+):
+    _num_bodies(num_bodies),
+    _staging(checked_num_staging_buffers(num_staging_buffers), StarSystem<BodyType>(std::vector<BodyType>())),
+    _writer(num_bodies, output_path, options),
+    _free_buffers(num_staging_buffers),
+    _jobs(num_staging_buffers + 1)
+{
+    for(std::size_t b{0}; b < num_staging_buffers; ++b){
+        _free_buffers.push(b);
+    }
+    _io_thread = std::thread(&AsyncStarSystemWriter::run, this);
+}
+
+
+template<typename BodyType> AsyncStarSystemWriter<BodyType>::~AsyncStarSystemWriter(){
+    _jobs.close();
+    _io_thread.join();
+}
+
+
+template<typename BodyType> void AsyncStarSystemWriter<BodyType>::write_star_system(const StarSystem<BodyType>& star_system, const numeric_type timestamp){
+    rethrowError();
+    if(star_system.size() != _num_bodies){
+        throw std::length_error("The star system has " + std::to_string(star_system.size()) + " bodies, but the writer was made for " + std::to_string(_num_bodies) + " bodies.");
+    }
+
+    // Copy assignment reuses the memory of the staging buffer.
+    std::size_t buffer;
+    if(!_free_buffers.pop(buffer)){
+        throw std::logic_error("The staging buffers of the writer were closed.");
+    }
+    _staging[buffer] = star_system;
+    _jobs.push(Job{buffer, timestamp, false});
+}
+
+
+template<typename BodyType> herr_t AsyncStarSystemWriter<BodyType>::flush(){
+    std::size_t request;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        request = ++_num_flush_requests;
+    }
+    _jobs.push(Job{0, numeric_type(0), true});
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    _flushed.wait(lock, [this, request]{ return _num_flushes >= request; });
+    lock.unlock();
+    rethrowError();
+    return _status;
+}
+
+
+template<typename BodyType> std::size_t AsyncStarSystemWriter<BodyType>::checked_num_staging_buffers(const std::size_t num_staging_buffers){
+    if(num_staging_buffers == 0){
+        throw std::invalid_argument("The asynchronous writer needs at least one staging buffer.");
+    }
+    return num_staging_buffers;
+}
+
+
+template<typename BodyType> void AsyncStarSystemWriter<BodyType>::run(){
+    Job job;
+    while(_jobs.pop(job)){
+        herr_t status = 0;
+        try{
+            if(job.flush){
+                status = _writer.flush();
+            } else {
+                status = _writer.write_star_system(_staging[job.buffer], job.timestamp);
+            }
+        } catch(...){
+            std::lock_guard<std::mutex> lock(_mutex);
+            if(!_error){
+                _error = std::current_exception();
+            }
+        }
+        if(!job.flush){
+            _free_buffers.push(job.buffer);
+        }
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        _status = status;
+        if(job.flush){
+            ++_num_flushes;
+            _flushed.notify_all();
+        }
+    }
+}
+
+
+template<typename BodyType> void AsyncStarSystemWriter<BodyType>::rethrowError(){
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(_error){
+        std::exception_ptr error = _error;
+        _error = nullptr;
+        std::rethrow_exception(error);
+    }
+}
+
+#endif
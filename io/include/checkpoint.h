@@ -0,0 +1,192 @@
+// Checkpoints of a whole simulation, from which it can be resumed bit for bit.
+// Besides the positions, velocities and masses of the bodies, a checkpoint holds the state the
+// integrator carries between time steps, such as the accelerations at the current positions or
+// the size of the next adaptive step, the forces and potential of the last force computation, and
+// the step counter and time of the simulation. A simulation is checkpointed by saving everything
+// into a CheckpointState and writing it to a file:
+//
+//     CheckpointState state;
+//     save_checkpoint(state, star_system, integrator, force_computer, step, time);
+//     write_checkpoint(path, state);
+//
+// and resumed by reading the file and loading the state into a star system, integrator and force
+// computer of the same types. AsyncCheckpointWriter writes the file on a background thread.
+//
+// Like raw snapshots, checkpoint files hold the values as they are in memory, so they can only be
+// read by a build with the same numeric types on a machine with the same byte order.
+#ifndef Checkpoint_H
+#define Checkpoint_H
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../../body/include/checkpoint_state.h"
+#include "../../body/include/star_system.h"
+#include "../../force/include/force_computer_base.h"
+#include "../../integration/include/integrator_base.h"
+#include "../../vector/include/vector_traits.h"
+
+constexpr char CHECKPOINT_MAGIC[8] = {'N', 'B', 'O', 'D', 'Y', 'C', 'K', 'P'};
+constexpr std::uint32_t CHECKPOINT_VERSION = 1;
+constexpr std::uint32_t CHECKPOINT_BYTE_ORDER = 0x01020304;
+
+
+struct CheckpointHeader{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t byte_order;
+    std::uint64_t num_records;
+};
+
+// Every record in the file is this header followed by its name and its bytes.
+struct CheckpointRecordHeader{
+    std::uint64_t name_size;
+    std::uint64_t element_size;
+    std::uint64_t num_bytes;
+};
+
+
+// Save the bodies of a star system into a checkpoint, one array per component.
+template<typename BodyType> void save_star_system(CheckpointState& state, const StarSystem<BodyType>& star_system){
+    constexpr std::uint32_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+    state.save("star_system/dimension", dimension);
+    for(std::size_t d{0}; d < dimension; ++d){
+        state.save("star_system/positions/" + std::to_string(d), star_system.positions().data(d), star_system.size());
+        state.save("star_system/velocities/" + std::to_string(d), star_system.velocities().data(d), star_system.size());
+    }
+    state.save("star_system/masses", star_system.masses().data(), star_system.size());
+}
+
+
+// Load the bodies of a checkpoint into a star system, which is resized to their number.
+template<typename BodyType> void load_star_system(const CheckpointState& state, StarSystem<BodyType>& star_system){
+    constexpr std::uint32_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+    std::uint32_t saved_dimension;
+    state.load("star_system/dimension", saved_dimension);
+    if(saved_dimension != dimension){
+        throw std::invalid_argument("The checkpoint holds " + std::to_string(saved_dimension) + "D bodies, but the star system has " + std::to_string(dimension) + "D bodies.");
+    }
+    star_system.resize(state.size("star_system/masses"));
+    for(std::size_t d{0}; d < dimension; ++d){
+        state.load("star_system/positions/" + std::to_string(d), star_system.positions().data(d), star_system.size());
+        state.load("star_system/velocities/" + std::to_string(d), star_system.velocities().data(d), star_system.size());
+    }
+    state.load("star_system/masses", star_system.masses().data(), star_system.size());
+}
+
+
+// Save the state of a whole simulation after the given number of time steps.
+template<typename BodyType> void save_checkpoint(
+    CheckpointState& state,
+    const StarSystem<BodyType>& star_system,
+    const IntegratorBase<BodyType>& integrator,
+    const ForceComputerBase<BodyType>& force_computer,
+    const std::uint64_t step,
+    const double time)
+{
+    state.save("simulation/step", step);
+    state.save("simulation/time", time);
+    save_star_system(state, star_system);
+    integrator.saveState(state);
+    force_computer.saveState(state);
+}
+
+
+// Load the state of a whole simulation and return the step counter and time through the last two
+// arguments. The integrator and force computer should be of the types that saved the state.
+template<typename BodyType> void load_checkpoint(
+    const CheckpointState& state,
+    StarSystem<BodyType>& star_system,
+    IntegratorBase<BodyType>& integrator,
+    ForceComputerBase<BodyType>& force_computer,
+    std::uint64_t& step,
+    double& time)
+{
+    state.load("simulation/step", step);
+    state.load("simulation/time", time);
+    load_star_system(state, star_system);
+    integrator.loadState(state);
+    force_computer.loadState(state);
+}
+
+
+// Write a checkpoint to a file. The file is written under a temporary name and then renamed, so
+// that a crash while writing never leaves a partial checkpoint in place of the previous one.
+inline void write_checkpoint(const std::string& path, const CheckpointState& state){
+    const std::string temporary_path = path + ".tmp";
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if(!file){
+        throw std::runtime_error("Could not open " + temporary_path + " for writing.");
+    }
+
+    CheckpointHeader header{};
+    std::memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.byte_order = CHECKPOINT_BYTE_ORDER;
+    header.num_records = state.records().size();
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for(const auto& named_record: state.records()){
+        const CheckpointRecordHeader record_header{named_record.first.size(), named_record.second.element_size, named_record.second.bytes.size()};
+        file.write(reinterpret_cast<const char*>(&record_header), sizeof(record_header));
+        file.write(named_record.first.data(), named_record.first.size());
+        file.write(named_record.second.bytes.data(), named_record.second.bytes.size());
+    }
+
+    file.close();
+    if(!file){
+        throw std::runtime_error("Could not write the checkpoint to " + temporary_path + ".");
+    }
+    if(std::rename(temporary_path.c_str(), path.c_str()) != 0){
+        throw std::runtime_error("Could not rename " + temporary_path + " to " + path + ".");
+    }
+}
+
+
+// Read a checkpoint file into a state, replacing its records.
+inline void read_checkpoint(const std::string& path, CheckpointState& state){
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file){
+        throw std::runtime_error("Could not open " + path + " for reading.");
+    }
+    const std::uint64_t file_size = static_cast<std::uint64_t>(file.tellg());
+    file.seekg(0);
+    CheckpointHeader header;
+    if(!file.read(reinterpret_cast<char*>(&header), sizeof(header))){
+        throw std::length_error(path + " is too short to be a checkpoint.");
+    }
+    if(std::memcmp(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic)) != 0 || header.version != CHECKPOINT_VERSION){
+        throw std::invalid_argument(path + " is not a checkpoint of this version.");
+    }
+    if(header.byte_order != CHECKPOINT_BYTE_ORDER){
+        throw std::invalid_argument(path + " was written on a machine with a different byte order.");
+    }
+
+    state.clear();
+    std::string name;
+    std::vector<char> bytes;
+    for(std::uint64_t r{0}; r < header.num_records; ++r){
+        // The sizes are checked against the rest of the file before anything is allocated.
+        CheckpointRecordHeader record_header;
+        const std::uint64_t remaining = file_size - static_cast<std::uint64_t>(file.tellg());
+        if(!file.read(reinterpret_cast<char*>(&record_header), sizeof(record_header))
+            || record_header.name_size > remaining || record_header.num_bytes > remaining - record_header.name_size)
+        {
+            throw std::length_error(path + " ends in the middle of a record.");
+        }
+        name.resize(record_header.name_size);
+        file.read(&name[0], name.size());
+        bytes.resize(record_header.num_bytes);
+        file.read(bytes.data(), bytes.size());
+        if(!file){
+            throw std::length_error(path + " ends in the middle of a record.");
+        }
+        state.save_bytes(name, record_header.element_size, bytes.data(), bytes.size());
+    }
+}
+
+#endif
@@ -1,6 +1,7 @@
 #ifndef compound_types_H
 #define compound_types_H
 
+#include <cstddef>
 #include <stdexcept>
 
 #include "hdf5.h"
@@ -8,6 +9,7 @@
 #include "numeric_types.h"
 #include "../../vector/include/vector2D.h"
 #include "../../vector/include/vector3D.h"
+#include "../../vector/include/vector_traits.h"
 
 template<typename T> hid_t h5_Vector2D(){
     hid_t vector2d_type_id = H5Tcreate(H5T_COMPOUND, sizeof(Vector2D<T>));
@@ -31,22 +33,37 @@ template<typename T> hid_t h5_vector_type(){
 }
 
 
-template<> hid_t h5_vector_type<Vector2D<float>>(){
+template<> inline hid_t h5_vector_type<Vector2D<float>>(){
     return h5_Vector2D<float>();
 }
 
 
-template<> hid_t h5_vector_type<Vector2D<double>>(){
+template<> inline hid_t h5_vector_type<Vector2D<double>>(){
     return h5_Vector2D<double>();
 }
 
 
-template<> hid_t h5_vector_type<Vector3D<float>>(){
+template<> inline hid_t h5_vector_type<Vector3D<float>>(){
     return h5_Vector3D<float>();
 }
 
 
-template<> hid_t h5_vector_type<Vector3D<double>>(){
+template<> inline hid_t h5_vector_type<Vector3D<double>>(){
     return h5_Vector3D<double>();
 }
+
+
+// The compound type of a vector in a file, with the components packed in the byte order of
+// h5_file_type. On little-endian machines it has the same layout as the type in memory, so the
+// vectors are copied without conversion.
+template<typename T> hid_t h5_file_vector_type(){
+    using value_type = typename T::value_type;
+    constexpr char const* names[3] = {"x", "y", "z"};
+    constexpr std::size_t dimension = vector_traits<T>::dimension;
+    hid_t vector_type_id = H5Tcreate(H5T_COMPOUND, dimension * sizeof(value_type));
+    for(std::size_t d{0}; d < dimension; ++d){
+        H5Tinsert(vector_type_id, names[d], d * sizeof(value_type), h5_file_type<value_type>());
+    }
+    return vector_type_id;
+}
 #endif
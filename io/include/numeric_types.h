@@ -9,27 +9,29 @@ template<typename T> hid_t h5_memory_type(){
 }
 
 
-template<> hid_t h5_memory_type<float>(){
+template<> inline hid_t h5_memory_type<float>(){
     return H5T_NATIVE_FLOAT;
 }
 
 
-template<> hid_t h5_memory_type<double>(){
+template<> inline hid_t h5_memory_type<double>(){
     return H5T_NATIVE_DOUBLE;
 }
 
 
+// Numbers are stored little-endian, which is the native byte order of the machines we run on, so
+// that reading and writing does not convert every number.
 template<typename T> hid_t h5_file_type(){
     throw std::domain_error("Invalid type for I/O to HDF5 file.");
 }
 
 
-template<> hid_t h5_file_type<float>(){
-    return H5T_IEEE_F32BE;
+template<> inline hid_t h5_file_type<float>(){
+    return H5T_IEEE_F32LE;
 }
 
 
-template<> hid_t h5_file_type<double>(){
-    return H5T_IEEE_F64BE;
+template<> inline hid_t h5_file_type<double>(){
+    return H5T_IEEE_F64LE;
 }
 #endif
@@ -0,0 +1,278 @@
+// A snapshot of a star system in a raw binary file, for fast restarts and replays.
+// The file is a header followed by the arrays of the star system exactly as they are in memory:
+// every component of the positions, every component of the velocities and the masses, each
+// starting at a multiple of the cache line size. Reading it needs no parsing, the arrays are
+// either read straight into a star system or mapped into memory with RawSnapshotView. Mapped
+// snapshots are shared through the page cache by every process that maps them.
+//
+// The numbers are stored in the byte order of the machine that wrote the file, so a file can only
+// be read on a machine with the same byte order, and only into bodies with the same numeric type
+// and dimension. HDF5 files are the portable format.
+#ifndef RawSnapshot_H
+#define RawSnapshot_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../../body/include/star_system.h"
+#include "../../vector/include/aligned_allocator.h"
+#include "../../vector/include/vector_traits.h"
+
+constexpr char RAW_SNAPSHOT_MAGIC[8] = {'N', 'B', 'O', 'D', 'Y', 'R', 'A', 'W'};
+constexpr std::uint32_t RAW_SNAPSHOT_VERSION = 1;
+constexpr std::uint32_t RAW_SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+
+struct RawSnapshotHeader{
+    char magic[8];
+    std::uint32_t version;
+
+    // RAW_SNAPSHOT_BYTE_ORDER as written, which reads differently with another byte order.
+    std::uint32_t byte_order;
+
+    std::uint64_t num_bodies;
+    std::uint32_t dimension;
+    std::uint32_t numeric_size;
+    double timestamp;
+
+    // Offset of the first array from the start of the file, and the distance between the
+    // starts of the arrays, both in bytes.
+    std::uint64_t data_offset;
+    std::uint64_t array_stride;
+
+    char reserved[8];
+};
+
+static_assert(sizeof(RawSnapshotHeader) == CACHE_LINE_SIZE, "The raw snapshot header should fill a cache line, so that the arrays after it are aligned.");
+
+
+// The header of a snapshot of a star system with the given bodies.
+template<typename BodyType> RawSnapshotHeader make_raw_snapshot_header(const std::size_t num_bodies, const double timestamp){
+    using numeric_type = typename BodyType::numeric_type;
+    RawSnapshotHeader header{};
+    std::memcpy(header.magic, RAW_SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = RAW_SNAPSHOT_VERSION;
+    header.byte_order = RAW_SNAPSHOT_BYTE_ORDER;
+    header.num_bodies = num_bodies;
+    header.dimension = vector_traits<typename BodyType::vector_type>::dimension;
+    header.numeric_size = sizeof(numeric_type);
+    header.timestamp = timestamp;
+    header.data_offset = sizeof(RawSnapshotHeader);
+    const std::size_t array_size = num_bodies * sizeof(numeric_type);
+    header.array_stride = (array_size + CACHE_LINE_SIZE - 1) / CACHE_LINE_SIZE * CACHE_LINE_SIZE;
+    return header;
+}
+
+
+// Check that a header was written for the given bodies and that the file holds all arrays.
+template<typename BodyType> void check_raw_snapshot_header(const RawSnapshotHeader& header, const std::size_t file_size, const std::string& path){
+    const RawSnapshotHeader expected = make_raw_snapshot_header<BodyType>(header.num_bodies, header.timestamp);
+    if(std::memcmp(header.magic, RAW_SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 || header.version != RAW_SNAPSHOT_VERSION){
+        throw std::invalid_argument(path + " is not a raw snapshot of this version.");
+    }
+    if(header.byte_order != RAW_SNAPSHOT_BYTE_ORDER){
+        throw std::invalid_argument(path + " was written on a machine with a different byte order.");
+    }
+    if(header.dimension != expected.dimension || header.numeric_size != expected.numeric_size){
+        throw std::invalid_argument(path + " holds " + std::to_string(header.dimension) + "D vectors of " + std::to_string(header.numeric_size) + " byte numbers, but the bodies have " + std::to_string(expected.dimension) + "D vectors of " + std::to_string(expected.numeric_size) + " byte numbers.");
+    }
+    if(header.data_offset != expected.data_offset || header.array_stride != expected.array_stride){
+        throw std::invalid_argument("The arrays in " + path + " are not laid out as expected.");
+    }
+    const std::size_t num_arrays = 2*header.dimension + 1;
+    if(file_size < header.data_offset + num_arrays * header.array_stride){
+        throw std::length_error(path + " is shorter than the arrays of " + std::to_string(header.num_bodies) + " bodies.");
+    }
+}
+
+
+// Write a snapshot of a star system to a raw file, replacing the file if it exists. Like a
+// checkpoint, the file is written under a temporary name and then renamed, so that a crash while
+// writing never leaves a partial snapshot, and views that map the previous file keep its data.
+template<typename BodyType> void write_raw_snapshot(const std::string& path, const StarSystem<BodyType>& star_system, const double timestamp){
+    using numeric_type = typename BodyType::numeric_type;
+    constexpr std::size_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+    const RawSnapshotHeader header = make_raw_snapshot_header<BodyType>(star_system.size(), timestamp);
+
+    const std::string temporary_path = path + ".tmp";
+    std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+    if(!file){
+        throw std::runtime_error("Could not open " + temporary_path + " for writing.");
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+    // The arrays are padded to a multiple of the cache line size.
+    const std::size_t array_size = star_system.size() * sizeof(numeric_type);
+    const std::vector<char> padding(header.array_stride - array_size, 0);
+    auto write_array = [&](const numeric_type* data){
+        file.write(reinterpret_cast<const char*>(data), array_size);
+        file.write(padding.data(), padding.size());
+    };
+    for(std::size_t d{0}; d < dimension; ++d){
+        write_array(star_system.positions().data(d));
+    }
+    for(std::size_t d{0}; d < dimension; ++d){
+        write_array(star_system.velocities().data(d));
+    }
+    write_array(star_system.masses().data());
+
+    file.close();
+    if(!file){
+        throw std::runtime_error("Could not write the snapshot to " + temporary_path + ".");
+    }
+    if(std::rename(temporary_path.c_str(), path.c_str()) != 0){
+        throw std::runtime_error("Could not rename " + temporary_path + " to " + path + ".");
+    }
+}
+
+
+// Read a raw snapshot into an existing star system, which is resized to the number of bodies in
+// the file, and return its timestamp. The arrays are read straight into the star system.
+template<typename BodyType> double read_raw_snapshot(const std::string& path, StarSystem<BodyType>& star_system){
+    using numeric_type = typename BodyType::numeric_type;
+    constexpr std::size_t dimension = vector_traits<typename BodyType::vector_type>::dimension;
+
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if(!file){
+        throw std::runtime_error("Could not open " + path + " for reading.");
+    }
+    const std::size_t file_size = static_cast<std::size_t>(file.tellg());
+    file.seekg(0);
+    RawSnapshotHeader header;
+    if(file_size < sizeof(header) || !file.read(reinterpret_cast<char*>(&header), sizeof(header))){
+        throw std::length_error(path + " is too short to be a raw snapshot.");
+    }
+    check_raw_snapshot_header<BodyType>(header, file_size, path);
+
+    star_system.resize(header.num_bodies);
+    const std::size_t array_size = header.num_bodies * sizeof(numeric_type);
+    std::size_t array{0};
+    auto read_array = [&](numeric_type* data){
+        file.seekg(header.data_offset + (array++) * header.array_stride);
+        file.read(reinterpret_cast<char*>(data), array_size);
+    };
+    for(std::size_t d{0}; d < dimension; ++d){
+        read_array(star_system.positions().data(d));
+    }
+    for(std::size_t d{0}; d < dimension; ++d){
+        read_array(star_system.velocities().data(d));
+    }
+    read_array(star_system.masses().data());
+    if(!file){
+        throw std::runtime_error("Could not read the snapshot from " + path + ".");
+    }
+    return header.timestamp;
+}
+
+
+// Read-only view of a raw snapshot mapped into memory. The arrays are used in place, without
+// reading or copying them, and pages are only loaded from the file once they are accessed.
+// A star system owns its arrays, so simulating from the snapshot needs a copy, which copy_to
+// makes with one copy per array.
+template<typename BodyType> class RawSnapshotView{
+    public:
+        using numeric_type = typename BodyType::numeric_type;
+        using vector_type = typename BodyType::vector_type;
+        static constexpr std::size_t dimension = vector_traits<vector_type>::dimension;
+
+        explicit RawSnapshotView(const std::string& path);
+
+        RawSnapshotView(const RawSnapshotView&) = delete;
+        RawSnapshotView(RawSnapshotView&&) = delete;
+        RawSnapshotView& operator=(const RawSnapshotView&) = delete;
+        RawSnapshotView& operator=(RawSnapshotView&&) = delete;
+
+        ~RawSnapshotView();
+
+        std::size_t size() const{ return _header.num_bodies; }
+        double timestamp() const{ return _header.timestamp; }
+
+        // The arrays in the mapped file, aligned to the cache line size.
+        const numeric_type* positions(const std::size_t d) const{ return array(d); }
+        const numeric_type* velocities(const std::size_t d) const{ return array(dimension + d); }
+        const numeric_type* masses() const{ return array(2*dimension); }
+
+        vector_type position(const std::size_t index) const{ return gather(0, index); }
+        vector_type velocity(const std::size_t index) const{ return gather(dimension, index); }
+        numeric_type mass(const std::size_t index) const{ return masses()[index]; }
+
+        // Copy the snapshot into a star system, which is resized to the number of bodies.
+        void copy_to(StarSystem<BodyType>& star_system) const;
+
+    private:
+        RawSnapshotHeader _header;
+        std::size_t _mapped_size;
+        const char* _data;
+
+        const numeric_type* array(const std::size_t a) const{
+            return reinterpret_cast<const numeric_type*>(_data + _header.data_offset + a * _header.array_stride);
+        }
+
+        vector_type gather(const std::size_t first_array, const std::size_t index) const{
+            std::array<numeric_type, dimension> components;
+            for(std::size_t d{0}; d < dimension; ++d){
+                components[d] = array(first_array + d)[index];
+            }
+            return vector_traits<vector_type>::make(components);
+        }
+};
+
+
+template<typename BodyType> RawSnapshotView<BodyType>::RawSnapshotView(const std::string& path){
+    const int descriptor = ::open(path.c_str(), O_RDONLY);
+    if(descriptor < 0){
+        throw std::runtime_error("Could not open " + path + " for reading.");
+    }
+    struct stat status;
+    if(::fstat(descriptor, &status) != 0 || static_cast<std::size_t>(status.st_size) < sizeof(RawSnapshotHeader)){
+        ::close(descriptor);
+        throw std::length_error(path + " is too short to be a raw snapshot.");
+    }
+    _mapped_size = static_cast<std::size_t>(status.st_size);
+
+    // The mapping stays valid after the file is closed.
+    void* mapping = ::mmap(nullptr, _mapped_size, PROT_READ, MAP_SHARED, descriptor, 0);
+    ::close(descriptor);
+    if(mapping == MAP_FAILED){
+        throw std::runtime_error("Could not map " + path + " into memory.");
+    }
+    _data = static_cast<const char*>(mapping);
+
+    std::memcpy(&_header, _data, sizeof(_header));
+    try{
+        check_raw_snapshot_header<BodyType>(_header, _mapped_size, path);
+    } catch(...){
+        ::munmap(const_cast<char*>(_data), _mapped_size);
+        throw;
+    }
+}
+
+
+template<typename BodyType> RawSnapshotView<BodyType>::~RawSnapshotView(){
+    ::munmap(const_cast<char*>(_data), _mapped_size);
+}
+
+
+template<typename BodyType> void RawSnapshotView<BodyType>::copy_to(StarSystem<BodyType>& star_system) const{
+    star_system.resize(size());
+    const std::size_t array_size = size() * sizeof(numeric_type);
+    for(std::size_t d{0}; d < dimension; ++d){
+        std::memcpy(star_system.positions().data(d), positions(d), array_size);
+        std::memcpy(star_system.velocities().data(d), velocities(d), array_size);
+    }
+    std::memcpy(star_system.masses().data(), masses(), array_size);
+}
+
+#endif
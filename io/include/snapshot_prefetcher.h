@@ -0,0 +1,204 @@
+// Range over the snapshots in a file, which reads ahead on a background thread.
+// Snapshots are read in order into a ring of star systems, so that reading the next snapshots
+// overlaps with whatever is done with the current one. The range can be walked once:
+//
+//     StarSystemReader<body_type> reader(file_name);
+//     for(const auto& snapshot: SnapshotPrefetcher<body_type>(reader, stride)){
+//         analyse(snapshot.timestamp, snapshot.star_system);
+//     }
+//
+// A snapshot stays valid until the iterator is incremented, after which its star system is
+// reused for a later snapshot. The reader is used by the background thread, and the HDF5 library
+// is not thread safe, so neither the reader nor any other HDF5 call should be used while the
+// prefetcher exists.
+#ifndef SnapshotPrefetcher_H
+#define SnapshotPrefetcher_H
+
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "star_system_reader.h"
+#include "../../body/include/star_system.h"
+#include "../../parallel/include/bounded_queue.h"
+
+
+template<typename BodyType> class SnapshotPrefetcher{
+    public:
+        struct Snapshot{
+            std::size_t time_index;
+            typename BodyType::numeric_type timestamp;
+            StarSystem<BodyType> star_system;
+        };
+
+        class iterator{
+            public:
+                using iterator_category = std::input_iterator_tag;
+                using value_type = Snapshot;
+                using difference_type = std::ptrdiff_t;
+                using pointer = const Snapshot*;
+                using reference = const Snapshot&;
+
+                explicit iterator(SnapshotPrefetcher* prefetcher = nullptr): _prefetcher(prefetcher){}
+
+                reference operator*() const{ return _prefetcher->current(); }
+                pointer operator->() const{ return &_prefetcher->current(); }
+
+                iterator& operator++(){
+                    if(!_prefetcher->advance()){
+                        _prefetcher = nullptr;
+                    }
+                    return *this;
+                }
+
+                bool operator==(const iterator& other) const{ return _prefetcher == other._prefetcher; }
+                bool operator!=(const iterator& other) const{ return _prefetcher != other._prefetcher; }
+
+            private:
+                SnapshotPrefetcher* _prefetcher;
+        };
+
+        // Read every stride-th snapshot, starting at the first time index, and keep up to
+        // read_ahead snapshots ready in addition to the current one.
+        SnapshotPrefetcher(
+            const StarSystemReader<BodyType>& reader,
+            const std::size_t stride = 1,
+            const std::size_t read_ahead = 4,
+            const std::size_t first_time_index = 0);
+
+        SnapshotPrefetcher(const SnapshotPrefetcher&) = delete;
+        SnapshotPrefetcher(SnapshotPrefetcher&&) = delete;
+        SnapshotPrefetcher& operator=(const SnapshotPrefetcher&) = delete;
+        SnapshotPrefetcher& operator=(SnapshotPrefetcher&&) = delete;
+
+        // Stops reading ahead, also if the range was not walked to its end.
+        ~SnapshotPrefetcher();
+
+        std::size_t stride() const{ return _stride; }
+        std::size_t read_ahead() const{ return _slots.size() - 1; }
+
+        // Number of snapshots in the range.
+        std::size_t size() const{ return _size; }
+
+        // The range is single pass, so begin can only be called once.
+        iterator begin();
+        iterator end(){ return iterator(); }
+
+    private:
+        const StarSystemReader<BodyType>& _reader;
+        std::size_t _stride;
+        std::size_t _first_time_index;
+        std::size_t _size;
+
+        // Ring of snapshots. Slots are passed to the background thread through the free queue
+        // and back through the ready queue, so that a full ring stops the reading.
+        std::vector<Snapshot> _slots;
+        BoundedQueue<std::size_t> _free_slots;
+        BoundedQueue<std::size_t> _ready_slots;
+
+        // The slot of the current snapshot, if the consumer holds one.
+        std::size_t _current;
+        bool _holds_current = false;
+        bool _started = false;
+
+        std::mutex _mutex;
+        std::exception_ptr _error;
+        std::thread _thread;
+
+        const Snapshot& current() const{ return _slots[_current]; }
+        bool advance();
+        void run();
+
+        static std::size_t check_positive(const std::size_t value, const std::string& name);
+};
+
+
+template<typename BodyType> SnapshotPrefetcher<BodyType>::SnapshotPrefetcher(
+    const StarSystemReader<BodyType>& reader,
+    const std::size_t stride,
+    const std::size_t read_ahead,
+    const std::size_t first_time_index
+):
+    _reader(reader),
+    _stride(check_positive(stride, "stride")),
+    _first_time_index(first_time_index),
+    _size(first_time_index < reader.num_timestamps() ? (reader.num_timestamps() - first_time_index + stride - 1) / stride : 0),
+    _slots(check_positive(read_ahead, "number of snapshots to read ahead") + 1, Snapshot{0, 0., StarSystem<BodyType>(0)}),
+    _free_slots(_slots.size()),
+    _ready_slots(_slots.size())
+{
+    for(std::size_t s{0}; s < _slots.size(); ++s){
+        _free_slots.push(s);
+    }
+    _thread = std::thread(&SnapshotPrefetcher::run, this);
+}
+
+
+template<typename BodyType> SnapshotPrefetcher<BodyType>::~SnapshotPrefetcher(){
+    _free_slots.close();
+    _ready_slots.close();
+    _thread.join();
+}
+
+
+template<typename BodyType> typename SnapshotPrefetcher<BodyType>::iterator SnapshotPrefetcher<BodyType>::begin(){
+    if(_started){
+        throw std::logic_error("The snapshots of a prefetcher can only be walked once.");
+    }
+    _started = true;
+    return (advance() ? iterator(this) : end());
+}
+
+
+template<typename BodyType> bool SnapshotPrefetcher<BodyType>::advance(){
+    if(_holds_current){
+        _free_slots.push(_current);
+    }
+    _holds_current = _ready_slots.pop(_current);
+    if(!_holds_current){
+        // The ready queue is closed at the end of the range, or if reading failed.
+        std::lock_guard<std::mutex> lock(_mutex);
+        if(_error){
+            std::rethrow_exception(_error);
+        }
+    }
+    return _holds_current;
+}
+
+
+template<typename BodyType> void SnapshotPrefetcher<BodyType>::run(){
+    try{
+        for(std::size_t i{0}; i < _size; ++i){
+            std::size_t slot;
+            if(!_free_slots.pop(slot)){
+                return;
+            }
+            // The star system of the slot is reused, so reading does not allocate.
+            Snapshot& snapshot = _slots[slot];
+            snapshot.time_index = _first_time_index + i*_stride;
+            snapshot.timestamp = _reader.at(snapshot.time_index, snapshot.star_system);
+            if(!_ready_slots.push(slot)){
+                return;
+            }
+        }
+    } catch(...){
+        std::lock_guard<std::mutex> lock(_mutex);
+        _error = std::current_exception();
+    }
+    _ready_slots.close();
+}
+
+
+template<typename BodyType> std::size_t SnapshotPrefetcher<BodyType>::check_positive(const std::size_t value, const std::string& name){
+    if(value == 0){
+        throw std::invalid_argument("The " + name + " of a snapshot prefetcher must be positive.");
+    }
+    return value;
+}
+
+#endif
@@ -1,28 +1,38 @@
 #ifndef StarSystemReader_H
 #define StarSystemReader_H
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
 #include <iostream>
 #include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 #include "hdf5.h"
 
 #include "../../body/include/star_system.h"
 #include "../../body/include/body.h"
-#include "../../vector/include/vector3D.h"
+#include "../../vector/include/vector_traits.h"
 #include "../../force/include/direct_sum_force_computer.h"
+#include "compound_types.h"
 #include "numeric_types.h"
 
-// The only dependency on this file is the name of the dataset.
+// The only dependency on this file are the names of the datasets and the layouts.
 #include "star_system_writer.h"
 
 
+// Reads the snapshots of a star system written by StarSystemWriter.
+// The numbers in the file are converted to the numeric type of the bodies, so a file written in
+// single precision can be read in double precision and the other way around. The dimension of the
+// vectors in the file has to match the bodies.
 //TODO Would it not be cleaner to template this in the StarSystem type?
 template<typename BodyType> class StarSystemReader{
     public:
+        using numeric_type = typename BodyType::numeric_type;
+        using vector_type = typename BodyType::vector_type;
+        static constexpr std::size_t dimension = vector_traits<vector_type>::dimension;
 
-        // TODO: can we read the number of bodies from the file somehow?
-        // TODO: can we derive the type information and vector dimensionality somehow?
         StarSystemReader(const std::string& read_path);
 
         StarSystemReader(const StarSystemReader&) = delete;
@@ -37,96 +47,409 @@ template<typename BodyType> class StarSystemReader{
         // Number of timestamps stored in the file.
         std::size_t num_timestamps() const{ return _num_timestamps; }
 
+        std::size_t num_bodies() const{ return _num_bodies; }
+
+        // The layout is detected from the datasets in the file.
+        SnapshotLayout layout() const{ return _layout; }
+
 
         // Element access.
         // No reference is returned since we initialize a StarSystem object from a read array.
         // How should this work with interpolation between timestamps for visualization? Maybe it
         // is fine to interpolate between StarSystem objects at each timestamp there.
-        std::pair<double, StarSystem<BodyType>> at(const std::size_t) const;
+        std::pair<numeric_type, StarSystem<BodyType>> at(const std::size_t) const;
+
+        // Read a snapshot into an existing star system and return its timestamp. The star system
+        // is resized to the number of bodies in the file, and otherwise its arrays are reused, so
+        // scrubbing through many snapshots does not allocate. The reader keeps a buffer for this,
+        // so a reader must not be used by several threads at once.
+        numeric_type at(const std::size_t, StarSystem<BodyType>&) const;
+
+        // Partial access, which reads only the requested numbers from the file. In the row layout
+        // these still read complete chunks, so they are only fast with the columnar layout or
+        // with narrow chunks.
+        std::vector<numeric_type> timestamps() const;
+        numeric_type timestamp(const std::size_t time_index) const;
+
+        // A single field of all bodies at a time index.
+        std::vector<numeric_type> masses(const std::size_t time_index) const;
+        std::vector<vector_type> positions(const std::size_t time_index) const;
+        std::vector<vector_type> velocities(const std::size_t time_index) const;
+
+        // The states of a single body at the time indices first to last, both included.
+        std::vector<BodyType> trajectory(const std::size_t body_index, const std::size_t first_time_index, const std::size_t last_time_index) const;
 
         // Interpolated access. We request a specific timestamp and read only that one.
         // This should probably be optimized at some point.
-        //std::vector<double> timestamps() const;
         //StarSystem<BodyType> interpolate(const double) const;
 
     private:
+        // Where a field is stored: its dataset, the memory type of its elements, the column of the
+        // first body, the number of columns between bodies and the number of columns per body.
+        struct FieldLocation{
+            hid_t dset_id;
+            hid_t memory_type;
+            hsize_t offset;
+            hsize_t stride;
+            hsize_t width;
+        };
+
+        static_assert(sizeof(vector_type) == dimension * sizeof(numeric_type), "The components of a vector must be packed to read vectors as numbers.");
+
+        // A mass, a position vector and a velocity vector per body in the row layout.
+        static constexpr std::size_t numbers_per_body = 1 + 2*dimension;
+
+        SnapshotLayout _layout;
         hid_t _file_id;
-        hid_t _dset_id;
-        hid_t _dspace_id;
-        hsize_t _block_size[2];
+
+        // The dataset of the row layout, or the datasets of the columnar layout.
+        hid_t _dset_id = H5I_INVALID_HID;
+        hid_t _positions_id = H5I_INVALID_HID;
+        hid_t _velocities_id = H5I_INVALID_HID;
+        hid_t _masses_id = H5I_INVALID_HID;
+        hid_t _timestamps_id = H5I_INVALID_HID;
+
+        // Memory types of the numbers and vectors.
+        hid_t _number_type;
+        hid_t _vector_type;
+
+        // Constant masses of the columnar layout, which are read once.
+        std::vector<numeric_type> _masses;
+
         herr_t _status;
         std::size_t _num_timestamps;
 
-        // For memory space to read to reading.
-        // One block will be read into a 1D array in memory.
-        hid_t _mem_space_id;
-        hsize_t _mem_offset[1] = {0};
+        // Rows are read into this buffer and scattered to the arrays of a star system. It is
+        // kept between reads so that reading a snapshot into a star system allocates nothing.
+        mutable std::vector<numeric_type> _row;
 
-        // This should be generalized to 2D vectors as well.
         std::size_t _num_bodies;
+
+        void open_rows();
+        void open_columns();
+        void close();
+        void check_time_index(const std::size_t time_index) const;
+        FieldLocation location(const char* field) const;
+
+        // Read count[0] by count[1] blocks of block[1] elements each from a dataset of rank two,
+        // where the blocks start at the offset and are stride apart.
+        void read_blocks(const FieldLocation& field, const hsize_t offset[2], const hsize_t stride[2], const hsize_t count[2], const hsize_t block[2], void* destination) const;
+
+        // A field of all bodies at a time index, and a field of a single body over time.
+        void read_field(const char* field, const std::size_t time_index, void* destination) const;
+        void read_body(const char* field, const std::size_t body_index, const std::size_t first_time_index, const std::size_t num_times, void* destination) const;
+
+        // Read a row of vectors of the columnar layout into the arrays of a star system.
+        void read_vector_row(const char* field, const std::size_t time_index, VectorArray<vector_type>& vectors) const;
 };
 
 
 template<typename BodyType> StarSystemReader<BodyType>::StarSystemReader(const std::string& read_path):
     _file_id(H5Fopen(read_path.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT)),
-    _dset_id(H5Dopen(_file_id, DSET_NAME, H5P_DEFAULT)),
-    _dspace_id(H5Dget_space(_dset_id))
+    _number_type(h5_memory_type<numeric_type>()),
+    _vector_type(h5_vector_type<vector_type>())
 {
-    // Read the dimensionality from the dataspace.
-    const int ndims{H5Sget_simple_extent_ndims(_dspace_id)};
-    hsize_t dims[ndims]; 
-    _status = H5Sget_simple_extent_dims(_dspace_id, dims, NULL);
+    if(_file_id < 0){
+        H5Tclose(_vector_type);
+        throw std::runtime_error("Could not open " + read_path + ".");
+    }
+    try{
+        if(H5Lexists(_file_id, DSET_NAME, H5P_DEFAULT) > 0){
+            open_rows();
+        } else {
+            open_columns();
+        }
+    } catch(...){
+        close();
+        throw;
+    }
+}
+
+template<typename BodyType> void StarSystemReader<BodyType>::open_rows(){
+    _layout = SnapshotLayout::rows;
+    _dset_id = H5Dopen(_file_id, DSET_NAME, H5P_DEFAULT);
+
+    // Read the dimensions from the dataspace.
+    hid_t dspace_id = H5Dget_space(_dset_id);
+    if(H5Sget_simple_extent_ndims(dspace_id) != 2){
+        H5Sclose(dspace_id);
+        throw std::length_error("The star system snapshots must be a dataset of rank two.");
+    }
+    hsize_t dims[2];
+    _status = H5Sget_simple_extent_dims(dspace_id, dims, NULL);
+    H5Sclose(dspace_id);
     _num_timestamps = dims[0];
 
-    // TODO: Generalize this to 2D vectors.
-    // There are 7 numbers stored per body, and one timestamp.
-    if((dims[1] - 1) % 7 != 0){
-        throw std::length_error("The numbers representing a snapshot of a star system must be 7 numbers (3 position, 3 velocities, 1 mass) per body and must therefore be divisible by 7");
+    // Files without the attribute hold 3D vectors.
+    int file_dimension = 3;
+    if(H5Aexists(_dset_id, DIMENSION_ATTRIBUTE_NAME) > 0){
+        hid_t attribute_id = H5Aopen(_dset_id, DIMENSION_ATTRIBUTE_NAME, H5P_DEFAULT);
+        _status = H5Aread(attribute_id, H5T_NATIVE_INT, &file_dimension);
+        H5Aclose(attribute_id);
+    }
+    if(file_dimension != static_cast<int>(dimension)){
+        throw std::invalid_argument("The file holds " + std::to_string(file_dimension) + "D vectors, but the bodies have " + std::to_string(dimension) + "D vectors.");
+    }
+
+    // There is a mass, a position and a velocity stored per body, and one timestamp.
+    if((dims[1] - 1) % numbers_per_body != 0){
+        throw std::length_error("The numbers representing a snapshot of a star system must be " + std::to_string(numbers_per_body) + " numbers (positions, velocities, mass) per body and a timestamp.");
     }
-    _num_bodies = (dims[1] - 1)/7;
+    _num_bodies = (dims[1] - 1)/numbers_per_body;
+}
 
-    // Size of the read block for a single star system time point.
-    _block_size[0] = 1;
-    _block_size[1] = dims[1];
+template<typename BodyType> void StarSystemReader<BodyType>::open_columns(){
+    _layout = SnapshotLayout::columns;
+    _positions_id = H5Dopen(_file_id, POSITIONS_DSET_NAME, H5P_DEFAULT);
+    _velocities_id = H5Dopen(_file_id, VELOCITIES_DSET_NAME, H5P_DEFAULT);
+    _masses_id = H5Dopen(_file_id, MASSES_DSET_NAME, H5P_DEFAULT);
+    _timestamps_id = H5Dopen(_file_id, TIMESTAMPS_DSET_NAME, H5P_DEFAULT);
+    if(_positions_id < 0 || _velocities_id < 0 || _masses_id < 0 || _timestamps_id < 0){
+        throw std::runtime_error("The file holds neither the row nor the columnar layout of star system snapshots.");
+    }
+
+    // The vectors are compound types with a member per component.
+    hid_t type_id = H5Dget_type(_positions_id);
+    const bool is_compound = (H5Tget_class(type_id) == H5T_COMPOUND);
+    const int file_dimension = (is_compound ? H5Tget_nmembers(type_id) : 0);
+    H5Tclose(type_id);
+    if(file_dimension != static_cast<int>(dimension)){
+        throw std::invalid_argument("The file holds " + std::to_string(file_dimension) + "D vectors, but the bodies have " + std::to_string(dimension) + "D vectors.");
+    }
 
-    // Initialize the memory data space for the reading.
-    // The data at each timestamp is read into a 1D array in memory.
-    hsize_t mem_block_size[1] = {_block_size[1]};
-    _mem_space_id = H5Screate_simple(1, mem_block_size, NULL);
+    hid_t dspace_id = H5Dget_space(_positions_id);
+    hsize_t dims[2];
+    _status = H5Sget_simple_extent_dims(dspace_id, dims, NULL);
+    H5Sclose(dspace_id);
+    _num_timestamps = dims[0];
+    _num_bodies = dims[1];
+
+    // Constant masses are a single row.
+    dspace_id = H5Dget_space(_masses_id);
+    const int masses_rank{H5Sget_simple_extent_ndims(dspace_id)};
+    H5Sclose(dspace_id);
+    if(masses_rank == 1){
+        _masses.resize(_num_bodies);
+        _status = H5Dread(_masses_id, _number_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, _masses.data());
+    }
 }
 
 template<typename BodyType> StarSystemReader<BodyType>::~StarSystemReader(){
+    close();
+}
+
+template<typename BodyType> void StarSystemReader<BodyType>::close(){
+    for(hid_t id: {_dset_id, _positions_id, _velocities_id, _masses_id, _timestamps_id}){
+        if(id >= 0){
+            H5Dclose(id);
+        }
+    }
+    H5Tclose(_vector_type);
     H5Fclose(_file_id);
 }
 
-template<typename BodyType> std::pair<double, StarSystem<BodyType>> StarSystemReader<BodyType>::at(const std::size_t time_index) const{
-    // Select the correct file hyperslab to read out the requested time index.
-    hsize_t read_offset[2] = {time_index, 0};
-    H5Sselect_hyperslab(_dspace_id, H5S_SELECT_SET, read_offset, NULL, _block_size, NULL);
+template<typename BodyType> std::pair<typename BodyType::numeric_type, StarSystem<BodyType>> StarSystemReader<BodyType>::at(const std::size_t time_index) const{
+    StarSystem<BodyType> star_system(_num_bodies);
+    const numeric_type timestamp = at(time_index, star_system);
+    return {timestamp, std::move(star_system)};
+}
+
+template<typename BodyType> typename BodyType::numeric_type StarSystemReader<BodyType>::at(const std::size_t time_index, StarSystem<BodyType>& star_system) const{
+    check_time_index(time_index);
+    star_system.resize(_num_bodies);
+    numeric_type* masses = star_system.masses().data();
+
+    if(_layout == SnapshotLayout::rows){
+        // A whole row is read at once and scattered to the arrays.
+        const std::size_t row_size = numbers_per_body*_num_bodies + 1;
+        _row.resize(row_size);
+        const FieldLocation row{_dset_id, _number_type, 0, 1, 1};
+        const hsize_t offset[2] = {time_index, 0};
+        const hsize_t stride[2] = {1, 1};
+        const hsize_t count[2] = {1, row_size};
+        read_blocks(row, offset, stride, count, stride, _row.data());
+        for(std::size_t d{0}; d < dimension; ++d){
+            numeric_type* positions = star_system.positions().data(d);
+            numeric_type* velocities = star_system.velocities().data(d);
+            for(std::size_t b{0}; b < _num_bodies; ++b){
+                positions[b] = _row[b*numbers_per_body + 1 + d];
+                velocities[b] = _row[b*numbers_per_body + 1 + dimension + d];
+            }
+        }
+        for(std::size_t b{0}; b < _num_bodies; ++b){
+            masses[b] = _row[b*numbers_per_body];
+        }
+        return _row[row_size - 1];
+    }
+
+    // Varying masses are a contiguous row that is read straight into the star system.
+    if(_masses.empty()){
+        read_field(MASSES_DSET_NAME, time_index, masses);
+    } else {
+        std::copy(_masses.begin(), _masses.end(), masses);
+    }
+    read_vector_row(POSITIONS_DSET_NAME, time_index, star_system.positions());
+    read_vector_row(VELOCITIES_DSET_NAME, time_index, star_system.velocities());
+    return timestamp(time_index);
+}
+
 
-    // Read the data into an array.
-    // TODO: Generalize this to other types.
-    double read_array[_block_size[1]];
-    H5Dread(_dset_id, H5T_NATIVE_DOUBLE, _mem_space_id, _dspace_id, H5P_DEFAULT, read_array);
+template<typename BodyType> std::vector<typename BodyType::numeric_type> StarSystemReader<BodyType>::timestamps() const{
+    std::vector<numeric_type> result(_num_timestamps);
+    if(_num_timestamps == 0){
+        return result;
+    }
+    if(_layout == SnapshotLayout::columns){
+        H5Dread(_timestamps_id, _number_type, H5S_ALL, H5S_ALL, H5P_DEFAULT, result.data());
+        return result;
+    }
+    // The last column of the rows.
+    const FieldLocation column{_dset_id, _number_type, numbers_per_body*_num_bodies, 1, 1};
+    const hsize_t offset[2] = {0, column.offset};
+    const hsize_t stride[2] = {1, 1};
+    const hsize_t count[2] = {_num_timestamps, 1};
+    const hsize_t block[2] = {1, 1};
+    read_blocks(column, offset, stride, count, block, result.data());
+    return result;
+}
+
+template<typename BodyType> typename BodyType::numeric_type StarSystemReader<BodyType>::timestamp(const std::size_t time_index) const{
+    check_time_index(time_index);
+    numeric_type result;
+    if(_layout == SnapshotLayout::columns){
+        hid_t file_space = H5Dget_space(_timestamps_id);
+        const hsize_t offset[1] = {time_index};
+        const hsize_t count[1] = {1};
+        H5Sselect_hyperslab(file_space, H5S_SELECT_SET, offset, NULL, count, NULL);
+        hid_t mem_space = H5Screate_simple(1, count, NULL);
+        H5Dread(_timestamps_id, _number_type, mem_space, file_space, H5P_DEFAULT, &result);
+        H5Sclose(mem_space);
+        H5Sclose(file_space);
+        return result;
+    }
+    const FieldLocation column{_dset_id, _number_type, numbers_per_body*_num_bodies, 1, 1};
+    const hsize_t offset[2] = {time_index, column.offset};
+    const hsize_t stride[2] = {1, 1};
+    const hsize_t count[2] = {1, 1};
+    const hsize_t block[2] = {1, 1};
+    read_blocks(column, offset, stride, count, block, &result);
+    return result;
+}
 
-    // Convert the read array into a star system.
-    // TODO: Generalize this to other vector types.
-    double timestamp = read_array[_block_size[1] - 1];
-    std::vector<BodyType> bodies(_num_bodies);
-    for(std::size_t b{0}; b < _num_bodies; ++b){
-        std::size_t s{b*7};
-        double mass{read_array[s]};
-        Vector3D<double> pos{read_array[s + 1], read_array[s + 2], read_array[s + 3]};
-        Vector3D<double> vel{read_array[s + 4], read_array[s + 5], read_array[s + 6]};
-        bodies[b] = BodyType{pos, vel, mass};
+template<typename BodyType> std::vector<typename BodyType::numeric_type> StarSystemReader<BodyType>::masses(const std::size_t time_index) const{
+    check_time_index(time_index);
+    if(!_masses.empty()){
+        return _masses;
     }
-    return {timestamp, StarSystem<BodyType>{bodies}};
+    std::vector<numeric_type> result(_num_bodies);
+    read_field(MASSES_DSET_NAME, time_index, result.data());
+    return result;
 }
 
+template<typename BodyType> std::vector<typename BodyType::vector_type> StarSystemReader<BodyType>::positions(const std::size_t time_index) const{
+    check_time_index(time_index);
+    std::vector<vector_type> result(_num_bodies);
+    read_field(POSITIONS_DSET_NAME, time_index, result.data());
+    return result;
+}
+
+template<typename BodyType> std::vector<typename BodyType::vector_type> StarSystemReader<BodyType>::velocities(const std::size_t time_index) const{
+    check_time_index(time_index);
+    std::vector<vector_type> result(_num_bodies);
+    read_field(VELOCITIES_DSET_NAME, time_index, result.data());
+    return result;
+}
+
+template<typename BodyType> std::vector<BodyType> StarSystemReader<BodyType>::trajectory(const std::size_t body_index, const std::size_t first_time_index, const std::size_t last_time_index) const{
+    if(body_index >= _num_bodies){
+        throw std::out_of_range("Body index " + std::to_string(body_index) + " is out of range for " + std::to_string(_num_bodies) + " bodies.");
+    }
+    check_time_index(last_time_index);
+    if(first_time_index > last_time_index){
+        throw std::out_of_range("The first time index of a trajectory must not come after the last one.");
+    }
+
+    const std::size_t num_times = last_time_index - first_time_index + 1;
+    std::vector<numeric_type> masses(num_times);
+    std::vector<vector_type> positions(num_times);
+    std::vector<vector_type> velocities(num_times);
+    if(_masses.empty()){
+        read_body(MASSES_DSET_NAME, body_index, first_time_index, num_times, masses.data());
+    } else {
+        std::fill(masses.begin(), masses.end(), _masses[body_index]);
+    }
+    read_body(POSITIONS_DSET_NAME, body_index, first_time_index, num_times, positions.data());
+    read_body(VELOCITIES_DSET_NAME, body_index, first_time_index, num_times, velocities.data());
+
+    std::vector<BodyType> result(num_times);
+    for(std::size_t t{0}; t < num_times; ++t){
+        result[t] = BodyType{positions[t], velocities[t], masses[t]};
+    }
+    return result;
+}
+
+template<typename BodyType> void StarSystemReader<BodyType>::check_time_index(const std::size_t time_index) const{
+    if(time_index >= _num_timestamps){
+        throw std::out_of_range("Time index " + std::to_string(time_index) + " is out of range for " + std::to_string(_num_timestamps) + " timestamps.");
+    }
+}
+
+template<typename BodyType> typename StarSystemReader<BodyType>::FieldLocation StarSystemReader<BodyType>::location(const char* field) const{
+    const std::string name{field};
+    if(_layout == SnapshotLayout::rows){
+        // The mass comes first in the numbers of a body, then the position and the velocity.
+        if(name == MASSES_DSET_NAME){
+            return FieldLocation{_dset_id, _number_type, 0, numbers_per_body, 1};
+        }
+        const hsize_t offset = (name == POSITIONS_DSET_NAME ? 1 : 1 + dimension);
+        return FieldLocation{_dset_id, _number_type, offset, numbers_per_body, dimension};
+    }
+    if(name == MASSES_DSET_NAME){
+        return FieldLocation{_masses_id, _number_type, 0, 1, 1};
+    }
+    const hid_t dset_id = (name == POSITIONS_DSET_NAME ? _positions_id : _velocities_id);
+    return FieldLocation{dset_id, _vector_type, 0, 1, 1};
+}
+
+template<typename BodyType> void StarSystemReader<BodyType>::read_blocks(const FieldLocation& field, const hsize_t offset[2], const hsize_t stride[2], const hsize_t count[2], const hsize_t block[2], void* destination) const{
+    const hsize_t num_elements[1] = {count[0]*count[1]*block[0]*block[1]};
+    hid_t file_space = H5Dget_space(field.dset_id);
+    H5Sselect_hyperslab(file_space, H5S_SELECT_SET, offset, stride, count, block);
+    hid_t mem_space = H5Screate_simple(1, num_elements, NULL);
+    H5Dread(field.dset_id, field.memory_type, mem_space, file_space, H5P_DEFAULT, destination);
+    H5Sclose(mem_space);
+    H5Sclose(file_space);
+}
+
+template<typename BodyType> void StarSystemReader<BodyType>::read_field(const char* field_name, const std::size_t time_index, void* destination) const{
+    const FieldLocation field = location(field_name);
+    const hsize_t offset[2] = {time_index, field.offset};
+    const hsize_t stride[2] = {1, field.stride};
+    const hsize_t count[2] = {1, _num_bodies};
+    const hsize_t block[2] = {1, field.width};
+    read_blocks(field, offset, stride, count, block, destination);
+}
+
+template<typename BodyType> void StarSystemReader<BodyType>::read_body(const char* field_name, const std::size_t body_index, const std::size_t first_time_index, const std::size_t num_times, void* destination) const{
+    const FieldLocation field = location(field_name);
+    const hsize_t offset[2] = {first_time_index, field.offset + body_index*field.stride};
+    const hsize_t stride[2] = {1, 1};
+    const hsize_t count[2] = {num_times, 1};
+    const hsize_t block[2] = {1, field.width};
+    read_blocks(field, offset, stride, count, block, destination);
+}
+
+template<typename BodyType> void StarSystemReader<BodyType>::read_vector_row(const char* field_name, const std::size_t time_index, VectorArray<vector_type>& vectors) const{
+    _row.resize(dimension*_num_bodies);
+    read_field(field_name, time_index, _row.data());
+    for(std::size_t d{0}; d < dimension; ++d){
+        numeric_type* components = vectors.data(d);
+        for(std::size_t b{0}; b < _num_bodies; ++b){
+            components[b] = _row[b*dimension + d];
+        }
+    }
+}
 
-//template<typename BodyType> std::vector<double> StarSystemReader<BodyType>::timestamps() const{
-//}
-//
 //template<typename BodyType> StarSystem<BodyType> StarSystemReader<BodyType>::interpolate(const double) const{
 //}
 #endif
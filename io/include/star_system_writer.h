@@ -1,110 +1,418 @@
 #ifndef StarSystemWriter_H
 #define StarSystemWriter_H
 
+#include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdlib>
 #include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 #include "hdf5.h"
 
 #include "../../body/include/star_system.h"
+#include "../../vector/include/vector_traits.h"
+#include "compound_types.h"
 #include "numeric_types.h"
 
 constexpr char const* DSET_NAME = "star_system_snapshots";
+constexpr char const* POSITIONS_DSET_NAME = "positions";
+constexpr char const* VELOCITIES_DSET_NAME = "velocities";
+constexpr char const* MASSES_DSET_NAME = "masses";
+constexpr char const* TIMESTAMPS_DSET_NAME = "timestamps";
+
+// Attribute of the row layout dataset with the dimension of the vectors, which can not be told
+// from the number of columns. Files without it hold 3D vectors.
+constexpr char const* DIMENSION_ATTRIBUTE_NAME = "dimension";
+
+
+// In the row layout every snapshot is a row of a single dataset, and every row holds the numbers
+// of every body (a mass, a position vector and a velocity vector) followed by the timestamp.
+// Reading a single field or a single body still reads complete rows, unless the chunks are narrow.
+// In the columnar layout the positions and velocities are separate datasets with a row of vectors,
+// of the compound types in compound_types.h, for every snapshot, the timestamps are a one
+// dimensional dataset, and the masses are a single row if they are constant or a dataset like the
+// positions otherwise. Reading only the positions, or only the trajectory of one body, then reads
+// only those numbers.
+// The numbers are stored with the numeric type of the bodies, so a simulation in single precision
+// writes half the bytes of one in double precision.
+enum class SnapshotLayout{rows, columns};
+
+inline std::string to_string(const SnapshotLayout layout){
+    switch(layout){
+        case SnapshotLayout::rows: return "rows";
+        case SnapshotLayout::columns: return "columns";
+    }
+    return "unknown";
+}
+
+
+// Lossless compression of the chunks of the datasets. Both compressors need the HDF5 library to
+// be built with them, and the writer throws if it is not. Szip only compresses plain numbers, so
+// it can not be used with the columnar layout.
+enum class SnapshotCompression{none, deflate, szip};
+
+inline std::string to_string(const SnapshotCompression compression){
+    switch(compression){
+        case SnapshotCompression::none: return "none";
+        case SnapshotCompression::deflate: return "deflate";
+        case SnapshotCompression::szip: return "szip";
+    }
+    return "unknown";
+}
+
+
+struct StarSystemWriterOptions{
+    SnapshotLayout layout = SnapshotLayout::rows;
+
+    // In the columnar layout the masses are stored once, and the writer throws if they change.
+    // Without constant masses they are stored with every snapshot.
+    bool constant_masses = true;
+
+    // Number of snapshots that are buffered in memory and written to the file at once. Every
+    // write to an HDF5 dataset has a fixed overhead, which dominates at a high output cadence if
+    // snapshots are written one by one.
+    std::size_t snapshots_per_write = 16;
+
+    // Shape of the chunks of the datasets, in snapshots and in bodies. Zero bodies means all
+    // bodies, so a chunk holds complete snapshots including their timestamps. Chunks of fewer
+    // bodies make reading the trajectory of a single body fast, since only the chunks of that
+    // body have to be read. If they divide the bodies, they are made one body wider, so that the
+    // timestamps fit into the last chunk of a snapshot. Writes are fastest if snapshots_per_write
+    // is a multiple of chunk_snapshots, so that every write fills complete chunks.
+    std::size_t chunk_snapshots = 16;
+    std::size_t chunk_bodies = 0;
+
+    // Compression of the chunks. With shuffling the bytes of the numbers in a chunk are grouped
+    // by significance before compression, which puts the slowly varying sign and exponent bytes
+    // next to each other and usually compresses much better. The deflate level is between 1
+    // (fastest) and 9 (smallest).
+    SnapshotCompression compression = SnapshotCompression::none;
+    bool shuffle = true;
+    unsigned deflate_level = 4;
+
+    // Maximum absolute error of the stored positions and velocities, or zero to store them
+    // exactly. Every component is rounded to a multiple of the largest power of two that keeps
+    // the error within the bound, which zeroes the low bits of the mantissa, so the quantized
+    // numbers compress well. Masses and timestamps are always stored exactly. Quantization alone
+    // does not make the file smaller, it should be combined with compression.
+    double position_error = 0.;
+    double velocity_error = 0.;
+};
+
 
 template<typename BodyType> class StarSystemWriter{
     public:
-        StarSystemWriter(const std::size_t num_bodies, const std::string& output_path);
+        using numeric_type = typename BodyType::numeric_type;
+        using vector_type = typename BodyType::vector_type;
+        static constexpr std::size_t dimension = vector_traits<vector_type>::dimension;
+
+        StarSystemWriter(const std::size_t num_bodies, const std::string& output_path, const StarSystemWriterOptions& options = StarSystemWriterOptions());
 
         StarSystemWriter(const StarSystemWriter&) = delete;
         StarSystemWriter(StarSystemWriter&&) = delete;
         StarSystemWriter& operator=(const StarSystemWriter&) = delete;
         StarSystemWriter& operator=(StarSystemWriter&&) = delete;
 
+        // Buffered snapshots are written before the file is closed.
         ~StarSystemWriter();
 
         herr_t h5_status() const{ return _status; }
 
+        const StarSystemWriterOptions& options() const{ return _options; }
+
+        // Number of snapshots that are buffered and not yet written to the file.
+        std::size_t num_buffered() const{ return _num_buffered; }
+
         // Writing a star system requires the star system and a timestamp.
-        herr_t write_star_system(const StarSystem<BodyType>&, const typename BodyType::numeric_type);
+        // The snapshot is buffered, and the buffer is written to the file once it is full.
+        herr_t write_star_system(const StarSystem<BodyType>&, const numeric_type);
+
+        // Write the buffered snapshots to the file.
+        herr_t flush();
 
     private:
+        // A dataset that grows by one row per snapshot, and the rows that are not written yet.
+        // Datasets of rank one hold a single element per snapshot. The elements are numbers or
+        // vectors, which are buffered as consecutive numbers.
+        struct SnapshotDataset{
+            hid_t dset_id;
+            hid_t memory_type;
+            int rank;
+            std::size_t row_size;
+            std::size_t numbers_per_element;
+            std::vector<numeric_type> buffer;
+        };
+
+        static_assert(sizeof(vector_type) == dimension * sizeof(numeric_type), "The components of a vector must be packed to buffer vectors as numbers.");
+
         std::size_t _num_bodies;
+        StarSystemWriterOptions _options;
         hid_t _file_id;
+        herr_t _status;
 
-        // TODO: Check if we can already close this during the constructor or if we need to keep it.
-        hid_t _dspace_id;
+        // Memory type of the vectors of the columnar layout.
+        hid_t _vector_type = H5I_INVALID_HID;
 
-        hid_t _mem_write_space_id;
-        hid_t _dset_id;
-        herr_t _status;
-        hsize_t _current_dims[2];
-        hsize_t _chunk_size[2];
+        // The single dataset of the row layout, or the positions, velocities, timestamps and, if
+        // they are not constant, the masses of the columnar layout.
+        std::vector<SnapshotDataset> _datasets;
+        hsize_t _num_written = 0;
+        std::size_t _num_buffered = 0;
+
+        // The constant masses of the columnar layout, stored with the first snapshot.
+        hid_t _masses_id = H5I_INVALID_HID;
+        std::vector<numeric_type> _masses;
+
+        // Quanta of the positions and velocities, zero if they are stored exactly.
+        numeric_type _position_quantum;
+        numeric_type _velocity_quantum;
+
+        // A mass, a position vector and a velocity vector per body, and a timestamp.
+        static constexpr std::size_t numbers_per_body = 1 + 2*dimension;
+        std::size_t row_size() const{ return _num_bodies*numbers_per_body + 1; }
+
+        void create_dataset(const char* name, const int rank, const std::size_t elements_per_body, const std::size_t elements_per_snapshot = 0, const bool vectors = false);
+        void buffer_columns(const StarSystem<BodyType>&, const numeric_type);
+
+        static numeric_type quantum(const double error);
+        static numeric_type quantize(const numeric_type value, const numeric_type quantum);
+        static void check_filter(const H5Z_filter_t filter, const std::string& name);
 };
 
 
-template<typename BodyType> StarSystemWriter<BodyType>::StarSystemWriter(const std::size_t num_bodies, const std::string& output_path):
-    _num_bodies(num_bodies)
+template<typename BodyType> StarSystemWriter<BodyType>::StarSystemWriter(const std::size_t num_bodies, const std::string& output_path, const StarSystemWriterOptions& options):
+    _num_bodies(num_bodies),
+    _options(options)
 {
+    if(options.snapshots_per_write == 0 || options.chunk_snapshots == 0){
+        throw std::invalid_argument("The number of snapshots per write and per chunk must be positive.");
+    }
+    if(options.compression == SnapshotCompression::deflate && (options.deflate_level < 1 || options.deflate_level > 9)){
+        throw std::invalid_argument("The deflate level must be between 1 and 9.");
+    }
+    if(options.compression == SnapshotCompression::szip && options.layout == SnapshotLayout::columns){
+        throw std::invalid_argument("Szip compression can not be used with the columnar layout.");
+    }
+    if(!(options.position_error >= 0.) || !(options.velocity_error >= 0.)){
+        throw std::invalid_argument("The error bounds of the positions and velocities must not be negative.");
+    }
+    _position_quantum = quantum(options.position_error);
+    _velocity_quantum = quantum(options.velocity_error);
+
+    // Fail before the file is created if a filter is missing.
+    if(options.compression != SnapshotCompression::none && options.shuffle){
+        check_filter(H5Z_FILTER_SHUFFLE, "shuffle");
+    }
+    if(options.compression == SnapshotCompression::deflate){
+        check_filter(H5Z_FILTER_DEFLATE, "deflate");
+    } else if(options.compression == SnapshotCompression::szip){
+        check_filter(H5Z_FILTER_SZIP, "szip");
+    }
+
     _file_id = H5Fcreate(output_path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
 
-    // Each body has 7 numbers representing it: a mass, a position vector, and a velocity vector.
-    // In addition we need to store a timestamp for each snapshot of the star system.
-    _current_dims[0] = 0;
-    _current_dims[1] = num_bodies*7 + 1;
-    const hsize_t max_dims[2] = {H5S_UNLIMITED, _current_dims[1]};
-    _dspace_id = H5Screate_simple(2, _current_dims, max_dims);
+    if(options.layout == SnapshotLayout::rows){
+        // Each body has a mass, a position vector, and a velocity vector representing it. In
+        // addition we need to store a timestamp for each snapshot of the star system.
+        create_dataset(DSET_NAME, 2, numbers_per_body, 1);
+        const int dimension_value = static_cast<int>(dimension);
+        hid_t attribute_space = H5Screate(H5S_SCALAR);
+        hid_t attribute_id = H5Acreate(_datasets[0].dset_id, DIMENSION_ATTRIBUTE_NAME, H5T_STD_I32LE, attribute_space, H5P_DEFAULT, H5P_DEFAULT);
+        _status = H5Awrite(attribute_id, H5T_NATIVE_INT, &dimension_value);
+        H5Aclose(attribute_id);
+        H5Sclose(attribute_space);
+    } else {
+        _vector_type = h5_vector_type<vector_type>();
+        create_dataset(POSITIONS_DSET_NAME, 2, 1, 0, true);
+        create_dataset(VELOCITIES_DSET_NAME, 2, 1, 0, true);
+        create_dataset(TIMESTAMPS_DSET_NAME, 1, 0, 1);
+        if(options.constant_masses){
+            const hsize_t dims[1] = {num_bodies};
+            hid_t dspace_id = H5Screate_simple(1, dims, NULL);
+            _masses_id = H5Dcreate(_file_id, MASSES_DSET_NAME, h5_file_type<numeric_type>(), dspace_id, H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+            H5Sclose(dspace_id);
+        } else {
+            create_dataset(MASSES_DSET_NAME, 2, 1);
+        }
+    }
+}
+
+template <typename BodyType> StarSystemWriter<BodyType>::~StarSystemWriter(){
+    flush();
+    for(SnapshotDataset& dataset: _datasets){
+        _status = H5Dclose(dataset.dset_id);
+    }
+    if(_masses_id != H5I_INVALID_HID){
+        _status = H5Dclose(_masses_id);
+    }
+    if(_vector_type != H5I_INVALID_HID){
+        _status = H5Tclose(_vector_type);
+    }
+    _status = H5Fclose(_file_id);
+}
+
+
+template <typename BodyType> void StarSystemWriter<BodyType>::create_dataset(const char* name, const int rank, const std::size_t elements_per_body, const std::size_t elements_per_snapshot, const bool vectors){
+    SnapshotDataset dataset;
+    dataset.memory_type = (vectors ? _vector_type : h5_memory_type<numeric_type>());
+    dataset.rank = rank;
+    dataset.row_size = _num_bodies * elements_per_body + elements_per_snapshot;
+    dataset.numbers_per_element = (vectors ? dimension : 1);
 
-    _chunk_size[0] = 1;
-    _chunk_size[1] = _current_dims[1];
+    const hsize_t current_dims[2] = {0, dataset.row_size};
+    const hsize_t max_dims[2] = {H5S_UNLIMITED, dataset.row_size};
+    hid_t dspace_id = H5Screate_simple(rank, current_dims, max_dims);
+
+    // The numbers of every snapshot, like the timestamp of the row layout, go into the last chunk
+    // of bodies, since a chunk of its own would be stored at full size for a single number. If
+    // the bodies fill the last chunk, the chunks take one body more until it has room, so that
+    // every chunk still starts at a body.
+    std::size_t chunk_bodies = (_options.chunk_bodies == 0 ? _num_bodies : std::min(_options.chunk_bodies, _num_bodies));
+    auto last_chunk_has_room = [&](){
+        const std::size_t num_chunks = (_num_bodies + chunk_bodies - 1) / chunk_bodies;
+        return num_chunks * chunk_bodies * elements_per_body >= dataset.row_size;
+    };
+    while(chunk_bodies < _num_bodies && !last_chunk_has_room()){
+        ++chunk_bodies;
+    }
+    const hsize_t chunk_width = (chunk_bodies >= _num_bodies ? dataset.row_size : chunk_bodies * elements_per_body);
+    const hsize_t chunk_size[2] = {_options.chunk_snapshots, std::max<hsize_t>(chunk_width, 1)};
     hid_t chunk_prop = H5Pcreate(H5P_DATASET_CREATE);
-    _status = H5Pset_chunk(chunk_prop, 2, _chunk_size);
+    _status = H5Pset_chunk(chunk_prop, rank, chunk_size);
+
+    // The filters are stored with the dataset, so readers decompress the chunks transparently.
+    if(_options.compression != SnapshotCompression::none && _options.shuffle){
+        _status = H5Pset_shuffle(chunk_prop);
+    }
+    if(_options.compression == SnapshotCompression::deflate){
+        _status = H5Pset_deflate(chunk_prop, _options.deflate_level);
+    } else if(_options.compression == SnapshotCompression::szip){
+        // Nearest neighbour preprocessing, in blocks of 16 numbers.
+        _status = H5Pset_szip(chunk_prop, H5_SZIP_NN_OPTION_MASK, 16);
+    }
 
-    // TODO: Fix type hardcoding here.
-    _dset_id = H5Dcreate(_file_id, DSET_NAME, H5T_IEEE_F64BE, _dspace_id, H5P_DEFAULT, chunk_prop, H5P_DEFAULT);
+    const hid_t file_type = (vectors ? h5_file_vector_type<vector_type>() : h5_file_type<numeric_type>());
+    dataset.dset_id = H5Dcreate(_file_id, name, file_type, dspace_id, H5P_DEFAULT, chunk_prop, H5P_DEFAULT);
+    if(vectors){
+        H5Tclose(file_type);
+    }
+    H5Pclose(chunk_prop);
+    H5Sclose(dspace_id);
 
-    // dataspace that will be used for writing star systems to disk one by one.
-    // The chunk size corresponds to a single star system.
-    _mem_write_space_id = H5Screate_simple(2, _chunk_size, max_dims);
+    dataset.buffer.resize(_options.snapshots_per_write * dataset.row_size * dataset.numbers_per_element);
+    _datasets.push_back(std::move(dataset));
 }
 
-template <typename BodyType> StarSystemWriter<BodyType>::~StarSystemWriter(){
-    _status = H5Dclose(_dset_id);
-    _status = H5Sclose(_dspace_id);
-    _status = H5Sclose(_mem_write_space_id);
-    _status = H5Fclose(_file_id);
+
+template <typename BodyType> herr_t StarSystemWriter<BodyType>::write_star_system(const StarSystem<BodyType>& star_system, const numeric_type timestamp){
+    if(star_system.size() != _num_bodies){
+        throw std::length_error("The star system has " + std::to_string(star_system.size()) + " bodies, but the writer was made for " + std::to_string(_num_bodies) + " bodies.");
+    }
+
+    if(_options.layout == SnapshotLayout::rows){
+        numeric_type* row = _datasets[0].buffer.data() + _num_buffered * row_size();
+        const numeric_type* masses = star_system.masses().data();
+        for(std::size_t b{0}; b < _num_bodies; ++b){
+            numeric_type* body = row + b*numbers_per_body;
+            body[0] = masses[b];
+            for(std::size_t d{0}; d < dimension; ++d){
+                body[1 + d] = quantize(star_system.positions().data(d)[b], _position_quantum);
+                body[1 + dimension + d] = quantize(star_system.velocities().data(d)[b], _velocity_quantum);
+            }
+        }
+        row[row_size() - 1] = timestamp;
+    } else {
+        buffer_columns(star_system, timestamp);
+    }
+
+    ++_num_buffered;
+    if(_num_buffered == _options.snapshots_per_write){
+        return flush();
+    }
+    return 0;
 }
 
 
-template <typename BodyType> herr_t StarSystemWriter<BodyType>::write_star_system(const StarSystem<BodyType>& star_system, const typename BodyType::numeric_type timestamp){
+template <typename BodyType> void StarSystemWriter<BodyType>::buffer_columns(const StarSystem<BodyType>& star_system, const numeric_type timestamp){
+    const numeric_type* masses = star_system.masses().data();
+    if(_options.constant_masses){
+        if(_masses.empty()){
+            _masses.assign(masses, masses + _num_bodies);
+            _status = H5Dwrite(_masses_id, h5_memory_type<numeric_type>(), H5S_ALL, H5S_ALL, H5P_DEFAULT, _masses.data());
+        } else if(!std::equal(_masses.begin(), _masses.end(), masses)){
+            throw std::invalid_argument("The masses of the star system changed, but the writer stores them only once.");
+        }
+    } else {
+        std::copy(masses, masses + _num_bodies, _datasets[3].buffer.data() + _num_buffered * _num_bodies);
+    }
 
-    const std::size_t write_size = (_num_bodies*7 + 1);
-    typename BodyType::numeric_type write_array[write_size];
-    std::size_t write_index = 0;
-    for(const auto& body: star_system){
-        write_array[write_index] = body.mass();
-        write_array[write_index + 1] = body.position().x();
-        write_array[write_index + 2] = body.position().y();
-        write_array[write_index + 3] = body.position().z();
-        write_array[write_index + 4] = body.velocity().x();
-        write_array[write_index + 5] = body.velocity().y();
-        write_array[write_index + 6] = body.velocity().z();
-        write_index += 7;
+    // The vectors are gathered from the component arrays.
+    numeric_type* positions = _datasets[0].buffer.data() + _num_buffered * _num_bodies * dimension;
+    numeric_type* velocities = _datasets[1].buffer.data() + _num_buffered * _num_bodies * dimension;
+    for(std::size_t d{0}; d < dimension; ++d){
+        const numeric_type* position_components = star_system.positions().data(d);
+        const numeric_type* velocity_components = star_system.velocities().data(d);
+        for(std::size_t b{0}; b < _num_bodies; ++b){
+            positions[b*dimension + d] = quantize(position_components[b], _position_quantum);
+            velocities[b*dimension + d] = quantize(velocity_components[b], _velocity_quantum);
+        }
     }
-    write_array[write_size - 1] = timestamp;
+    _datasets[2].buffer[_num_buffered] = timestamp;
+}
 
-    hsize_t dataset_offset[2] = {_current_dims[0], 0};
-    _current_dims[0] += 1;
-    _status = H5Dset_extent(_dset_id, _current_dims);
 
-    // TODO: Check if this line can be simplified.
-    hid_t file_space = H5Dget_space(_dset_id);
+template <typename BodyType> herr_t StarSystemWriter<BodyType>::flush(){
+    if(_num_buffered == 0){
+        return 0;
+    }
 
-    // After this call file_space refers to a certain hyperslab in the file.
-    _status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, dataset_offset, NULL, _chunk_size, NULL);
+    // Every dataset grows by all buffered snapshots at once, and they are written as a single
+    // hyperslab.
+    for(SnapshotDataset& dataset: _datasets){
+        const hsize_t dataset_offset[2] = {_num_written, 0};
+        const hsize_t write_size[2] = {_num_buffered, dataset.row_size};
+        const hsize_t new_dims[2] = {_num_written + _num_buffered, dataset.row_size};
+        _status = H5Dset_extent(dataset.dset_id, new_dims);
 
-    // TODO: Fix type hardcoding here.
-    _status = H5Dwrite(_dset_id, H5T_NATIVE_DOUBLE, _mem_write_space_id, file_space, H5P_DEFAULT, write_array);
+        hid_t file_space = H5Dget_space(dataset.dset_id);
+        _status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, dataset_offset, NULL, write_size, NULL);
+        hid_t mem_space = H5Screate_simple(dataset.rank, write_size, NULL);
+        _status = H5Dwrite(dataset.dset_id, dataset.memory_type, mem_space, file_space, H5P_DEFAULT, dataset.buffer.data());
+        H5Sclose(mem_space);
+        H5Sclose(file_space);
+    }
 
+    _num_written += _num_buffered;
+    _num_buffered = 0;
     return _status;
 }
+
+
+template <typename BodyType> typename StarSystemWriter<BodyType>::numeric_type StarSystemWriter<BodyType>::quantum(const double error){
+    if(error == 0.){
+        return numeric_type(0);
+    }
+    // Rounding to a multiple of the quantum is off by at most half the quantum.
+    return static_cast<numeric_type>(std::exp2(std::floor(std::log2(2.*error))));
+}
+
+
+template <typename BodyType> typename StarSystemWriter<BodyType>::numeric_type StarSystemWriter<BodyType>::quantize(const numeric_type value, const numeric_type quantum){
+    if(quantum == numeric_type(0)){
+        return value;
+    }
+    // The quantum is a power of two, so the division and multiplication are exact.
+    return std::nearbyint(value / quantum) * quantum;
+}
+
+
+template <typename BodyType> void StarSystemWriter<BodyType>::check_filter(const H5Z_filter_t filter, const std::string& name){
+    unsigned int filter_info = 0;
+    if(H5Zfilter_avail(filter) <= 0 || H5Zget_filter_info(filter, &filter_info) < 0 || !(filter_info & H5Z_FILTER_CONFIG_ENCODE_ENABLED)){
+        throw std::runtime_error("The HDF5 library cannot write with the " + name + " filter.");
+    }
+}
 #endif
@@ -0,0 +1,224 @@
+// Writer for small time series, such as reductions of a star system computed during a simulation.
+// Every series is a group in the HDF5 file, holding the steps and times of its entries and a two
+// dimensional dataset with a row of values per entry:
+//
+//     /<name>/steps     step counter of every entry
+//     /<name>/times     simulation time of every entry
+//     /<name>/values    one row per entry, one column per quantity
+//
+// The names of the quantities are stored in the "columns" attribute of the values. Entries are
+// buffered and appended to the datasets every rows_per_write entries of a series, and when the
+// writer is flushed or destroyed.
+#ifndef TimeSeriesWriter_H
+#define TimeSeriesWriter_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "hdf5.h"
+
+constexpr char const* TIME_SERIES_STEPS_DSET_NAME = "steps";
+constexpr char const* TIME_SERIES_TIMES_DSET_NAME = "times";
+constexpr char const* TIME_SERIES_VALUES_DSET_NAME = "values";
+constexpr char const* TIME_SERIES_COLUMNS_ATTRIBUTE_NAME = "columns";
+
+
+class TimeSeriesWriter{
+    public:
+        explicit TimeSeriesWriter(const std::string& output_path, const std::size_t rows_per_write = 64);
+
+        TimeSeriesWriter(const TimeSeriesWriter&) = delete;
+        TimeSeriesWriter(TimeSeriesWriter&&) = delete;
+        TimeSeriesWriter& operator=(const TimeSeriesWriter&) = delete;
+        TimeSeriesWriter& operator=(TimeSeriesWriter&&) = delete;
+
+        ~TimeSeriesWriter();
+
+        herr_t h5_status() const{ return _status; }
+        std::size_t num_series() const{ return _series.size(); }
+
+        // Create a series with the given quantities and return its index.
+        std::size_t add_series(const std::string& name, const std::vector<std::string>& columns);
+
+        // Append an entry to a series, with a value for each of its columns.
+        herr_t append(const std::size_t series, const std::uint64_t step, const double time, const double* values);
+
+        // Whether the next entry appended to a series is written to the file, instead of only
+        // being buffered.
+        bool append_writes(const std::size_t series) const{ return _series.at(series).steps.size() + 1 >= _rows_per_write; }
+
+        // Write the buffered entries of all series.
+        herr_t flush();
+
+    private:
+        struct Series{
+            hid_t group_id;
+            hid_t steps_id;
+            hid_t times_id;
+            hid_t values_id;
+            std::size_t num_columns;
+            std::size_t num_written = 0;
+
+            std::vector<std::uint64_t> steps;
+            std::vector<double> times;
+            std::vector<double> values;
+        };
+
+        hid_t _file_id;
+        herr_t _status = 0;
+        std::size_t _rows_per_write;
+        std::vector<Series> _series;
+
+        hid_t create_dataset(const hid_t group_id, const char* name, const hid_t file_type, const std::size_t num_columns);
+        herr_t append_rows(const hid_t dset_id, const hid_t memory_type, const std::size_t num_written, const std::size_t num_rows, const std::size_t num_columns, const void* buffer);
+        herr_t flush(Series& series);
+};
+
+
+inline TimeSeriesWriter::TimeSeriesWriter(const std::string& output_path, const std::size_t rows_per_write):
+    _rows_per_write(rows_per_write)
+{
+    if(rows_per_write == 0){
+        throw std::invalid_argument("The number of rows per write must be positive.");
+    }
+    _file_id = H5Fcreate(output_path.c_str(), H5F_ACC_TRUNC, H5P_DEFAULT, H5P_DEFAULT);
+    if(_file_id < 0){
+        throw std::runtime_error("Could not create " + output_path + ".");
+    }
+}
+
+
+inline TimeSeriesWriter::~TimeSeriesWriter(){
+    flush();
+    for(Series& series: _series){
+        _status = H5Dclose(series.steps_id);
+        _status = H5Dclose(series.times_id);
+        _status = H5Dclose(series.values_id);
+        _status = H5Gclose(series.group_id);
+    }
+    _status = H5Fclose(_file_id);
+}
+
+
+inline std::size_t TimeSeriesWriter::add_series(const std::string& name, const std::vector<std::string>& columns){
+    if(columns.empty()){
+        throw std::invalid_argument("The time series " + name + " needs at least one column.");
+    }
+    Series series;
+    series.num_columns = columns.size();
+    series.group_id = H5Gcreate(_file_id, name.c_str(), H5P_DEFAULT, H5P_DEFAULT, H5P_DEFAULT);
+    if(series.group_id < 0){
+        throw std::invalid_argument("Could not create the time series " + name + ", is the name used twice?");
+    }
+    series.steps_id = create_dataset(series.group_id, TIME_SERIES_STEPS_DSET_NAME, H5T_STD_U64LE, 0);
+    series.times_id = create_dataset(series.group_id, TIME_SERIES_TIMES_DSET_NAME, H5T_IEEE_F64LE, 0);
+    series.values_id = create_dataset(series.group_id, TIME_SERIES_VALUES_DSET_NAME, H5T_IEEE_F64LE, columns.size());
+
+    // The column names are stored as fixed length strings.
+    std::size_t name_size = 1;
+    for(const std::string& column: columns){
+        name_size = std::max(name_size, column.size());
+    }
+    std::vector<char> names(columns.size() * name_size, '\0');
+    for(std::size_t c{0}; c < columns.size(); ++c){
+        std::copy(columns[c].begin(), columns[c].end(), names.begin() + c * name_size);
+    }
+    hid_t string_type = H5Tcopy(H5T_C_S1);
+    _status = H5Tset_size(string_type, name_size);
+    _status = H5Tset_strpad(string_type, H5T_STR_NULLPAD);
+    const hsize_t dims[1] = {columns.size()};
+    hid_t attribute_space = H5Screate_simple(1, dims, NULL);
+    hid_t attribute_id = H5Acreate(series.values_id, TIME_SERIES_COLUMNS_ATTRIBUTE_NAME, string_type, attribute_space, H5P_DEFAULT, H5P_DEFAULT);
+    _status = H5Awrite(attribute_id, string_type, names.data());
+    H5Aclose(attribute_id);
+    H5Sclose(attribute_space);
+    H5Tclose(string_type);
+
+    series.steps.reserve(_rows_per_write);
+    series.times.reserve(_rows_per_write);
+    series.values.reserve(_rows_per_write * series.num_columns);
+    _series.push_back(std::move(series));
+    return _series.size() - 1;
+}
+
+
+inline herr_t TimeSeriesWriter::append(const std::size_t series_index, const std::uint64_t step, const double time, const double* values){
+    Series& series = _series.at(series_index);
+    series.steps.push_back(step);
+    series.times.push_back(time);
+    series.values.insert(series.values.end(), values, values + series.num_columns);
+    if(series.steps.size() >= _rows_per_write){
+        return flush(series);
+    }
+    return _status;
+}
+
+
+inline herr_t TimeSeriesWriter::flush(){
+    for(Series& series: _series){
+        flush(series);
+    }
+    _status = H5Fflush(_file_id, H5F_SCOPE_LOCAL);
+    return _status;
+}
+
+
+inline herr_t TimeSeriesWriter::flush(Series& series){
+    const std::size_t num_rows = series.steps.size();
+    if(num_rows == 0){
+        return _status;
+    }
+    append_rows(series.steps_id, H5T_NATIVE_UINT64, series.num_written, num_rows, 0, series.steps.data());
+    append_rows(series.times_id, H5T_NATIVE_DOUBLE, series.num_written, num_rows, 0, series.times.data());
+    append_rows(series.values_id, H5T_NATIVE_DOUBLE, series.num_written, num_rows, series.num_columns, series.values.data());
+    series.num_written += num_rows;
+    series.steps.clear();
+    series.times.clear();
+    series.values.clear();
+    return _status;
+}
+
+
+// A dataset with an unlimited number of rows, one dimensional if it has no columns.
+inline hid_t TimeSeriesWriter::create_dataset(const hid_t group_id, const char* name, const hid_t file_type, const std::size_t num_columns){
+    const int rank = (num_columns == 0 ? 1 : 2);
+    const hsize_t current_dims[2] = {0, num_columns};
+    const hsize_t max_dims[2] = {H5S_UNLIMITED, num_columns};
+    const hsize_t chunk_size[2] = {_rows_per_write, num_columns};
+    hid_t dspace_id = H5Screate_simple(rank, current_dims, max_dims);
+    hid_t chunk_prop = H5Pcreate(H5P_DATASET_CREATE);
+    _status = H5Pset_chunk(chunk_prop, rank, chunk_size);
+    hid_t dset_id = H5Dcreate(group_id, name, file_type, dspace_id, H5P_DEFAULT, chunk_prop, H5P_DEFAULT);
+    H5Pclose(chunk_prop);
+    H5Sclose(dspace_id);
+    return dset_id;
+}
+
+
+inline herr_t TimeSeriesWriter::append_rows(
+    const hid_t dset_id,
+    const hid_t memory_type,
+    const std::size_t num_written,
+    const std::size_t num_rows,
+    const std::size_t num_columns,
+    const void* buffer)
+{
+    const int rank = (num_columns == 0 ? 1 : 2);
+    const hsize_t dataset_offset[2] = {num_written, 0};
+    const hsize_t write_size[2] = {num_rows, num_columns};
+    const hsize_t new_dims[2] = {num_written + num_rows, num_columns};
+    _status = H5Dset_extent(dset_id, new_dims);
+
+    hid_t file_space = H5Dget_space(dset_id);
+    _status = H5Sselect_hyperslab(file_space, H5S_SELECT_SET, dataset_offset, NULL, write_size, NULL);
+    hid_t mem_space = H5Screate_simple(rank, write_size, NULL);
+    _status = H5Dwrite(dset_id, memory_type, mem_space, file_space, H5P_DEFAULT, buffer);
+    H5Sclose(mem_space);
+    H5Sclose(file_space);
+    return _status;
+}
+
+#endif
@@ -0,0 +1,148 @@
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/async_star_system_writer.h"
+#include "../include/star_system_reader.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+using star_system_type = StarSystem<body_type>;
+
+
+// Read the file and compare it with the snapshots that were written.
+void check_file(const std::string& file_name, const std::vector<star_system_type>& snapshots){
+    StarSystemReader<body_type> reader(file_name);
+    if(reader.num_timestamps() != snapshots.size()){
+        throw std::runtime_error("The file holds " + std::to_string(reader.num_timestamps()) + " snapshots instead of " + std::to_string(snapshots.size()) + ".\n");
+    }
+    for(std::size_t t{0}; t < snapshots.size(); ++t){
+        const auto time_and_star_system = reader.at(t);
+        if(time_and_star_system.first != static_cast<numeric_type>(t) || !all_close(time_and_star_system.second, snapshots[t])){
+            throw std::runtime_error("Snapshot " + std::to_string(t) + " read from the file differs from the one written.\n");
+        }
+    }
+}
+
+
+// Write snapshots through the asynchronous writer, changing the star system right after every
+// write, so that the writer has to hold on to its own copy of the state.
+void check_write_read(const std::size_t num_staging_buffers){
+    constexpr std::size_t num_bodies = 10;
+    constexpr std::size_t num_snapshots = 53;
+    const std::string file_name = "test_async_write.h5";
+
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vel, uniform(random_device));
+    }
+    star_system_type star_system(bodies);
+
+    StarSystemWriterOptions options;
+    options.snapshots_per_write = 8;
+    options.chunk_snapshots = 8;
+
+    std::vector<star_system_type> snapshots;
+    {
+        AsyncStarSystemWriter<body_type> writer(num_bodies, file_name, options, num_staging_buffers);
+        for(std::size_t t{0}; t < num_snapshots; ++t){
+            snapshots.push_back(star_system);
+            writer.write_star_system(star_system, static_cast<numeric_type>(t));
+            for(std::size_t b{0}; b < num_bodies; ++b){
+                star_system.updatePosition(b, star_system.velocity(b));
+                star_system.updateVelocity(b, vector_type(0.1, -0.1, 0.2));
+            }
+
+            // After a flush everything written so far is in the file, even though the buffer of
+            // the underlying writer is not full.
+            if(t == 20){
+                writer.flush();
+                check_file(file_name, snapshots);
+            }
+        }
+
+        bool threw = false;
+        try{
+            writer.write_star_system(star_system_type(std::vector<body_type>(num_bodies + 1)), 0.);
+        } catch(const std::length_error&){
+            threw = true;
+        }
+        if(!threw){
+            throw std::runtime_error("Writing a star system of the wrong size did not throw.\n");
+        }
+    }
+
+    // The destructor has to drain the queue and write the remaining snapshots.
+    check_file(file_name, snapshots);
+    std::remove(file_name.c_str());
+    std::cout << "Checked " << num_snapshots << " snapshots with " << num_staging_buffers << " staging buffers." << std::endl;
+}
+
+
+// Invalid arguments are rejected before the file is created, and errors of the I/O thread are
+// rethrown on the thread that uses the writer.
+void check_errors(){
+    constexpr std::size_t num_bodies = 10;
+    const std::string file_name = "test_async_write_errors.h5";
+    std::remove(file_name.c_str());
+
+    bool threw = false;
+    try{
+        AsyncStarSystemWriter<body_type> writer(num_bodies, file_name, StarSystemWriterOptions(), 0);
+    } catch(const std::invalid_argument&){
+        threw = true;
+    }
+    if(!threw){
+        throw std::runtime_error("A writer without staging buffers was accepted.\n");
+    }
+    if(std::ifstream(file_name)){
+        throw std::runtime_error("A writer without staging buffers created its file.\n");
+    }
+
+    // The columnar layout stores the masses once, so the I/O thread throws when they change.
+    StarSystemWriterOptions options;
+    options.layout = SnapshotLayout::columns;
+    star_system_type star_system(std::vector<body_type>(num_bodies, body_type(vector_type(1., 2., 3.), vector_type(4., 5., 6.), 1.)));
+    {
+        AsyncStarSystemWriter<body_type> writer(num_bodies, file_name, options);
+        writer.write_star_system(star_system, 0.);
+        star_system.masses()[0] = 2.;
+        writer.write_star_system(star_system, 1.);
+        threw = false;
+        try{
+            writer.flush();
+        } catch(const std::invalid_argument&){
+            threw = true;
+        }
+        if(!threw){
+            throw std::runtime_error("An error of the I/O thread was not rethrown by flush.\n");
+        }
+
+        // The error is only reported once, and the writer keeps writing.
+        star_system.masses()[0] = 1.;
+        writer.write_star_system(star_system, 2.);
+        writer.flush();
+    }
+    std::remove(file_name.c_str());
+    std::cout << "Checked the errors of the asynchronous writer." << std::endl;
+}
+
+
+int main(){
+    check_write_read(1);
+    check_write_read(2);
+    check_write_read(4);
+    check_errors();
+}
@@ -0,0 +1,142 @@
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/star_system_reader.h"
+#include "../include/star_system_writer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+using star_system_type = StarSystem<body_type>;
+
+
+// Write snapshots with the given options and read them back. The number of snapshots is not a
+// multiple of the number of snapshots per write, so the destructor has to write the last ones.
+void check_write_read(const StarSystemWriterOptions& options){
+    constexpr std::size_t num_bodies = 10;
+    constexpr std::size_t num_snapshots = 37;
+    const std::string file_name = "test_batched_write.h5";
+
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vel, uniform(random_device));
+    }
+    star_system_type star_system(bodies);
+
+    std::vector<star_system_type> snapshots;
+    {
+        StarSystemWriter<body_type> writer(num_bodies, file_name, options);
+        for(std::size_t t{0}; t < num_snapshots; ++t){
+            for(std::size_t b{0}; b < num_bodies; ++b){
+                star_system.updatePosition(b, star_system.velocity(b));
+                star_system.updateVelocity(b, vector_type(0.1, -0.1, 0.2));
+            }
+            snapshots.push_back(star_system);
+            writer.write_star_system(star_system, static_cast<numeric_type>(t));
+            if(writer.num_buffered() != (t + 1) % options.snapshots_per_write){
+                throw std::runtime_error("The writer did not write its buffer once it was full.\n");
+            }
+        }
+    }
+
+    // The chunk shape should be the requested one.
+    hid_t file_id = H5Fopen(file_name.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    hid_t dset_id = H5Dopen(file_id, DSET_NAME, H5P_DEFAULT);
+    hid_t chunk_prop = H5Dget_create_plist(dset_id);
+    hsize_t chunk_size[2];
+    H5Pget_chunk(chunk_prop, 2, chunk_size);
+    H5Pclose(chunk_prop);
+    H5Dclose(dset_id);
+    H5Fclose(file_id);
+    // The chunks hold whole bodies, at least as many as requested, or complete rows. The timestamp
+    // shares the last chunk of bodies.
+    const std::size_t row_size = 7 * num_bodies + 1;
+    const std::size_t chunk_bodies = (options.chunk_bodies == 0 ? num_bodies : options.chunk_bodies);
+    if(chunk_size[0] != options.chunk_snapshots || (chunk_size[1] % 7 != 0 && chunk_size[1] != row_size) || chunk_size[1] < 7 * chunk_bodies){
+        throw std::runtime_error("The chunks of the dataset do not have the requested shape.\n");
+    }
+    if((row_size + chunk_size[1] - 1) / chunk_size[1] != (row_size - 1 + chunk_size[1] - 1) / chunk_size[1]){
+        throw std::runtime_error("The timestamp is stored in a chunk of its own.\n");
+    }
+
+    {
+        StarSystemReader<body_type> reader(file_name);
+        if(reader.num_timestamps() != num_snapshots){
+            throw std::runtime_error("The file holds " + std::to_string(reader.num_timestamps()) + " snapshots instead of " + std::to_string(num_snapshots) + ".\n");
+        }
+        for(std::size_t t{0}; t < num_snapshots; ++t){
+            const auto time_and_star_system = reader.at(t);
+            if(time_and_star_system.first != static_cast<numeric_type>(t) || !all_close(time_and_star_system.second, snapshots[t])){
+                throw std::runtime_error("Snapshot " + std::to_string(t) + " read from the file differs from the one written.\n");
+            }
+        }
+    }
+    std::remove(file_name.c_str());
+    std::cout << "Checked " << options.snapshots_per_write << " snapshots per write with chunks of " << options.chunk_snapshots << " snapshots and " << chunk_bodies << " bodies." << std::endl;
+}
+
+
+// Without compression the file should hardly be larger than the numbers it holds. A timestamp in
+// a chunk of its own would double the size of the file.
+void check_file_size(const StarSystemWriterOptions& options){
+    constexpr std::size_t num_bodies = 1000;
+    constexpr std::size_t num_snapshots = 64;
+    const std::string file_name = "test_batched_write_size.h5";
+
+    std::vector<body_type> bodies(num_bodies, body_type(vector_type(1., 2., 3.), vector_type(4., 5., 6.), 1.));
+    star_system_type star_system(bodies);
+    {
+        StarSystemWriter<body_type> writer(num_bodies, file_name, options);
+        for(std::size_t t{0}; t < num_snapshots; ++t){
+            writer.write_star_system(star_system, static_cast<numeric_type>(t));
+        }
+    }
+    hid_t file_id = H5Fopen(file_name.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    hsize_t file_size;
+    H5Fget_filesize(file_id, &file_size);
+    H5Fclose(file_id);
+    std::remove(file_name.c_str());
+
+    const std::size_t data_size = num_snapshots * (7 * num_bodies + 1) * sizeof(numeric_type);
+    if(file_size > data_size + data_size / 20){
+        throw std::runtime_error("The file of " + std::to_string(data_size) + " bytes of snapshots has " + std::to_string(file_size) + " bytes.\n");
+    }
+}
+
+
+int main(){
+    StarSystemWriterOptions options;
+    check_write_read(options);
+
+    // One snapshot per write, as before the writer buffered.
+    options.snapshots_per_write = 1;
+    options.chunk_snapshots = 1;
+    check_write_read(options);
+
+    // Chunks along the body axis, which do not divide the number of bodies.
+    options.snapshots_per_write = 8;
+    options.chunk_snapshots = 4;
+    options.chunk_bodies = 3;
+    check_write_read(options);
+
+    // Chunks along the body axis that divide the number of bodies.
+    options.chunk_bodies = 5;
+    check_write_read(options);
+
+    // The size of the file, with chunks of all bodies and with chunks that divide the bodies.
+    options = StarSystemWriterOptions();
+    check_file_size(options);
+    options.chunk_bodies = 100;
+    check_file_size(options);
+}
@@ -0,0 +1,237 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/async_checkpoint_writer.h"
+#include "../include/checkpoint.h"
+#include "../../body/include/checkpoint_state.h"
+#include "../../integration/include/block_time_step.h"
+#include "../../integration/include/dormand_prince.h"
+#include "../../integration/include/leapfrog.h"
+#include "../../integration/include/runge_kutta_four.h"
+#include "../../force/include/direct_sum_force_computer.h"
+#include "../../force/include/particle_mesh_force_computer.h"
+#include "../../force/include/softening_kernel.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+
+constexpr numeric_type softening_length = 1e-2;
+constexpr numeric_type time_step = 0.01;
+const std::string checkpoint_path = "test_checkpoint.ckp";
+
+
+StarSystem<body_type> make_cluster(const std::size_t num_bodies){
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(-1., 1.);
+    std::vector<body_type> bodies;
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = 0.3 * vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies.push_back(body_type(pos, vel, 1. / num_bodies));
+    }
+    return StarSystem<body_type>(bodies);
+}
+
+
+// Softened force computer that counts how often the forces are computed.
+template<typename ForceComputerType> class Counting: public ForceComputerType{
+
+    public:
+        template<typename... Args> Counting(const Args... args): ForceComputerType(1., args...){
+            this->setSoftening(SofteningKernel<numeric_type>::plummer(softening_length));
+        }
+        std::size_t numEvaluations() const{ return _num_evaluations; }
+
+    protected:
+        virtual void computeForcesImpl(const StarSystem<body_type>& star_system) override{
+            ++_num_evaluations;
+            ForceComputerType::computeForcesImpl(star_system);
+        }
+
+        virtual void computeForcesAndPotentialImpl(const StarSystem<body_type>& star_system) override{
+            ++_num_evaluations;
+            ForceComputerType::computeForcesAndPotentialImpl(star_system);
+        }
+
+        virtual void computeSubsetForcesImpl(const StarSystem<body_type>& star_system, const std::vector<std::size_t>& active_bodies) override{
+            ++_num_evaluations;
+            ForceComputerType::computeSubsetForcesImpl(star_system, active_bodies);
+        }
+
+    private:
+        std::size_t _num_evaluations = 0;
+};
+
+using CountingForceComputer = Counting<DirectSumForceComputer<body_type>>;
+
+// The particle-mesh grid is kept between force computations, so it is part of the state.
+class CountingParticleMesh: public Counting<ParticleMeshForceComputer<body_type>>{
+    public:
+        CountingParticleMesh(): Counting<ParticleMeshForceComputer<body_type>>(std::size_t{16}){}
+};
+
+
+bool identical(const numeric_type* lhs, const numeric_type* rhs, const std::size_t size){
+    return std::memcmp(lhs, rhs, size * sizeof(numeric_type)) == 0;
+}
+
+
+// Run 2 num_steps steps at once, and num_steps steps followed by a checkpoint and num_steps steps
+// of a simulation resumed from it with a new star system, integrator and force computer. Both
+// runs should end bit for bit in the same state. Returns the number of force computations of the
+// resumed run.
+template<typename IntegratorType, typename ForceComputerType = CountingForceComputer> std::size_t check_resume(const std::string& name, const std::function<IntegratorType()>& make_integrator, const std::size_t num_steps){
+    StarSystem<body_type> reference = make_cluster(128);
+    IntegratorType reference_integrator = make_integrator();
+    ForceComputerType reference_force_computer;
+    for(std::size_t i{0}; i < 2 * num_steps; ++i){
+        reference_integrator.timeStep(reference, reference_force_computer, time_step);
+    }
+
+    numeric_type checkpoint_potential;
+    {
+        StarSystem<body_type> star_system = make_cluster(128);
+        IntegratorType integrator = make_integrator();
+        ForceComputerType force_computer;
+        for(std::size_t i{0}; i < num_steps; ++i){
+            integrator.timeStep(star_system, force_computer, time_step);
+        }
+        AsyncCheckpointWriter<body_type> writer;
+        writer.write_checkpoint(checkpoint_path, star_system, integrator, force_computer, num_steps, num_steps * time_step);
+        writer.flush();
+        checkpoint_potential = force_computer.potentialEnergy();
+    }
+
+    CheckpointState state;
+    read_checkpoint(checkpoint_path, state);
+    StarSystem<body_type> star_system(0);
+    IntegratorType integrator = make_integrator();
+    ForceComputerType force_computer;
+    std::uint64_t step;
+    double time;
+    load_checkpoint(state, star_system, integrator, force_computer, step, time);
+    if(step != num_steps || time != num_steps * time_step){
+        throw std::runtime_error(name + ": the checkpoint was made at step " + std::to_string(num_steps) + ", but step " + std::to_string(step) + " was loaded.\n");
+    }
+    if(force_computer.potentialEnergy() != checkpoint_potential){
+        throw std::runtime_error(name + ": the potential energy of the last force computation was not restored.\n");
+    }
+    for(std::size_t i{0}; i < num_steps; ++i){
+        integrator.timeStep(star_system, force_computer, time_step);
+    }
+
+    for(std::size_t d{0}; d < 3; ++d){
+        if(!identical(star_system.positions().data(d), reference.positions().data(d), reference.size())
+            || !identical(star_system.velocities().data(d), reference.velocities().data(d), reference.size()))
+        {
+            throw std::runtime_error(name + ": the resumed simulation differs from the uninterrupted one.\n");
+        }
+    }
+    if(force_computer.potentialEnergy() != reference_force_computer.potentialEnergy()){
+        throw std::runtime_error(name + ": the potential energy of the resumed simulation differs from the uninterrupted one.\n");
+    }
+    std::cout << name << ": resumed bit for bit with " << force_computer.numEvaluations() << " force computations for " << num_steps << " steps" << std::endl;
+    return force_computer.numEvaluations();
+}
+
+
+template<typename ExceptionType> void check_throws(const std::string& description, const std::function<void()>& function){
+    try{
+        function();
+    } catch(const ExceptionType&){
+        return;
+    }
+    throw std::runtime_error("Loading " + description + " did not throw.\n");
+}
+
+
+void check_errors(){
+    StarSystem<body_type> star_system = make_cluster(16);
+    Leapfrog<body_type> integrator;
+    CountingForceComputer force_computer;
+    integrator.timeStep(star_system, force_computer, time_step);
+    CheckpointState state;
+    save_checkpoint(state, star_system, integrator, force_computer, 1, time_step);
+    write_checkpoint(checkpoint_path, state);
+
+    // Bodies with a different precision.
+    using float_body_type = Body<Vector3D<float>>;
+    StarSystem<float_body_type> float_star_system(0);
+    check_throws<std::invalid_argument>("single precision bodies", [&]{ load_star_system(state, float_star_system); });
+
+    // A state without the records of the integrator.
+    CheckpointState star_system_state;
+    save_star_system(star_system_state, star_system);
+    check_throws<std::out_of_range>("a checkpoint without integrator state", [&]{ integrator.loadState(star_system_state); });
+
+    // A truncated file.
+    std::ifstream file(checkpoint_path, std::ios::binary | std::ios::ate);
+    const std::size_t file_size = static_cast<std::size_t>(file.tellg());
+    std::vector<char> bytes(file_size);
+    file.seekg(0);
+    file.read(bytes.data(), file_size);
+    std::ofstream truncated(checkpoint_path, std::ios::binary | std::ios::trunc);
+    truncated.write(bytes.data(), file_size / 2);
+    truncated.close();
+    CheckpointState read_state;
+    check_throws<std::length_error>("a truncated file", [&]{ read_checkpoint(checkpoint_path, read_state); });
+}
+
+
+// Time the step loop is stalled by an asynchronous checkpoint of a large star system, compared
+// to writing the checkpoint synchronously.
+void time_checkpoint(){
+    constexpr std::size_t num_bodies = 1000000;
+    StarSystem<body_type> star_system = make_cluster(num_bodies);
+    RungeKuttaFour<body_type> integrator;
+    DirectSumForceComputer<body_type> force_computer(1.);
+
+    auto start = std::chrono::steady_clock::now();
+    CheckpointState state;
+    save_checkpoint(state, star_system, integrator, force_computer, 0, 0.);
+    write_checkpoint(checkpoint_path, state);
+    auto end = std::chrono::steady_clock::now();
+    const double synchronous_ms = std::chrono::duration<double, std::milli>(end - start).count();
+
+    AsyncCheckpointWriter<body_type> writer;
+    writer.write_checkpoint(checkpoint_path, star_system, integrator, force_computer, 0, 0.);
+    writer.flush();
+    start = std::chrono::steady_clock::now();
+    writer.write_checkpoint(checkpoint_path, star_system, integrator, force_computer, 0, 0.);
+    end = std::chrono::steady_clock::now();
+    const double stall_ms = std::chrono::duration<double, std::milli>(end - start).count();
+    writer.flush();
+
+    std::cout << "Checkpoint of " << num_bodies << " bodies: " << synchronous_ms << " ms synchronously, step loop stalled for " << stall_ms << " ms asynchronously" << std::endl;
+}
+
+
+int main(){
+    const std::size_t leapfrog_evaluations = check_resume<Leapfrog<body_type>>("Leapfrog", []{ return Leapfrog<body_type>(); }, 10);
+    check_resume<DormandPrince<body_type>>("Dormand-Prince", []{ return DormandPrince<body_type>(1e-8, 1e-8); }, 5);
+    check_resume<BlockTimeStep<body_type>>("Block time steps", []{ return BlockTimeStep<body_type>(0.01, 0., 4); }, 5);
+    check_resume<RungeKuttaFour<body_type>>("Runge-Kutta 4", []{ return RungeKuttaFour<body_type>(); }, 5);
+    check_resume<Leapfrog<body_type>, CountingParticleMesh>("Leapfrog with particle-mesh forces", []{ return Leapfrog<body_type>(); }, 10);
+
+    // The accelerations of the last step are restored, so every step costs one force computation.
+    if(leapfrog_evaluations != 10){
+        throw std::runtime_error("The resumed leapfrog integrator recomputed the accelerations at the checkpoint.\n");
+    }
+
+    check_errors();
+    time_checkpoint();
+    std::remove(checkpoint_path.c_str());
+}
@@ -0,0 +1,139 @@
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/star_system_reader.h"
+#include "../include/star_system_writer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+using star_system_type = StarSystem<body_type>;
+
+
+// Write snapshots with the given options and check every way of reading them back. The masses
+// change between snapshots unless they are constant.
+void check_write_read(const StarSystemWriterOptions& options){
+    constexpr std::size_t num_bodies = 11;
+    constexpr std::size_t num_snapshots = 37;
+    const std::string file_name = "test_columnar_layout.h5";
+    const bool constant_masses = (options.layout == SnapshotLayout::columns && options.constant_masses);
+
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vel, uniform(random_device));
+    }
+
+    std::vector<star_system_type> snapshots;
+    {
+        StarSystemWriter<body_type> writer(num_bodies, file_name, options);
+        for(std::size_t t{0}; t < num_snapshots; ++t){
+            for(std::size_t b{0}; b < num_bodies; ++b){
+                const numeric_type mass = (constant_masses ? bodies[b].mass() : bodies[b].mass() + 1.);
+                bodies[b] = body_type(bodies[b].position() + bodies[b].velocity(), bodies[b].velocity() + vector_type(0.1, -0.1, 0.2), mass);
+            }
+            snapshots.push_back(star_system_type(bodies));
+            writer.write_star_system(snapshots.back(), 0.25 * t);
+        }
+    }
+
+    {
+        StarSystemReader<body_type> reader(file_name);
+        if(reader.layout() != options.layout || reader.num_timestamps() != num_snapshots || reader.num_bodies() != num_bodies){
+            throw std::runtime_error("The reader did not detect the layout and size of the file.\n");
+        }
+
+        const std::vector<double> timestamps = reader.timestamps();
+        for(std::size_t t{0}; t < num_snapshots; ++t){
+            if(timestamps[t] != 0.25 * t || reader.timestamp(t) != 0.25 * t){
+                throw std::runtime_error("Timestamp " + std::to_string(t) + " read from the file differs from the one written.\n");
+            }
+            const auto time_and_star_system = reader.at(t);
+            if(time_and_star_system.first != 0.25 * t || !all_close(time_and_star_system.second, snapshots[t])){
+                throw std::runtime_error("Snapshot " + std::to_string(t) + " read from the file differs from the one written.\n");
+            }
+
+            const std::vector<double> masses = reader.masses(t);
+            const std::vector<vector_type> positions = reader.positions(t);
+            const std::vector<vector_type> velocities = reader.velocities(t);
+            for(std::size_t b{0}; b < num_bodies; ++b){
+                if(masses[b] != snapshots[t].mass(b) || !is_close(positions[b], snapshots[t].position(b)) || !is_close(velocities[b], snapshots[t].velocity(b))){
+                    throw std::runtime_error("A field of snapshot " + std::to_string(t) + " read from the file differs from the one written.\n");
+                }
+            }
+        }
+
+        for(std::size_t b{0}; b < num_bodies; b += 5){
+            const std::size_t first = 3;
+            const std::size_t last = 29;
+            const std::vector<body_type> trajectory = reader.trajectory(b, first, last);
+            if(trajectory.size() != last - first + 1){
+                throw std::runtime_error("The trajectory holds the wrong number of states.\n");
+            }
+            for(std::size_t t{first}; t <= last; ++t){
+                const body_type& state = trajectory[t - first];
+                if(state.mass() != snapshots[t].mass(b) || !is_close(state.position(), snapshots[t].position(b)) || !is_close(state.velocity(), snapshots[t].velocity(b))){
+                    throw std::runtime_error("The trajectory of body " + std::to_string(b) + " differs from the snapshots at time index " + std::to_string(t) + ".\n");
+                }
+            }
+        }
+
+        bool threw = false;
+        try{
+            reader.positions(num_snapshots);
+        } catch(const std::out_of_range&){
+            threw = true;
+        }
+        if(!threw){
+            throw std::runtime_error("Reading past the last snapshot did not throw.\n");
+        }
+    }
+    std::remove(file_name.c_str());
+    std::cout << "Checked the " << to_string(options.layout) << " layout" << (options.layout == SnapshotLayout::columns ? (constant_masses ? " with constant masses" : " with varying masses") : "") << " and chunks of " << options.chunk_bodies << " bodies." << std::endl;
+}
+
+
+int main(){
+    StarSystemWriterOptions options;
+    options.snapshots_per_write = 8;
+    options.chunk_snapshots = 8;
+    check_write_read(options);
+    options.chunk_bodies = 3;
+    check_write_read(options);
+
+    options.layout = SnapshotLayout::columns;
+    check_write_read(options);
+    options.chunk_bodies = 0;
+    check_write_read(options);
+    options.constant_masses = false;
+    check_write_read(options);
+
+    // Constant masses that change are an error.
+    options.constant_masses = true;
+    bool threw = false;
+    {
+        std::vector<body_type> bodies(2, body_type(vector_type(), vector_type(), 1.));
+        StarSystemWriter<body_type> writer(2, "test_columnar_layout.h5", options);
+        writer.write_star_system(star_system_type(bodies), 0.);
+        bodies[1] = body_type(vector_type(), vector_type(), 2.);
+        try{
+            writer.write_star_system(star_system_type(bodies), 1.);
+        } catch(const std::invalid_argument&){
+            threw = true;
+        }
+    }
+    std::remove("test_columnar_layout.h5");
+    if(!threw){
+        throw std::runtime_error("Changing masses that are stored once did not throw.\n");
+    }
+}
@@ -0,0 +1,152 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/star_system_reader.h"
+#include "../include/star_system_writer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+using star_system_type = StarSystem<body_type>;
+
+
+// Whether the HDF5 library can compress and decompress with the filter. Szip is optional, and
+// some builds only decode it.
+bool filter_round_trips(const H5Z_filter_t filter){
+    unsigned int filter_info = 0;
+    return H5Zfilter_avail(filter) > 0 && H5Zget_filter_info(filter, &filter_info) >= 0
+        && (filter_info & H5Z_FILTER_CONFIG_ENCODE_ENABLED) && (filter_info & H5Z_FILTER_CONFIG_DECODE_ENABLED);
+}
+
+
+// Number of bytes the dataset takes up in the file.
+hsize_t storage_size(const std::string& file_name){
+    hid_t file_id = H5Fopen(file_name.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    hid_t dset_id = H5Dopen(file_id, DSET_NAME, H5P_DEFAULT);
+    const hsize_t size = H5Dget_storage_size(dset_id);
+    H5Dclose(dset_id);
+    H5Fclose(file_id);
+    return size;
+}
+
+
+// Write snapshots of bodies on circular orbits with the given options, read them back and check
+// that the positions and velocities are within the error bounds and everything else is exact.
+// Returns the size of the dataset.
+hsize_t check_write_read(const StarSystemWriterOptions& options){
+    constexpr std::size_t num_bodies = 200;
+    constexpr std::size_t num_snapshots = 40;
+    const std::string file_name = "test_compressed_write.h5";
+
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 1.);
+    std::vector<numeric_type> radii(num_bodies);
+    std::vector<numeric_type> phases(num_bodies);
+    std::vector<numeric_type> heights(num_bodies);
+    std::vector<numeric_type> masses(num_bodies);
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        radii[b] = 1. + 99. * uniform(random_device);
+        phases[b] = 2. * M_PI * uniform(random_device);
+        heights[b] = uniform(random_device) - 0.5;
+        masses[b] = 1. + uniform(random_device);
+    }
+
+    std::vector<star_system_type> snapshots;
+    {
+        StarSystemWriter<body_type> writer(num_bodies, file_name, options);
+        std::vector<body_type> bodies(num_bodies);
+        for(std::size_t t{0}; t < num_snapshots; ++t){
+            for(std::size_t b{0}; b < num_bodies; ++b){
+                const numeric_type angle = phases[b] + 0.01 * t / std::sqrt(radii[b]);
+                const numeric_type speed = 1. / std::sqrt(radii[b]);
+                const vector_type pos(radii[b] * std::cos(angle), radii[b] * std::sin(angle), heights[b]);
+                const vector_type vel(-speed * std::sin(angle), speed * std::cos(angle), 0.);
+                bodies[b] = body_type(pos, vel, masses[b]);
+            }
+            snapshots.push_back(star_system_type(bodies));
+            writer.write_star_system(snapshots.back(), 0.5 * t);
+        }
+    }
+
+    {
+        StarSystemReader<body_type> reader(file_name);
+        if(reader.num_timestamps() != num_snapshots){
+            throw std::runtime_error("The file holds " + std::to_string(reader.num_timestamps()) + " snapshots instead of " + std::to_string(num_snapshots) + ".\n");
+        }
+        numeric_type max_position_error = 0.;
+        numeric_type max_velocity_error = 0.;
+        for(std::size_t t{0}; t < num_snapshots; ++t){
+            const auto time_and_star_system = reader.at(t);
+            const star_system_type& read = time_and_star_system.second;
+            if(time_and_star_system.first != 0.5 * t){
+                throw std::runtime_error("The timestamp of snapshot " + std::to_string(t) + " was not stored exactly.\n");
+            }
+            for(std::size_t b{0}; b < num_bodies; ++b){
+                if(read.mass(b) != snapshots[t].mass(b)){
+                    throw std::runtime_error("The mass of body " + std::to_string(b) + " was not stored exactly.\n");
+                }
+                for(std::size_t d{0}; d < 3; ++d){
+                    max_position_error = std::max(max_position_error, std::abs(read.positions().data(d)[b] - snapshots[t].positions().data(d)[b]));
+                    max_velocity_error = std::max(max_velocity_error, std::abs(read.velocities().data(d)[b] - snapshots[t].velocities().data(d)[b]));
+                }
+            }
+        }
+        if(max_position_error > options.position_error || max_velocity_error > options.velocity_error){
+            throw std::runtime_error("The maximum errors of the positions (" + std::to_string(max_position_error) + ") and velocities (" + std::to_string(max_velocity_error) + ") exceed the bounds.\n");
+        }
+    }
+
+    const hsize_t size = storage_size(file_name);
+    std::remove(file_name.c_str());
+    std::cout << "Compression " << to_string(options.compression) << (options.compression != SnapshotCompression::none && options.shuffle ? " with shuffling" : "") << " | error bounds " << options.position_error << ", " << options.velocity_error << " | " << size << " bytes" << std::endl;
+    return size;
+}
+
+
+int main(){
+    StarSystemWriterOptions options;
+    const hsize_t uncompressed = check_write_read(options);
+
+    options.compression = SnapshotCompression::deflate;
+    const hsize_t deflated = check_write_read(options);
+    options.shuffle = false;
+    check_write_read(options);
+    options.shuffle = true;
+
+    options.compression = SnapshotCompression::szip;
+    if(filter_round_trips(H5Z_FILTER_SZIP)){
+        check_write_read(options);
+    } else {
+        std::cout << "Compression szip is not available in this HDF5 library, skipped" << std::endl;
+    }
+
+    // Errors of a thousandth of the size of the inner orbits.
+    options.compression = SnapshotCompression::deflate;
+    options.position_error = 1e-3;
+    options.velocity_error = 1e-5;
+    const hsize_t quantized = check_write_read(options);
+
+    if(deflated >= uncompressed || 3 * quantized >= uncompressed){
+        throw std::runtime_error("The compressed snapshots do not take up less space.\n");
+    }
+
+    bool threw = false;
+    try{
+        options.deflate_level = 10;
+        StarSystemWriter<body_type> writer(1, "test_compressed_write.h5", options);
+    } catch(const std::invalid_argument&){
+        threw = true;
+    }
+    if(!threw){
+        throw std::runtime_error("An invalid deflate level was accepted.\n");
+    }
+}
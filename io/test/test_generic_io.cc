@@ -0,0 +1,142 @@
+#include <array>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/star_system_reader.h"
+#include "../include/star_system_writer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector2D.h"
+#include "../../vector/include/vector3D.h"
+#include "../../vector/include/vector_traits.h"
+
+const std::string file_name = "test_generic_io.h5";
+
+
+template<typename VectorType> std::vector<StarSystem<Body<VectorType>>> write_snapshots(const SnapshotLayout layout){
+    using body_type = Body<VectorType>;
+    using numeric_type = typename body_type::numeric_type;
+    constexpr std::size_t dimension = vector_traits<VectorType>::dimension;
+    constexpr std::size_t num_bodies = 17;
+    constexpr std::size_t num_snapshots = 21;
+
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        std::array<numeric_type, dimension> pos;
+        std::array<numeric_type, dimension> vel;
+        for(std::size_t d{0}; d < dimension; ++d){
+            pos[d] = uniform(random_device);
+            vel[d] = uniform(random_device);
+        }
+        bodies[i] = body_type(vector_traits<VectorType>::make(pos), vector_traits<VectorType>::make(vel), uniform(random_device));
+    }
+    StarSystem<body_type> star_system(bodies);
+
+    StarSystemWriterOptions options;
+    options.layout = layout;
+    options.snapshots_per_write = 8;
+    options.chunk_snapshots = 8;
+    std::vector<StarSystem<body_type>> snapshots;
+    StarSystemWriter<body_type> writer(num_bodies, file_name, options);
+    for(std::size_t t{0}; t < num_snapshots; ++t){
+        snapshots.push_back(star_system);
+        writer.write_star_system(star_system, static_cast<numeric_type>(t));
+        for(std::size_t b{0}; b < num_bodies; ++b){
+            star_system.updatePosition(b, star_system.velocity(b));
+        }
+    }
+    return snapshots;
+}
+
+
+// Check that the numbers in the file are stored with the numeric type of the bodies, in little
+// endian byte order.
+template<typename VectorType> void check_file_type(const SnapshotLayout layout){
+    using numeric_type = typename VectorType::value_type;
+    hid_t file_id = H5Fopen(file_name.c_str(), H5F_ACC_RDONLY, H5P_DEFAULT);
+    hid_t dset_id = H5Dopen(file_id, layout == SnapshotLayout::rows ? DSET_NAME : POSITIONS_DSET_NAME, H5P_DEFAULT);
+    hid_t type_id = H5Dget_type(dset_id);
+    hid_t number_type_id = (layout == SnapshotLayout::rows ? H5Tcopy(type_id) : H5Tget_member_type(type_id, 0));
+    const bool matches = (H5Tget_size(number_type_id) == sizeof(numeric_type) && H5Tget_order(number_type_id) == H5T_ORDER_LE);
+    const bool vector_size_matches = (layout == SnapshotLayout::rows || H5Tget_size(type_id) == sizeof(VectorType));
+    H5Tclose(number_type_id);
+    H5Tclose(type_id);
+    H5Dclose(dset_id);
+    H5Fclose(file_id);
+    if(!matches || !vector_size_matches){
+        throw std::runtime_error("The numbers in the file are not stored as little-endian numbers of the numeric type of the bodies.\n");
+    }
+}
+
+
+template<typename VectorType> void check_write_read(const SnapshotLayout layout){
+    using body_type = Body<VectorType>;
+    using numeric_type = typename body_type::numeric_type;
+    const std::vector<StarSystem<body_type>> snapshots = write_snapshots<VectorType>(layout);
+    check_file_type<VectorType>(layout);
+
+    {
+        StarSystemReader<body_type> reader(file_name);
+        if(reader.num_timestamps() != snapshots.size() || reader.num_bodies() != snapshots[0].size()){
+            throw std::runtime_error("The reader did not find the size of the file.\n");
+        }
+        for(std::size_t t{0}; t < snapshots.size(); ++t){
+            const auto time_and_star_system = reader.at(t);
+            if(time_and_star_system.first != static_cast<numeric_type>(t) || !all_close(time_and_star_system.second, snapshots[t])){
+                throw std::runtime_error("Snapshot " + std::to_string(t) + " read from the file differs from the one written.\n");
+            }
+        }
+        const std::vector<body_type> trajectory = reader.trajectory(3, 2, 9);
+        for(std::size_t t{2}; t <= 9; ++t){
+            if(!is_close(trajectory[t - 2], body_type(snapshots[t].position(3), snapshots[t].velocity(3), snapshots[t].mass(3)))){
+                throw std::runtime_error("The trajectory read from the file differs from the one written.\n");
+            }
+        }
+    }
+    std::cout << "Checked " << vector_traits<VectorType>::dimension << "D vectors of " << sizeof(numeric_type) << " byte numbers in the " << to_string(layout) << " layout." << std::endl;
+}
+
+
+// Files in single precision can be read in double precision, but not with the wrong dimension.
+void check_conversions(const SnapshotLayout layout){
+    const auto snapshots = write_snapshots<Vector3D<float>>(layout);
+    {
+        StarSystemReader<Body<Vector3D<double>>> reader(file_name);
+        const auto time_and_star_system = reader.at(5);
+        for(std::size_t b{0}; b < snapshots[5].size(); ++b){
+            const Vector3D<float> position = snapshots[5].position(b);
+            const Vector3D<double> read = time_and_star_system.second.position(b);
+            if(read.x() != position.x() || read.y() != position.y() || read.z() != position.z()){
+                throw std::runtime_error("A single precision file read in double precision differs from the one written.\n");
+            }
+        }
+    }
+
+    bool threw = false;
+    try{
+        StarSystemReader<Body<Vector2D<float>>> reader(file_name);
+    } catch(const std::invalid_argument&){
+        threw = true;
+    }
+    if(!threw){
+        throw std::runtime_error("A file with 3D vectors was read with 2D bodies.\n");
+    }
+}
+
+
+int main(){
+    for(SnapshotLayout layout: {SnapshotLayout::rows, SnapshotLayout::columns}){
+        check_write_read<Vector2D<float>>(layout);
+        check_write_read<Vector2D<double>>(layout);
+        check_write_read<Vector3D<float>>(layout);
+        check_write_read<Vector3D<double>>(layout);
+        check_conversions(layout);
+    }
+    std::remove(file_name.c_str());
+}
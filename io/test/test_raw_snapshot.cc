@@ -0,0 +1,203 @@
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/raw_snapshot.h"
+#include "../include/star_system_reader.h"
+#include "../include/star_system_writer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/aligned_allocator.h"
+#include "../../vector/include/vector2D.h"
+#include "../../vector/include/vector3D.h"
+#include "../../vector/include/vector_traits.h"
+
+const std::string file_name = "test_raw_snapshot.bin";
+
+
+// Raw snapshots are exact copies, so the vectors should be identical.
+template<typename VectorType> bool identical(const VectorType& lhs, const VectorType& rhs){
+    for(std::size_t d{0}; d < vector_traits<VectorType>::dimension; ++d){
+        if(vector_traits<VectorType>::component(lhs, d) != vector_traits<VectorType>::component(rhs, d)){
+            return false;
+        }
+    }
+    return true;
+}
+
+
+template<typename VectorType> StarSystem<Body<VectorType>> make_star_system(const std::size_t num_bodies){
+    using body_type = Body<VectorType>;
+    using numeric_type = typename body_type::numeric_type;
+    constexpr std::size_t dimension = vector_traits<VectorType>::dimension;
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        std::array<numeric_type, dimension> pos;
+        std::array<numeric_type, dimension> vel;
+        for(std::size_t d{0}; d < dimension; ++d){
+            pos[d] = uniform(random_device);
+            vel[d] = uniform(random_device);
+        }
+        bodies[i] = body_type(vector_traits<VectorType>::make(pos), vector_traits<VectorType>::make(vel), uniform(random_device));
+    }
+    return StarSystem<body_type>(bodies);
+}
+
+
+// Write a snapshot, read it back into a star system of the wrong size and through a view, and
+// check that everything is exactly the same.
+template<typename VectorType> void check_write_read(const std::size_t num_bodies){
+    using body_type = Body<VectorType>;
+    constexpr std::size_t dimension = vector_traits<VectorType>::dimension;
+    const StarSystem<body_type> star_system = make_star_system<VectorType>(num_bodies);
+    write_raw_snapshot(file_name, star_system, 2.5);
+
+    StarSystem<body_type> read(5);
+    if(read_raw_snapshot(file_name, read) != 2.5 || read.size() != num_bodies){
+        throw std::runtime_error("The header of the snapshot was not read back.\n");
+    }
+
+    RawSnapshotView<body_type> view(file_name);
+    StarSystem<body_type> copied(0);
+    view.copy_to(copied);
+    if(view.size() != num_bodies || view.timestamp() != 2.5){
+        throw std::runtime_error("The header of the mapped snapshot is wrong.\n");
+    }
+    for(std::size_t d{0}; d < dimension; ++d){
+        for(const void* data: {static_cast<const void*>(view.positions(d)), static_cast<const void*>(view.velocities(d))}){
+            if(reinterpret_cast<std::uintptr_t>(data) % CACHE_LINE_SIZE != 0){
+                throw std::runtime_error("The arrays of the mapped snapshot are not aligned.\n");
+            }
+        }
+    }
+    for(std::size_t b{0}; b < num_bodies; ++b){
+        for(const StarSystem<body_type>* other: {&read, &copied}){
+            if(!identical(other->position(b), star_system.position(b)) || !identical(other->velocity(b), star_system.velocity(b)) || other->mass(b) != star_system.mass(b)){
+                throw std::runtime_error("Body " + std::to_string(b) + " read from the snapshot differs from the one written.\n");
+            }
+        }
+        if(!identical(view.position(b), star_system.position(b)) || !identical(view.velocity(b), star_system.velocity(b)) || view.mass(b) != star_system.mass(b)){
+            throw std::runtime_error("Body " + std::to_string(b) + " in the mapped snapshot differs from the one written.\n");
+        }
+    }
+    std::cout << "Checked " << num_bodies << " bodies with " << dimension << "D vectors of " << sizeof(typename body_type::numeric_type) << " byte numbers." << std::endl;
+}
+
+
+// Files for other bodies and truncated files are rejected.
+void check_errors(){
+    write_raw_snapshot(file_name, make_star_system<Vector3D<double>>(100), 0.);
+    for(int attempt{0}; attempt < 3; ++attempt){
+        bool threw = false;
+        try{
+            if(attempt == 0){
+                RawSnapshotView<Body<Vector2D<double>>> view(file_name);
+            } else if(attempt == 1){
+                StarSystem<Body<Vector3D<float>>> star_system(0);
+                read_raw_snapshot(file_name, star_system);
+            } else {
+                std::ifstream in(file_name, std::ios::binary);
+                std::vector<char> contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+                in.close();
+                std::ofstream out(file_name, std::ios::binary | std::ios::trunc);
+                out.write(contents.data(), contents.size() / 2);
+                out.close();
+                RawSnapshotView<Body<Vector3D<double>>> view(file_name);
+            }
+        } catch(const std::logic_error&){
+            threw = true;
+        }
+        if(!threw){
+            throw std::runtime_error("An unsuitable raw snapshot was accepted.\n");
+        }
+    }
+}
+
+
+// Replacing a snapshot leaves a view of the previous one intact, since the new snapshot is written
+// to another file that is then renamed.
+void check_replace(){
+    using body_type = Body<Vector3D<double>>;
+    const StarSystem<body_type> first = make_star_system<Vector3D<double>>(1001);
+    write_raw_snapshot(file_name, first, 1.);
+    RawSnapshotView<body_type> view(file_name);
+    write_raw_snapshot(file_name, make_star_system<Vector3D<double>>(10), 2.);
+
+    if(view.size() != first.size() || view.timestamp() != 1.){
+        throw std::runtime_error("Replacing a snapshot changed the header of a view of the previous one.\n");
+    }
+    for(std::size_t b{0}; b < first.size(); ++b){
+        if(!identical(view.position(b), first.position(b)) || !identical(view.velocity(b), first.velocity(b)) || view.mass(b) != first.mass(b)){
+            throw std::runtime_error("Replacing a snapshot changed body " + std::to_string(b) + " of a view of the previous one.\n");
+        }
+    }
+    StarSystem<body_type> replaced(0);
+    if(read_raw_snapshot(file_name, replaced) != 2. || replaced.size() != 10){
+        throw std::runtime_error("The snapshot was not replaced.\n");
+    }
+    if(std::ifstream(file_name + ".tmp")){
+        throw std::runtime_error("The temporary file of the snapshot was left behind.\n");
+    }
+}
+
+
+// Compare restarting from HDF5 with restarting from a raw snapshot.
+void time_restart(){
+    using body_type = Body<Vector3D<double>>;
+    constexpr std::size_t num_bodies = 1000000;
+    const StarSystem<body_type> star_system = make_star_system<Vector3D<double>>(num_bodies);
+    const std::string h5_file_name = "test_raw_snapshot.h5";
+    {
+        StarSystemWriter<body_type> writer(num_bodies, h5_file_name);
+        writer.write_star_system(star_system, 0.);
+    }
+    write_raw_snapshot(file_name, star_system, 0.);
+
+    StarSystem<body_type> restarted(0);
+    auto start = std::chrono::steady_clock::now();
+    {
+        StarSystemReader<body_type> reader(h5_file_name);
+        reader.at(0, restarted);
+    }
+    const std::chrono::duration<double> h5_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    read_raw_snapshot(file_name, restarted);
+    const std::chrono::duration<double> read_time = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    double total_mass = 0.;
+    {
+        RawSnapshotView<body_type> view(file_name);
+        for(std::size_t b{0}; b < view.size(); ++b){
+            total_mass += view.mass(b);
+        }
+    }
+    const std::chrono::duration<double> view_time = std::chrono::steady_clock::now() - start;
+    std::remove(h5_file_name.c_str());
+
+    std::cout << num_bodies << " bodies | HDF5 restart " << h5_time.count() * 1e3 << " ms | raw read " << read_time.count() * 1e3 << " ms | mapping and summing the masses " << view_time.count() * 1e3 << " ms (total mass " << total_mass << ")" << std::endl;
+}
+
+
+int main(){
+    check_write_read<Vector2D<float>>(1001);
+    check_write_read<Vector2D<double>>(16);
+    check_write_read<Vector3D<float>>(3);
+    check_write_read<Vector3D<double>>(1001);
+    check_write_read<Vector3D<double>>(0);
+    check_errors();
+    check_replace();
+    time_restart();
+    std::remove(file_name.c_str());
+}
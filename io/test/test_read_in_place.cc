@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/star_system_reader.h"
+#include "../include/star_system_writer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+using star_system_type = StarSystem<body_type>;
+
+
+// Read every snapshot into the same star system and compare it with the snapshot returned by
+// value. The star system starts out with the wrong size, and after the first read its arrays
+// should not be reallocated any more.
+void check_read_in_place(const std::string& file_name){
+    StarSystemReader<body_type> reader(file_name);
+    star_system_type star_system(3);
+    const double* positions = nullptr;
+    const double* masses = nullptr;
+
+    std::chrono::duration<double> by_value{0};
+    std::chrono::duration<double> in_place{0};
+    for(std::size_t t{0}; t < reader.num_timestamps(); ++t){
+        auto start = std::chrono::steady_clock::now();
+        const auto time_and_star_system = reader.at(t);
+        by_value += std::chrono::steady_clock::now() - start;
+
+        start = std::chrono::steady_clock::now();
+        const double timestamp = reader.at(t, star_system);
+        in_place += std::chrono::steady_clock::now() - start;
+
+        if(timestamp != time_and_star_system.first || !all_close(star_system, time_and_star_system.second)){
+            throw std::runtime_error("Snapshot " + std::to_string(t) + " read in place differs from the one read by value.\n");
+        }
+        if(t > 0 && (star_system.positions().data(0) != positions || star_system.masses().data() != masses)){
+            throw std::runtime_error("Reading a snapshot in place reallocated the star system.\n");
+        }
+        positions = star_system.positions().data(0);
+        masses = star_system.masses().data();
+    }
+    std::cout << to_string(reader.layout()) << " layout | " << reader.num_bodies() << " bodies | " << by_value.count() / reader.num_timestamps() * 1e3 << " ms per snapshot by value | " << in_place.count() / reader.num_timestamps() * 1e3 << " ms per snapshot in place" << std::endl;
+}
+
+
+int main(){
+    // A row of this many bodies takes up 16 MB, more than the usual stack size.
+    constexpr std::size_t num_bodies = 300000;
+    constexpr std::size_t num_snapshots = 5;
+    const std::string file_name = "test_read_in_place.h5";
+
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vel, uniform(random_device));
+    }
+    star_system_type star_system(bodies);
+
+    for(SnapshotLayout layout: {SnapshotLayout::rows, SnapshotLayout::columns}){
+        StarSystemWriterOptions options;
+        options.layout = layout;
+        options.chunk_snapshots = 1;
+        {
+            StarSystemWriter<body_type> writer(num_bodies, file_name, options);
+            for(std::size_t t{0}; t < num_snapshots; ++t){
+                writer.write_star_system(star_system, static_cast<numeric_type>(t));
+                for(std::size_t b{0}; b < num_bodies; ++b){
+                    star_system.updatePosition(b, star_system.velocity(b));
+                }
+            }
+        }
+        check_read_in_place(file_name);
+        std::remove(file_name.c_str());
+    }
+}
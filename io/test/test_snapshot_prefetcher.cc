@@ -0,0 +1,108 @@
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/snapshot_prefetcher.h"
+#include "../include/star_system_reader.h"
+#include "../include/star_system_writer.h"
+#include "../../body/include/body.h"
+#include "../../body/include/star_system.h"
+#include "../../vector/include/vector3D.h"
+
+using numeric_type = double;
+using vector_type = Vector3D<numeric_type>;
+using body_type = Body<vector_type>;
+using star_system_type = StarSystem<body_type>;
+
+
+// Walk the snapshots with a prefetcher and compare them with the snapshots that were written.
+// The consumer sleeps a little on every snapshot, so that the background thread runs ahead.
+void check_prefetch(const std::string& file_name, const std::vector<star_system_type>& snapshots, const std::size_t stride, const std::size_t read_ahead, const std::size_t first){
+    StarSystemReader<body_type> reader(file_name);
+    std::size_t expected = first;
+    std::size_t num_read = 0;
+    SnapshotPrefetcher<body_type> prefetcher(reader, stride, read_ahead, first);
+    for(const auto& snapshot: prefetcher){
+        if(snapshot.time_index != expected || snapshot.timestamp != static_cast<double>(expected) || !all_close(snapshot.star_system, snapshots[expected])){
+            throw std::runtime_error("The prefetcher returned the wrong snapshot for time index " + std::to_string(expected) + ".\n");
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        expected += stride;
+        ++num_read;
+    }
+    if(num_read != prefetcher.size() || expected < snapshots.size() || expected >= snapshots.size() + stride){
+        throw std::runtime_error("The prefetcher did not return all snapshots with stride " + std::to_string(stride) + ".\n");
+    }
+    std::cout << "Read " << num_read << " snapshots with stride " << stride << " from time index " << first << ", reading ahead " << read_ahead << "." << std::endl;
+}
+
+
+int main(){
+    constexpr std::size_t num_bodies = 100;
+    constexpr std::size_t num_snapshots = 50;
+    const std::string file_name = "test_snapshot_prefetcher.h5";
+
+    std::mt19937 random_device{0};
+    std::uniform_real_distribution<numeric_type> uniform(0., 10.);
+    std::vector<body_type> bodies(num_bodies);
+    for(std::size_t i = 0; i < num_bodies; ++i){
+        vector_type pos = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        vector_type vel = vector_type(uniform(random_device), uniform(random_device), uniform(random_device));
+        bodies[i] = body_type(pos, vel, uniform(random_device));
+    }
+    star_system_type star_system(bodies);
+
+    std::vector<star_system_type> snapshots;
+    {
+        StarSystemWriter<body_type> writer(num_bodies, file_name);
+        for(std::size_t t{0}; t < num_snapshots; ++t){
+            snapshots.push_back(star_system);
+            writer.write_star_system(star_system, static_cast<numeric_type>(t));
+            for(std::size_t b{0}; b < num_bodies; ++b){
+                star_system.updatePosition(b, star_system.velocity(b));
+            }
+        }
+    }
+
+    check_prefetch(file_name, snapshots, 1, 4, 0);
+    check_prefetch(file_name, snapshots, 1, 1, 0);
+    check_prefetch(file_name, snapshots, 3, 2, 0);
+    check_prefetch(file_name, snapshots, 7, 4, 5);
+
+    {
+        StarSystemReader<body_type> reader(file_name);
+
+        // Stopping early has to stop the background thread, which is waiting for a free slot.
+        {
+            SnapshotPrefetcher<body_type> prefetcher(reader, 1, 2);
+            auto snapshot = prefetcher.begin();
+            ++snapshot;
+            if(snapshot->time_index != 1){
+                throw std::runtime_error("The prefetcher did not advance to the next snapshot.\n");
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        // Starting past the end gives an empty range.
+        SnapshotPrefetcher<body_type> empty(reader, 1, 4, num_snapshots);
+        if(empty.size() != 0 || empty.begin() != empty.end()){
+            throw std::runtime_error("A range starting past the last snapshot is not empty.\n");
+        }
+
+        bool threw = false;
+        try{
+            SnapshotPrefetcher<body_type> invalid(reader, 0);
+        } catch(const std::invalid_argument&){
+            threw = true;
+        }
+        if(!threw){
+            throw std::runtime_error("A stride of zero was accepted.\n");
+        }
+    }
+    std::remove(file_name.c_str());
+}
@@ -29,7 +29,7 @@ int main(){
     star_system_type star_system(bodies);
     
     for(unsigned i = 0; i < 20; ++i){
-        for(body_type& body: star_system){
+        for(auto body: star_system){
             body.updatePosition({1.0, 1.0, 1.0});
             body.updateVelocity({0.1, 0.1, 0.1});
         }
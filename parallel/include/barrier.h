@@ -0,0 +1,45 @@
+// Reusable barrier for a fixed number of threads.
+#ifndef Barrier_H
+#define Barrier_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+
+class Barrier{
+
+    public:
+        Barrier(const std::size_t num_threads):
+            _num_threads(num_threads),
+            _num_waiting(0),
+            _generation(0)
+        {}
+
+        Barrier(const Barrier&) = delete;
+        Barrier(Barrier&&) = delete;
+        Barrier& operator=(const Barrier&) = delete;
+        Barrier& operator=(Barrier&&) = delete;
+
+        // Block until all threads have called wait.
+        // The barrier can be used again as soon as all threads have been released.
+        void wait(){
+            std::unique_lock<std::mutex> lock(_mutex);
+            const std::size_t generation = _generation;
+            if(++_num_waiting == _num_threads){
+                _num_waiting = 0;
+                ++_generation;
+                _condition.notify_all();
+            } else {
+                _condition.wait(lock, [this, generation]{ return generation != _generation; });
+            }
+        }
+
+    private:
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::size_t _num_threads;
+        std::size_t _num_waiting;
+        std::size_t _generation;
+};
+
+#endif
@@ -0,0 +1,64 @@
+// Multithreaded loops and sums over a range of items, such as the bodies of a star system.
+// The range is divided in blocks of a fixed size, which are distributed round-robin over the
+// threads. In sums every block is summed on its own, and the sums of the blocks are added in the
+// order of the blocks. As for ParallelDirectSumForceComputer, the order of the additions therefore
+// only depends on the block size, and the result is bit-identical for any number of threads.
+#ifndef BlockParallel_H
+#define BlockParallel_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+
+// Call process(begin, end) for every block of the items in [0, num_items).
+template<typename Process> void blockFor(
+    const std::size_t num_items,
+    Process process,
+    const std::size_t num_threads = std::thread::hardware_concurrency(),
+    const std::size_t block_size = 4096)
+{
+    const std::size_t num_blocks = (num_items + block_size - 1) / block_size;
+    auto process_blocks = [&](const std::size_t first_block, const std::size_t stride){
+        for(std::size_t b{first_block}; b < num_blocks; b += stride){
+            process(b * block_size, std::min((b + 1) * block_size, num_items));
+        }
+    };
+    const std::size_t used_threads = std::min(std::max(num_threads, std::size_t{1}), std::max(num_blocks, std::size_t{1}));
+    std::vector<std::thread> threads;
+    for(std::size_t t{1}; t < used_threads; ++t){
+        threads.emplace_back(process_blocks, t, used_threads);
+    }
+    process_blocks(0, used_threads);
+    for(auto& thread: threads){
+        thread.join();
+    }
+}
+
+
+// Sum width numbers over the items in [0, num_items) into sums. accumulate(begin, end, partial)
+// adds the terms of the items in [begin, end) to the width numbers in partial, which start at 0.
+template<typename T, typename Accumulate> void blockSum(
+    const std::size_t num_items,
+    const std::size_t width,
+    Accumulate accumulate,
+    T* sums,
+    const std::size_t num_threads = std::thread::hardware_concurrency(),
+    const std::size_t block_size = 4096)
+{
+    const std::size_t num_blocks = (num_items + block_size - 1) / block_size;
+    std::vector<T> partial_sums(num_blocks * width, T(0));
+    blockFor(num_items, [&](const std::size_t begin, const std::size_t end){
+        accumulate(begin, end, partial_sums.data() + (begin / block_size) * width);
+    }, num_threads, block_size);
+
+    std::fill(sums, sums + width, T(0));
+    for(std::size_t b{0}; b < num_blocks; ++b){
+        for(std::size_t w{0}; w < width; ++w){
+            sums[w] += partial_sums[b * width + w];
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,86 @@
+// First-in first-out queue with a fixed capacity, shared between threads.
+// A producer that pushes onto a full queue blocks until a consumer has popped an element, which
+// keeps a fast producer from running arbitrarily far ahead of a slow consumer. Closing the queue
+// releases all waiting threads: pushes fail from then on, and pops fail once the queue is empty.
+#ifndef BoundedQueue_H
+#define BoundedQueue_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+template<typename T> class BoundedQueue{
+
+    public:
+        explicit BoundedQueue(const std::size_t capacity):
+            _capacity(capacity)
+        {
+            if(capacity == 0){
+                throw std::invalid_argument("The capacity of a bounded queue must be positive.");
+            }
+        }
+
+        BoundedQueue(const BoundedQueue&) = delete;
+        BoundedQueue(BoundedQueue&&) = delete;
+        BoundedQueue& operator=(const BoundedQueue&) = delete;
+        BoundedQueue& operator=(BoundedQueue&&) = delete;
+
+        std::size_t capacity() const{ return _capacity; }
+
+        std::size_t size() const{
+            std::lock_guard<std::mutex> lock(_mutex);
+            return _elements.size();
+        }
+
+        // Append an element, blocking while the queue is full.
+        // Returns false, without appending, if the queue is closed.
+        bool push(T value){
+            std::unique_lock<std::mutex> lock(_mutex);
+            _not_full.wait(lock, [this]{ return _closed || _elements.size() < _capacity; });
+            if(_closed){
+                return false;
+            }
+            _elements.push_back(std::move(value));
+            lock.unlock();
+            _not_empty.notify_one();
+            return true;
+        }
+
+        // Remove the oldest element, blocking while the queue is empty.
+        // Returns false if the queue is closed and empty.
+        bool pop(T& value){
+            std::unique_lock<std::mutex> lock(_mutex);
+            _not_empty.wait(lock, [this]{ return _closed || !_elements.empty(); });
+            if(_elements.empty()){
+                return false;
+            }
+            value = std::move(_elements.front());
+            _elements.pop_front();
+            lock.unlock();
+            _not_full.notify_one();
+            return true;
+        }
+
+        // Elements that are already in the queue can still be popped.
+        void close(){
+            {
+                std::lock_guard<std::mutex> lock(_mutex);
+                _closed = true;
+            }
+            _not_full.notify_all();
+            _not_empty.notify_all();
+        }
+
+    private:
+        std::size_t _capacity;
+        std::deque<T> _elements;
+        bool _closed = false;
+        mutable std::mutex _mutex;
+        std::condition_variable _not_full;
+        std::condition_variable _not_empty;
+};
+
+#endif
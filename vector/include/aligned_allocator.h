@@ -0,0 +1,41 @@
+// Allocator for std::vector that aligns the storage to a cache line, so that arrays of numbers can
+// be loaded with aligned vector instructions.
+#ifndef aligned_allocator_H
+#define aligned_allocator_H
+
+#include <cstddef>
+#include <new>
+#include <vector>
+
+constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+template<typename T, std::size_t Alignment = CACHE_LINE_SIZE> class AlignedAllocator{
+
+    public:
+        using value_type = T;
+
+        template<typename U> struct rebind{ using other = AlignedAllocator<U, Alignment>; };
+
+        AlignedAllocator() = default;
+        template<typename U> AlignedAllocator(const AlignedAllocator<U, Alignment>&) {}
+
+        T* allocate(const std::size_t n){
+            return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(Alignment)));
+        }
+
+        void deallocate(T* pointer, const std::size_t){
+            ::operator delete(pointer, std::align_val_t(Alignment));
+        }
+};
+
+template<typename T, typename U, std::size_t Alignment> bool operator==(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&){
+    return true;
+}
+
+template<typename T, typename U, std::size_t Alignment> bool operator!=(const AlignedAllocator<T, Alignment>&, const AlignedAllocator<U, Alignment>&){
+    return false;
+}
+
+template<typename T> using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
+#endif
@@ -0,0 +1,61 @@
+// Array of vectors stored as a structure of arrays: one contiguous, cache line aligned array per
+// vector component. Kernels that loop over many vectors can then stream each component with
+// vector instructions.
+#ifndef vector_array_H
+#define vector_array_H
+
+#include <array>
+#include <cstddef>
+
+#include "aligned_allocator.h"
+#include "vector_traits.h"
+
+template<typename VectorType> class VectorArray{
+
+    public:
+        using value_type = typename VectorType::value_type;
+        using vector_type = VectorType;
+        static constexpr std::size_t dimension = vector_traits<VectorType>::dimension;
+
+        VectorArray() = default;
+        VectorArray(const std::size_t size){ resize(size); }
+
+        std::size_t size() const{ return _components[0].size(); }
+
+        void resize(const std::size_t size){
+            for(auto& component: _components){
+                component.resize(size);
+            }
+        }
+
+        // Vectors are gathered from and scattered to the component arrays, so no references to
+        // individual vectors can be handed out.
+        VectorType operator[](const std::size_t index) const{
+            std::array<value_type, dimension> components;
+            for(std::size_t d{0}; d < dimension; ++d){
+                components[d] = _components[d][index];
+            }
+            return vector_traits<VectorType>::make(components);
+        }
+
+        void set(const std::size_t index, const VectorType& vec){
+            for(std::size_t d{0}; d < dimension; ++d){
+                _components[d][index] = vector_traits<VectorType>::component(vec, d);
+            }
+        }
+
+        void add(const std::size_t index, const VectorType& vec){
+            for(std::size_t d{0}; d < dimension; ++d){
+                _components[d][index] += vector_traits<VectorType>::component(vec, d);
+            }
+        }
+
+        // Raw access to the array holding one component of all vectors.
+        const value_type* data(const std::size_t d) const{ return _components[d].data(); }
+        value_type* data(const std::size_t d){ return _components[d].data(); }
+
+    private:
+        std::array<aligned_vector<value_type>, dimension> _components;
+};
+
+#endif
@@ -0,0 +1,40 @@
+// Compile-time information about the vector types, so that algorithms can be written once for
+// both 2D and 3D vectors.
+#ifndef vector_traits_H
+#define vector_traits_H
+
+#include <array>
+#include <cstddef>
+
+#include "vector2D.h"
+#include "vector3D.h"
+
+template<typename T> struct vector_traits;
+
+
+template<typename T> struct vector_traits<Vector2D<T>>{
+    static constexpr std::size_t dimension = 2;
+
+    static T component(const Vector2D<T>& vec, const std::size_t d){
+        return (d == 0 ? vec.x() : vec.y());
+    }
+
+    static Vector2D<T> make(const std::array<T, dimension>& components){
+        return Vector2D<T>{components[0], components[1]};
+    }
+};
+
+
+template<typename T> struct vector_traits<Vector3D<T>>{
+    static constexpr std::size_t dimension = 3;
+
+    static T component(const Vector3D<T>& vec, const std::size_t d){
+        return (d == 0 ? vec.x() : (d == 1 ? vec.y() : vec.z()));
+    }
+
+    static Vector3D<T> make(const std::array<T, dimension>& components){
+        return Vector3D<T>{components[0], components[1], components[2]};
+    }
+};
+
+#endif